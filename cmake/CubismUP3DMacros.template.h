@@ -15,6 +15,7 @@
 #endif
 #cmakedefine CUP_DUMP_SURFACE_BINARY
 #cmakedefine CUP_SINGLE_PRECISION
+#cmakedefine CUP_POISSON_MIXED_PRECISION
 #cmakedefine CUP_HDF5_DOUBLE_PRECISION
 #cmakedefine CUP_VERBOSE
 
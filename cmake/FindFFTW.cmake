@@ -18,6 +18,8 @@
 #   FFTW_DIR              ... alternative for FFTW_ROOT, the potential `lib/`
 #                             suffix is removed (environment)
 #   FFTW_LIBRARY          ... fftw library to use
+#   FFTW_FIND_SINGLE      ... if true, the single precision libraries are
+#                             added to FFTW_LIBRARIES
 
 if (FFTW_ROOT)
     # OK.
@@ -47,6 +49,11 @@ if (FFTW_ROOT)
     find_library(FFTW_LIB2 NAMES "fftw3_omp" PATHS ${FFTW_ROOT} PATH_SUFFIXES "lib" "lib64" NO_DEFAULT_PATH)
     find_library(FFTW_LIB3 NAMES "fftw3" PATHS ${FFTW_ROOT} PATH_SUFFIXES "lib" "lib64" NO_DEFAULT_PATH)
     find_path(FFTW_INCLUDES NAMES "fftw3-mpi.h" PATHS ${FFTW_ROOT} PATH_SUFFIXES "include" NO_DEFAULT_PATH)
+    if (FFTW_FIND_SINGLE)
+        find_library(FFTWF_LIB1 NAMES "fftw3f_mpi" PATHS ${FFTW_ROOT} PATH_SUFFIXES "lib" "lib64" NO_DEFAULT_PATH)
+        find_library(FFTWF_LIB2 NAMES "fftw3f_omp" PATHS ${FFTW_ROOT} PATH_SUFFIXES "lib" "lib64" NO_DEFAULT_PATH)
+        find_library(FFTWF_LIB3 NAMES "fftw3f" PATHS ${FFTW_ROOT} PATH_SUFFIXES "lib" "lib64" NO_DEFAULT_PATH)
+    endif()
 else()
 # Determine from PKG.
     if (PKG_CONFIG_FOUND)
@@ -57,9 +64,17 @@ else()
     find_library(FFTW_LIB2 NAMES "fftw3_omp" PATHS ${PKG_FFTW_LIBRARY_DIRS} ${LIB_INSTALL_DIR})
     find_library(FFTW_LIB3 NAMES "fftw3" PATHS ${PKG_FFTW_LIBRARY_DIRS} ${LIB_INSTALL_DIR})
     find_path(FFTW_INCLUDES NAMES "fftw3-mpi.h" PATHS ${PKG_FFTW_INCLUDE_DIRS} ${INCLUDE_INSTALL_DIR})
+    if (FFTW_FIND_SINGLE)
+        find_library(FFTWF_LIB1 NAMES "fftw3f_mpi" PATHS ${PKG_FFTW_LIBRARY_DIRS} ${LIB_INSTALL_DIR})
+        find_library(FFTWF_LIB2 NAMES "fftw3f_omp" PATHS ${PKG_FFTW_LIBRARY_DIRS} ${LIB_INSTALL_DIR})
+        find_library(FFTWF_LIB3 NAMES "fftw3f" PATHS ${PKG_FFTW_LIBRARY_DIRS} ${LIB_INSTALL_DIR})
+    endif()
 endif(FFTW_ROOT)
 
 set(FFTW_LIBRARIES ${FFTW_LIB1} ${FFTW_LIB2} ${FFTW_LIB3})
+if (FFTW_FIND_SINGLE)
+    list(APPEND FFTW_LIBRARIES ${FFTWF_LIB1} ${FFTWF_LIB2} ${FFTWF_LIB3})
+endif()
 
 set( CMAKE_FIND_LIBRARY_SUFFIXES ${CMAKE_FIND_LIBRARY_SUFFIXES_SAV} )
 
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+# Strong scaling of the Poisson solvers: runs cubismup3d_poisson_bench on a
+# fixed grid for each number of ranks with the local mpirun and prints the time
+# per solve, speedup and parallel efficiency of each case and solver, e.g.
+#   ./poissonScaling.py --ranks 1 2 4 8 --args "-bpdx 16 -bpdy 16 -bpdz 16 -nu 0.001"
+import os, json, argparse, subprocess
+
+
+def run(args, ranks):
+    output = os.path.join(args.outdir, 'poisson_bench_%03d.json' % ranks)
+    cmd = [args.mpirun, '-n', str(ranks)] + args.mpiargs.split() \
+        + [args.exe] + args.args.split() \
+        + ['-benchSolvers', args.solvers, '-benchCases', args.cases,
+           '-benchReps', str(args.reps), '-benchOutput', output]
+    print(' '.join(cmd))
+    subprocess.run(cmd, check=True)
+    with open(output) as f: return json.load(f)
+
+
+def table(runs):
+    base = runs[0]
+    times = {}
+    for r in runs:
+        for s in r['solves']:
+            times.setdefault((s['case'], s['solver']), {})[r['ranks']] = s
+
+    print('\n%-5s %-10s %6s %12s %8s %8s %10s %11s' % ('case', 'solver',
+          'ranks', 'mean [s]', 'speedup', 'eff.', 'mem [MB]', 'errL2'))
+    for (case, solver), byRanks in times.items():
+        if base['ranks'] not in byRanks: continue
+        t0 = byRanks[base['ranks']]['mean']
+        for ranks in sorted(byRanks):
+            s = byRanks[ranks]
+            speedup = t0 / s['mean'] if s['mean'] > 0 else 0
+            eff = speedup * base['ranks'] / ranks
+            print('%-5s %-10s %6d %12.5e %8.2f %8.2f %10.1f %11.3e' % (case,
+                  solver, ranks, s['mean'], speedup, eff, s['memoryMB'],
+                  s['errL2']))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Poisson solvers strong scaling.')
+    parser.add_argument('--ranks', type=int, nargs='+', default=[1, 2, 4, 8])
+    parser.add_argument('--args', default='-bpdx 8 -bpdy 8 -bpdz 8 -nu 0.001',
+        help='grid arguments, the same for all runs')
+    parser.add_argument('--solvers', default='fft,multigrid,pcg,bicgstab')
+    parser.add_argument('--cases', default='ppp,pww,www,fff')
+    parser.add_argument('--reps', type=int, default=10)
+    parser.add_argument('--exe', default='../bin/cubismup3d_poisson_bench')
+    parser.add_argument('--mpirun', default='mpirun')
+    parser.add_argument('--mpiargs', default='', help='e.g. "--bind-to core"')
+    parser.add_argument('--outdir', default='.')
+    parser.add_argument('--json', default='', help='write all runs to this file')
+    args = parser.parse_args()
+
+    runs = [run(args, n) for n in sorted(args.ranks)]
+    table(runs)
+    if args.json:
+        with open(args.json, 'w') as f: json.dump(runs, f, indent=2)
@@ -14,23 +14,13 @@
 // to shift the surface where I compute gradchi for surface integrals
 // if set to value greater than 0, it shifts surface by that many mesh sizes
 #define SURFDH 1
-#include <vector> //surface vector
+#include <vector> //print buffer
+#include <algorithm> //std::max
 #include <cstring> //memset
 #include <cstdio> //print
 
 CubismUP_3D_NAMESPACE_BEGIN
 
-struct surface_data
-{
-  const int ix, iy, iz;
-  const double dchidx, dchidy, dchidz, delta;
-
-  surface_data(int _ix, int _iy, int _iz, double _dchidx, double _dchidy,
-    double _dchidz, double _delta) : ix(_ix), iy(_iy), iz(_iz),
-    dchidx(_dchidx), dchidy(_dchidy), dchidz(_dchidz), delta(_delta) {}
-  surface_data() = delete;
-};
-
 struct ObstacleBlock
 {
   static constexpr int BS = FluidBlock::BS;
@@ -44,10 +34,14 @@ struct ObstacleBlock
   Real         udef[BS][BS][BS][3];
   int sectionMarker[BS][BS][BS];
 
-  //surface quantities:
+  //surface quantities, stored as arrays in one buffer:
   int nPoints = 0;
   bool filled = false;
-  std::vector<surface_data*> surface;
+  // points as written by write(): grid indices, h^3 gradChi and Delta
+  int *surfIx = nullptr, *surfIy = nullptr, *surfIz = nullptr;
+  double *dchidx = nullptr, *dchidy = nullptr, *dchidz = nullptr;
+  double *delta = nullptr;
+  // computed by the forces kernel:
   int *ss  = nullptr;
   double *pX  = nullptr, *pY  = nullptr, *pZ  = nullptr, *P = nullptr;
   double *fX  = nullptr, *fY  = nullptr, *fZ  = nullptr;
@@ -56,6 +50,10 @@ struct ObstacleBlock
   double *vX  = nullptr, *vY  = nullptr, *vZ  = nullptr;
   double *vxDef = nullptr, *vyDef = nullptr, *vzDef = nullptr;
 
+  // kept when the block is recycled, grows with the number of points
+  double * surfaceBuffer = nullptr;
+  int surfaceCapacity = 0;
+
   //additive quantities:
   // construct CHI & center of mass interpolated on grid:
   double CoM_x = 0, CoM_y = 0, CoM_z = 0, mass = 0;
@@ -92,15 +90,10 @@ struct ObstacleBlock
     sum[k++] += pLocom;
   }
 
-  ObstacleBlock()
-  {
-    //rough estimate of surface cutting the block diagonally
-    //with 2 points needed on each side of surface
-    surface.reserve(4*BS);
-  }
+  ObstacleBlock() {}
   virtual ~ObstacleBlock()
   {
-    clear_surface();
+    free(surfaceBuffer);
   }
 
   void clear_surface()
@@ -115,73 +108,54 @@ struct ObstacleBlock
     torquex  = torquey  = torquez  =0;
     //torquex_P=torquey_P=torquez_P=0;
     //torquex_V=torquey_V=torquez_V=0;
-    mass=drag=thrust=Pout=PoutBnd=defPower=defPowerBnd=0;
-
-    for (auto & trash : surface) {
-      if(trash == nullptr) continue;
-      delete trash;
-      trash = nullptr;
-    }
-    surface.clear();
-    if(pX      not_eq nullptr){free(pX);      pX=nullptr;     }
-    if(pY      not_eq nullptr){free(pY);      pY=nullptr;     }
-    if(pZ      not_eq nullptr){free(pZ);      pZ=nullptr;     }
-    if(P       not_eq nullptr){free(P);       P=nullptr;      }
-    if(fX      not_eq nullptr){free(fX);      fX=nullptr;     }
-    if(fY      not_eq nullptr){free(fY);      fY=nullptr;     }
-    if(fZ      not_eq nullptr){free(fZ);      fZ=nullptr;     }
-    if(fxP     not_eq nullptr){free(fxP);     fxP=nullptr;    }
-    if(fyP     not_eq nullptr){free(fyP);     fyP=nullptr;    }
-    if(fzP     not_eq nullptr){free(fzP);     fzP=nullptr;    }
-    if(fxV     not_eq nullptr){free(fxV);     fxV=nullptr;    }
-    if(fyV     not_eq nullptr){free(fyV);     fyV=nullptr;    }
-    if(fzV     not_eq nullptr){free(fzV);     fzV=nullptr;    }
-    if(vX      not_eq nullptr){free(vX);      vX=nullptr;     }
-    if(vY      not_eq nullptr){free(vY);      vY=nullptr;     }
-    if(vZ      not_eq nullptr){free(vZ);      vZ=nullptr;     }
-    if(vxDef   not_eq nullptr){free(vxDef);   vxDef=nullptr;  }
-    if(vyDef   not_eq nullptr){free(vyDef);   vyDef=nullptr;  }
-    if(vzDef   not_eq nullptr){free(vzDef);   vzDef=nullptr;  }
-    if(ss      not_eq nullptr){free(ss);      ss=nullptr;     }
+    mass=drag=thrust=Pout=PoutBnd=defPower=defPowerBnd=pLocom=0;
+    // the surface arrays are kept, only overwritten by the next points
   }
 
   virtual void clear()
+  {
+    reset(true, true);
+  }
+
+  // Prepares a (possibly recycled) block to be filled again. chi and sdf are
+  // left as they are if the caller overwrites them entirely, udef and
+  // sectionMarker are only written inside the body and are always zeroed.
+  void reset(const bool zeroChi, const bool zeroSdf)
   {
     clear_surface();
-    memset(chi,  0, sizeof(Real)*sizeX*sizeY*sizeZ);
-    memset(sdf,  0, sizeof(Real)*sizeX*sizeY*sizeZ);
+    V = FX = FY = FZ = TX = TY = TZ = 0;
+    J0 = J1 = J2 = J3 = J4 = J5 = 0;
+    GfX = GpX = GpY = GpZ = Gj0 = Gj1 = Gj2 = Gj3 = Gj4 = Gj5 = 0;
+    GuX = GuY = GuZ = GaX = GaY = GaZ = 0;
+    if(zeroChi) memset(chi, 0, sizeof(Real)*sizeX*sizeY*sizeZ);
+    if(zeroSdf) memset(sdf, 0, sizeof(Real)*sizeX*sizeY*sizeZ);
     memset(udef, 0, sizeof(Real)*sizeX*sizeY*sizeZ*3);
     memset(sectionMarker, 0, sizeof(int)*sizeX*sizeY*sizeZ);
   }
 
-  inline void write(const int ix, const int iy, const int iz, const Real delta, const Real gradUX, const Real gradUY, const Real gradUZ)
+  inline void write(const int ix, const int iy, const int iz, const Real _delta, const Real gradUX, const Real gradUY, const Real gradUZ)
   {
     //if(_chi<chi[iz][iy][ix]) return;
     assert(!filled);
+    //rough estimate of surface cutting the block diagonally
+    //with 2 points needed on each side of surface
+    if(nPoints == surfaceCapacity) grow_surface(std::max(2*nPoints, 4*BS));
+    surfIx[nPoints] = ix; surfIy[nPoints] = iy; surfIz[nPoints] = iz;
+    dchidx[nPoints] = -_delta*gradUX;
+    dchidy[nPoints] = -_delta*gradUY;
+    dchidz[nPoints] = -_delta*gradUZ;
+    delta[nPoints] = _delta;
     nPoints++;
-    const double dchidx = -delta*gradUX;
-    const double dchidy = -delta*gradUY;
-    const double dchidz = -delta*gradUZ;
-    surface.push_back(new surface_data(ix,iy,iz,dchidx,dchidy,dchidz,delta));
   }
 
   void allocate_surface()
   {
     filled = true;
-    assert((int)surface.size() == nPoints);
-    assert(pX==nullptr && pY==nullptr && pZ==nullptr);
-    assert(vX==nullptr && vY==nullptr && vZ==nullptr);
-    assert(fX==nullptr && fY==nullptr && fZ==nullptr);
-    pX   =init<double>(nPoints); pY   =init<double>(nPoints);
-    pZ   =init<double>(nPoints); vX   =init<double>(nPoints);
-    vY   =init<double>(nPoints); vZ   =init<double>(nPoints);
-    fX   =init<double>(nPoints); fY   =init<double>(nPoints);
-    fZ   =init<double>(nPoints); fxP  =init<double>(nPoints);
-    fyP  =init<double>(nPoints); fzP  =init<double>(nPoints);
-    fxV  =init<double>(nPoints); fyV  =init<double>(nPoints);
-    fzV  =init<double>(nPoints); vxDef=init<double>(nPoints);
-    vyDef=init<double>(nPoints); vzDef=init<double>(nPoints);
-    P    =init<double>(nPoints); ss   =init<int>(nPoints);
+    if(nPoints == 0) return;
+    // zero the arrays computed by the forces kernel, from ss to the end
+    const size_t offset = (double*)ss - surfaceBuffer;
+    const size_t size = surfaceSize(surfaceCapacity) - offset;
+    memset(ss, 0, size * sizeof(double));
   }
 
   template <typename T>
@@ -205,16 +179,60 @@ struct ObstacleBlock
   void print(FILE* pFile)
   {
     assert(filled);
+    if(nPoints == 0) return;
+    std::vector<float> buf(16 * nPoints);
     for (int i = 0; i < nPoints; ++i) {
-      float buf[] = {
-        (float)ss[i], (float)pX[i], (float)pY[i], (float)pZ[i], (float)fX[i],
-        (float)fY[i], (float)fZ[i], (float)vY[i], (float)vY[i], (float)vZ[i],
-        (float)vxDef[i], (float)vyDef[i], (float)vzDef[i],
-        (float)surface[i]->dchidx, (float)surface[i]->dchidy,
-        (float)surface[i]->dchidz
-      };
-      fwrite (buf, sizeof(float), 16, pFile);
+      float * const b = buf.data() + 16 * i;
+      b[ 0] = ss[i];     b[ 1] = pX[i];     b[ 2] = pY[i];     b[ 3] = pZ[i];
+      b[ 4] = fX[i];     b[ 5] = fY[i];     b[ 6] = fZ[i];     b[ 7] = vY[i];
+      b[ 8] = vY[i];     b[ 9] = vZ[i];     b[10] = vxDef[i];  b[11] = vyDef[i];
+      b[12] = vzDef[i];  b[13] = dchidx[i]; b[14] = dchidy[i]; b[15] = dchidz[i];
+    }
+    fwrite(buf.data(), sizeof(float), buf.size(), pFile);
+  }
+
+private:
+  // number of doubles of surfaceBuffer for N points: the 3 index arrays, the
+  // 4 arrays of write(), then ss and the 19 arrays of the forces kernel
+  static int surfaceSize(const int N) { return 3*N/2 + 4*N + N/2 + 19*N; }
+
+  // Reallocates surfaceBuffer for N points, a multiple of 8 so that all the
+  // arrays are 32-byte aligned, keeping the points written so far.
+  void grow_surface(int N)
+  {
+    N = (N + 7) / 8 * 8;
+    double * const buffer = init<double>(surfaceSize(N));
+    int * const I = (int *) buffer;
+    double * const D = buffer + 3*N/2;
+    if(nPoints > 0) {
+      memcpy(I + 0*N, surfIx, nPoints * sizeof(int));
+      memcpy(I + 1*N, surfIy, nPoints * sizeof(int));
+      memcpy(I + 2*N, surfIz, nPoints * sizeof(int));
+      memcpy(D + 0*N, dchidx, nPoints * sizeof(double));
+      memcpy(D + 1*N, dchidy, nPoints * sizeof(double));
+      memcpy(D + 2*N, dchidz, nPoints * sizeof(double));
+      memcpy(D + 3*N, delta,  nPoints * sizeof(double));
     }
+    free(surfaceBuffer);
+    surfaceBuffer = buffer;
+    surfaceCapacity = N;
+
+    surfIx = I + 0*N; surfIy = I + 1*N; surfIz = I + 2*N;
+    double * ptr = D;
+    dchidx=ptr; ptr+=N; dchidy=ptr; ptr+=N;
+    dchidz=ptr; ptr+=N; delta =ptr; ptr+=N;
+    ss   =(int*)ptr; ptr+=N/2;
+    pX   =ptr; ptr+=N; pY   =ptr; ptr+=N;
+    pZ   =ptr; ptr+=N; vX   =ptr; ptr+=N;
+    vY   =ptr; ptr+=N; vZ   =ptr; ptr+=N;
+    fX   =ptr; ptr+=N; fY   =ptr; ptr+=N;
+    fZ   =ptr; ptr+=N; fxP  =ptr; ptr+=N;
+    fyP  =ptr; ptr+=N; fzP  =ptr; ptr+=N;
+    fxV  =ptr; ptr+=N; fyV  =ptr; ptr+=N;
+    fzV  =ptr; ptr+=N; vxDef=ptr; ptr+=N;
+    vyDef=ptr; ptr+=N; vzDef=ptr; ptr+=N;
+    P    =ptr; ptr+=N;
+    assert(ptr == surfaceBuffer + surfaceSize(N));
   }
 };
 
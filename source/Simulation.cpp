@@ -178,6 +178,8 @@ void Simulation::_init(const bool restart)
 
 void Simulation::reset()
 {
+  scheduler.drain(); // diagnostics of the old velocity
+  sim.resetVelocityExtrema(); // discard the extrema of the old velocity
   if (sim.icFromH5 != "") _icFromH5(sim.icFromH5);
   else _ic();
 
@@ -306,6 +308,7 @@ void Simulation::setupGrid(cubism::ArgumentParser *parser_ptr)
 
 void Simulation::setupOperators()
 {
+  scheduler.drain();
   sim.pipeline.clear();
   // Do not change order of operations without explicit permission from Guido
 
@@ -323,9 +326,26 @@ void Simulation::setupOperators()
   Operator *createObstacles = new CreateObstacles(sim);
   sim.pipeline.push_back(createObstacles);
 
+  // Advection-diffusion and pressure RHS can be done in one sweep if nothing
+  // in between modifies the divergence of the velocity: no obstacles, no
+  // inflow correction and only uniform forcing along a periodic direction.
+  const bool bForcing = sim.uMax_forced > 0 && sim.initCond not_eq "taylorGreen"
+                     && sim.bChannelFixedMassFlux == false;
+  const auto closedBC = [](const BCflag f) { return f==periodic || f==wall; };
+  const bool bFuseRHS = sim.bFuseAdvectionPressureRHS
+      && not sim.bUseStretchedGrid && not sim.bIterativePenalization
+      && sim.obstacle_vector->nObstacles() == 0 && sim.sgs == ""
+      && not sim.spectralForcing && (not bForcing || sim.BCx_flag == periodic)
+      && closedBC(sim.BCx_flag) && closedBC(sim.BCy_flag)
+      && closedBC(sim.BCz_flag);
+  if(sim.bFuseAdvectionPressureRHS && not bFuseRHS && sim.rank == 0)
+    printf("Warning: cannot fuse AdvectionDiffusion and PressureRHS with the "
+           "current setup, running them separately.\n");
+
   // Performs:
   // \tilde{u} = u_t + \delta t (\nu \nabla^2 u_t - (u_t \cdot \nabla) u_t )
-  sim.pipeline.push_back(new AdvectionDiffusion(sim));
+  if(bFuseRHS) sim.pipeline.push_back(new AdvectionDiffusionPressureRHS(sim));
+  else sim.pipeline.push_back(new AdvectionDiffusion(sim));
 
   if (sim.sgs != "")
     sim.pipeline.push_back(new SGS(sim));
@@ -362,7 +382,8 @@ void Simulation::setupOperators()
     // Places Udef on the grid and computes the RHS of the Poisson Eq
     // overwrites tmpU, tmpV, tmpW and pressure solver's RHS
     // places in press RHS = (1 - X) \nabla \cdot u_f
-    sim.pipeline.push_back(new PressureRHS(sim));
+    // (already done by AdvectionDiffusionPressureRHS if fused)
+    if(not bFuseRHS) sim.pipeline.push_back(new PressureRHS(sim));
 
     // Solves the Poisson Eq to get the pressure and finalizes the velocity
     // u_{t+1} = \tilde{u} -\delta t \nabla P. This is final pre-penal vel field.
@@ -394,7 +415,9 @@ void Simulation::setupOperators()
   if(sim.rank==0) {
     printf("Coordinator/Operator ordering:\n");
     for (size_t c=0; c<sim.pipeline.size(); c++)
-      printf("\t%s\n", sim.pipeline[c]->getName().c_str());
+      printf("\t%s%s\n", sim.pipeline[c]->getName().c_str(),
+        sim.bDeferDiagnostics && sim.pipeline[c]->isDiagnostic() ?
+        " (deferred)" : "");
   }
   //immediately call create!
   (*createObstacles)(0);
@@ -404,8 +427,18 @@ double Simulation::calcMaxTimestep()
 {
   assert(sim.grid not_eq nullptr);
   const double hMin = sim.hmin, CFL = sim.CFL;
-  sim.uMax_measured = sim.bKeepMomentumConstant? findMaxUzeroMom(sim)
-                                               : findMaxU(sim);
+  // max|u+uinf| is measured by the last operator of the previous step that
+  // modified the velocity. Otherwise (first step, iterative penalization)
+  // or if the velocity is modified here, sweep over the grid.
+  Real uMax = 0;
+  const bool bMeasured = sim.collectMaxU(uMax);
+  if (sim.bKeepMomentumConstant) {
+    // shifts the velocity: deferred diagnostics must see it unshifted
+    scheduler.drain();
+    uMax = findMaxUzeroMom(sim);
+  }
+  else if (not bMeasured) uMax = findMaxU(sim);
+  sim.uMax_measured = uMax;
   const double dtDif = hMin * hMin / sim.nu;
   const double dtAdv = hMin / ( sim.uMax_measured + 1e-8 );
   sim.dt = CFL * std::min(dtDif, dtAdv);
@@ -597,10 +630,10 @@ bool Simulation::timestep(const double dt)
     if (bDumpTime) sim.nextSaveTime += sim.saveTime;
     sim.bDump = (bDumpFreq || bDumpTime);
 
-    for (size_t c=0; c<sim.pipeline.size(); c++) {
-      (*sim.pipeline[c])(dt);
-      //_serialize(sim.pipeline[c]->getName()+std::to_string(sim.step));
-    }
+    scheduler.run(sim.pipeline, dt);
+    // post the reductions left pending by the operators (diagnostics, CFL),
+    // they complete at the latest in the next calcMaxTimestep
+    sim.reductions.flush();
     sim.step++;
     sim.time+=dt;
 
@@ -614,6 +647,8 @@ bool Simulation::timestep(const double dt)
     if (sim.step % 50 == 0 && sim.verbose) sim.printResetProfiler();
     if ((sim.endTime>0 && sim.time>sim.endTime) ||
         (sim.nsteps!=0 && sim.step>=sim.nsteps) ) {
+      scheduler.drain();
+      sim.reductions.wait();
       if(sim.verbose)
         std::cout<<"Finished at time "<<sim.time<<" in "<<sim.step<<" steps.\n";
       return true;  // Finished.
@@ -10,6 +10,7 @@
 #define CubismUP_3D_Simulation_h
 
 #include "SimulationData.h"
+#include "operators/OperatorScheduler.h"
 
 #include <memory>
 
@@ -32,6 +33,7 @@ public:
   SimulationData sim;
   Checkpoint *checkpointPreObstacles = nullptr;
   Checkpoint *checkpointPostVelocity = nullptr;
+  OperatorScheduler scheduler{sim};
 
   void reset();
   void _init(bool restart = false);
@@ -7,11 +7,14 @@
 //
 
 #include <unistd.h>
+#include <algorithm>
+#include <limits>
 
 #include "SimulationData.h"
 #include "operators/Operator.h"
 #include "obstacles/ObstacleVector.h"
 #include "utils/NonUniformScheme.h"
+#include "utils/TraceRecorder.h"
 
 #include <Cubism/ArgumentParser.h>
 #include <Cubism/Profiler.h>
@@ -27,6 +30,7 @@ SimulationData::SimulationData(MPI_Comm mpicomm) :
 {
   MPI_Comm_rank(app_comm, &rank);
   MPI_Comm_size(app_comm, &nprocs);
+  reductions.setComm(app_comm);
 }
 
 SimulationData::SimulationData(MPI_Comm mpicomm, ArgumentParser &parser)
@@ -70,6 +74,8 @@ SimulationData::SimulationData(MPI_Comm mpicomm, ArgumentParser &parser)
   // PIPELINE && FORCING
   freqDiagnostics = parser("-freqDiagnostics").asInt(100);
   bIterativePenalization = parser("-iterativePenalization").asBool(false);
+  penalTol = parser("-penalTol").asDouble(1e-3);
+  penalAndersonDepth = parser("-penalAnderson").asInt(0);
   bImplicitPenalization = parser("-implicitPenalization").asBool(false);
   bKeepMomentumConstant = parser("-keepMomentumConstant").asBool(false);
   bChannelFixedMassFlux = parser("-channelFixedMassFlux").asBool(false);
@@ -96,6 +102,15 @@ SimulationData::SimulationData(MPI_Comm mpicomm, ArgumentParser &parser)
   b2Ddump = parser("-dump2D").asBool(false);
   b3Ddump = parser("-dump3D").asBool(true);
 
+  // PERFORMANCE
+  bAsyncOperators = parser("-asyncOperators").asBool(false);
+  bFuseAdvectionPressureRHS = parser("-fuseAdvectionRHS").asBool(false);
+  bScalarAdvection = parser("-scalarAdvection").asBool(false);
+  bDeferDiagnostics = parser("-deferDiagnostics").asBool(false);
+  fftwWisdom = parser("-fftwWisdom").asString("");
+  greenCache = parser("-greenCache").asString("");
+  sdfCacheMaxMB = parser("-sdfCacheMaxMB").asDouble(256);
+
   // ANALYSIS
   analysis = parser("-analysis").asString("");
   timeAnalysis = parser("-tAnalysis").asDouble(0.0);
@@ -115,9 +130,18 @@ SimulationData::SimulationData(MPI_Comm mpicomm, ArgumentParser &parser)
   if (saveTime <= 0 && dumpTime > 0) saveTime = dumpTime;
 
   path4serialization = parser("-serialization").asString("./");
+  traceFile = parser("-traceFile").asString("");
+  traceCapacity = parser("-traceCapacity").asInt(100000);
 
   // INITIALIZATION: Mostly unused
   useSolver = parser("-useSolver").asString("");
+  poissonTol = parser("-poissonTol").asDouble(1e-3);
+  poissonMaxIter = parser("-poissonMaxIter").asInt(100);
+  bPoissonTolSet = parser.check("-poissonTol");
+  bPoissonMaxIterSet = parser.check("-poissonMaxIter");
+  hypreSolver = parser("-hypreSolver").asString("pcg");
+  poissonPreconditioner = parser("-poissonPrec").asString("fft");
+  bPoissonDefectCorrection = parser("-poissonDefectCorrection").asBool(false);
   // BOUNDARY CONDITIONS
   // accepted dirichlet, periodic, freespace/unbounded, fakeOpen
   std::string BC_x = parser("-BC_x").asString("dirichlet");
@@ -175,6 +199,7 @@ void SimulationData::_preprocessArguments()
 {
   assert(profiler == nullptr);  // This should not be possible at all.
   profiler = new cubism::Profiler();
+  if (traceFile != "") trace = new TraceRecorder(app_comm, traceCapacity);
 
   // Grid.
   if (bpdx < 1 || bpdy < 1 || bpdz < 1) {
@@ -248,8 +273,14 @@ void SimulationData::_preprocessArguments()
 
 SimulationData::~SimulationData()
 {
+  for (auto & stencilLabs : labPool)
+    for (LabMPI * lab : stencilLabs.second) delete lab;
   delete grid;
   delete profiler;
+  if(trace not_eq nullptr) {
+    trace->write(traceFile);
+    delete trace;
+  }
   delete obstacle_vector;
   if(nonuniform not_eq nullptr) {
     NonUniformScheme<FluidBlock>* nonuniform_ = static_cast<NonUniformScheme<FluidBlock>*>(nonuniform);
@@ -290,18 +321,98 @@ void SimulationData::setCells(const int nx, const int ny, const int nz)
   bpdz = nz / FluidBlock::sizeZ;
 }
 
+std::vector<LabMPI*>& SimulationData::getLabs(const StencilInfo& stencil,
+                                              SynchronizerMPI<Real>& Synch)
+{
+  std::vector<LabMPI*>& labs = labPool[stencil];
+  const int nthreads = omp_get_max_threads();
+  if ((int) labs.size() >= nthreads) return labs;
+
+  // First time this stencil is used (or the number of threads has grown):
+  // each thread allocates and prepares its own lab, so that the cache block
+  // is first touched by the thread that will use it.
+  labs.resize(nthreads, nullptr);
+  #pragma omp parallel for schedule(static, 1)
+  for(int i = 0; i < nthreads; ++i) {
+    if (labs[i] not_eq nullptr) continue;
+    labs[i] = new LabMPI();
+    labs[i]->setBC(BCx_flag, BCy_flag, BCz_flag);
+    labs[i]->prepare(* grid, Synch);
+  }
+  return labs;
+}
+
+void SimulationData::resetVelocityExtrema()
+{
+  // previous extrema were never collected (dt chosen by the caller): complete
+  // them now, or their callback would overwrite the new ones
+  if(bVelExtremaPosted) reductions.wait();
+  bVelExtremaPosted = false;
+  for(int i = 0; i < 6; ++i) velExtrema[i] = - std::numeric_limits<double>::max();
+}
+
+void SimulationData::accumulateVelocityExtrema(const double extrema[6])
+{
+  for(int i = 0; i < 6; ++i) velExtrema[i] = std::max(velExtrema[i], extrema[i]);
+}
+
+void SimulationData::postVelocityExtrema()
+{
+  // previous post never collected (operators driven without calcMaxTimestep):
+  // complete it, then restore the extrema its callback overwrote
+  if(bVelExtremaPosted) {
+    double local[6];
+    std::copy(velExtrema, velExtrema + 6, local);
+    reductions.wait();
+    std::copy(local, local + 6, velExtrema);
+  }
+  reductions.enqueue(velExtrema, 6, MPI_MAX, [this](const double * result) {
+    for(int i = 0; i < 6; ++i) velExtrema[i] = result[i];
+  });
+  bVelExtremaPosted = true;
+}
+
+bool SimulationData::collectMaxU(Real & maxU)
+{
+  if(not bVelExtremaPosted) return false;
+  reductions.wait();
+  bVelExtremaPosted = false;
+  // uinf may have changed after the extrema were measured
+  maxU = 0;
+  for(int i = 0; i < 3; ++i)
+    maxU = std::max({maxU, (Real) std::fabs(velExtrema[i]   + uinf[i]),
+                           (Real) std::fabs(velExtrema[i+3] - uinf[i])});
+  return true;
+}
+
 void SimulationData::startProfiler(std::string name) const
 {
   profiler->push_start(name);
+  if(trace not_eq nullptr) trace->begin(name);
 }
 void SimulationData::stopProfiler() const
 {
+  if(trace not_eq nullptr) trace->end();
   profiler->pop_stop();
 }
 void SimulationData::printResetProfiler()
 {
   profiler->printSummary();
   profiler->reset();
+  if(poissonStats.solves > 0) {
+    printf("Poisson solves: %d, iterations: %.1f avg %d max, last residual %e\n",
+           poissonStats.solves, poissonStats.iterations/(double)poissonStats.solves,
+           poissonStats.maxIterations, poissonStats.lastResidual);
+    poissonStats = PoissonStats();
+  }
+}
+
+void SimulationData::addPoissonSolve(const int iterations, const double residual) const
+{
+  poissonStats.solves++;
+  poissonStats.iterations += iterations;
+  poissonStats.maxIterations = std::max(poissonStats.maxIterations, iterations);
+  poissonStats.lastResidual = residual;
 }
 
 CubismUP_3D_NAMESPACE_END
@@ -10,12 +10,14 @@
 #define CubismUP_3D_SimulationData_h
 
 #include "Definitions.h"
+#include "utils/ReductionRegistry.h"
 #ifdef _USE_ZLIB_
 #include "SerializerIO_WaveletCompression_MPI_Simple.h"
 #endif
 //#include <Cubism/ZBinDumper_MPI.h>
 
 #include <array>
+#include <map>
 #ifdef CUP_ASYNC_DUMP
 #include <thread>
 #endif
@@ -34,6 +36,7 @@ class Operator;
 class ObstacleVector;
 class PoissonSolver;
 class SpectralManip;
+class TraceRecorder;
 
 #ifdef CUP_ASYNC_DUMP
  using DumpBlock  = BaseBlock<DumpElement>;
@@ -46,6 +49,7 @@ class SpectralManip;
 struct SimulationData
 {
   cubism::Profiler * profiler = nullptr;
+  TraceRecorder * trace = nullptr; // timeline of the profiled sections
 
   FluidGridMPI * grid = nullptr;
   void * nonuniform = nullptr;
@@ -71,6 +75,18 @@ struct SimulationData
   std::vector<Operator*> pipeline;
   PoissonSolver * pressureSolver = nullptr;
   SpectralManip * spectralManip = nullptr;
+  // Small per-step reductions (QoIs, diagnostics, CFL), batched and posted
+  // together at the end of each step or when a consumer needs them.
+  mutable ReductionRegistry reductions;
+  // Iterative Poisson solves since the last profiler summary.
+  struct PoissonStats {
+    int solves = 0, iterations = 0, maxIterations = 0;
+    double lastResidual = 0;
+  };
+  mutable PoissonStats poissonStats;
+  // Per-thread labs reused by all operators across steps, one set per stencil.
+  // Allocated and prepared on first use by `getLabs`, freed in destructor.
+  std::map<cubism::StencilInfo, std::vector<LabMPI*>> labPool;
   // simulation status
   // nsteps==0 means that this stopping criteria is not active
   int step=0, nsteps=0;
@@ -91,6 +107,11 @@ struct SimulationData
   bool bUseStretchedGrid = false;
   bool bImplicitPenalization = false;
   bool bIterativePenalization = false;
+  // iterative penalization: tolerance on the relative change of the
+  // penalization force, and history depth of the Anderson acceleration of
+  // the obstacle velocities (0 for plain fixed-point iterations)
+  Real penalTol = 1e-3;
+  int penalAndersonDepth = 0;
   Real hmin=0, hmax=0, hmean=0;
 
   // flow variables
@@ -108,6 +129,11 @@ struct SimulationData
   // forcing
   bool bChannelFixedMassFlux = false;
   Real uMax_forced = 0, uMax_measured = 0;
+  // Max of u,v,w and of -u,-v,-w of the final velocity of the step, gathered
+  // by the operators that last write it (GradP, Penalization, FixedMassFlux)
+  // and reduced in `reductions`. Consumed by `collectMaxU`.
+  double velExtrema[6] = {0, 0, 0, 0, 0, 0};
+  bool bVelExtremaPosted = false;
   bool spectralForcing = false;
   double turbKinEn_target = 0; // read from settings
   double enInjectionRate = 0; // read from settings
@@ -143,6 +169,20 @@ struct SimulationData
   int rampup = 100;
   bool verbose=false;
   bool muteAll = false;
+  // process halo blocks as their ghosts arrive and skip operator barriers
+  bool bAsyncOperators = false;
+  // compute pressure RHS in the advection-diffusion sweep where possible
+  bool bFuseAdvectionPressureRHS = false;
+  // use the reference scalar advection kernel instead of the SIMD one
+  bool bScalarAdvection = false;
+  // run diagnostic operators as late as their data dependencies allow
+  bool bDeferDiagnostics = false;
+  // path prefix of the FFTW wisdom files, see poisson/FFTWWisdom.h
+  std::string fftwWisdom = "";
+  // path prefix of the cached Green's function of PoissonSolverUnbounded
+  std::string greenCache = "";
+  // cap of the memory of the obstacle sdf caches per rank, in MB
+  double sdfCacheMaxMB = 256;
   Real fadeOutLengthU[3] = {0, 0, 0};
   Real fadeOutLengthPRHS[3] = {0, 0, 0};
 
@@ -150,7 +190,22 @@ struct SimulationData
   int saveFreq=0;
   double saveTime=0, nextSaveTime=0;
   std::string path4serialization = "./";
+  // Chrome trace of the profiled sections, written at exit if not empty
+  std::string traceFile = "";
+  int traceCapacity = 100000; // sections kept per thread
   std::string useSolver = "";
+  // iterative Poisson solvers: relative residual tolerance and max iterations
+  double poissonTol = 1e-3;
+  int poissonMaxIter = 100;
+  // whether they were given, else HYPRE keeps its per-solver defaults
+  bool bPoissonTolSet = false, bPoissonMaxIterSet = false;
+  // HYPRE solver: pcg (PFMG preconditioned), smg or gmres
+  std::string hypreSolver = "pcg";
+  // preconditioner of the pcg and bicgstab solvers: fft or multigrid
+  std::string poissonPreconditioner = "fft";
+  // CUP_POISSON_MIXED_PRECISION: refine the single precision FFT solution
+  // with one defect correction (2 more transforms, 3 for the mixed solver)
+  bool bPoissonDefectCorrection = false;
   // flags assume value 0 for dirichlet/unbounded, 1 for periodic, 2 for wall
   BCflag BCx_flag = dirichlet, BCy_flag = dirichlet, BCz_flag = dirichlet;
 
@@ -165,9 +220,18 @@ struct SimulationData
     std::thread * dumper = nullptr;
   #endif
 
+  std::vector<LabMPI*>& getLabs(const cubism::StencilInfo& stencil,
+                                cubism::SynchronizerMPI<Real>& Synch);
+  void resetVelocityExtrema();
+  void accumulateVelocityExtrema(const double extrema[6]);
+  void postVelocityExtrema();
+  // max|u+uinf| from the posted extrema; false if none was posted this step
+  bool collectMaxU(Real & maxU);
   void startProfiler(std::string name) const;
   void stopProfiler() const;
   void printResetProfiler();
+  // iterations and final (relative) residual of one iterative Poisson solve
+  void addPoissonSolve(int iterations, double residual) const;
   void _preprocessArguments();
   ~SimulationData();
   SimulationData() = delete;
@@ -0,0 +1,169 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+// Micro-benchmark of the operators of the pipeline and of the Poisson solver,
+// each one timed in isolation starting from the initial condition. Takes the
+// usual simulation arguments, which select the operators and kernels (e.g.
+// obstacles, -sgs, -useStretchedGrid, -scalarAdvection), for example
+//   cubismup3d_bench -bpdx 8 -bpdy 8 -bpdz 8 -nu 0.001 -initCond HITurbulence
+//     -factory-content "Sphere L=0.2 xpos=0.5 ypos=0.5 zpos=0.5"
+//     -benchReps 20 -benchOutput bench.json
+// Meant for a single rank, with more ranks the slowest one is reported.
+// GB/s is the effective bandwidth of the minimum memory traffic, 0 if unknown.
+
+#include "Simulation.h"
+#include "operators/Operator.h"
+#include "poisson/PoissonSolver.h"
+
+#include <Cubism/ArgumentParser.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+
+using namespace cubismup3d;
+
+namespace {
+
+struct Benchmark
+{
+  std::string name;
+  // Lower bound of the memory traffic: number of Reals per cell which have
+  // to be read or written at least once.
+  int realsPerCell;
+  std::function<void(double dt)> run;
+};
+
+struct Result
+{
+  std::string name;
+  double mean, min, cellsPerSec, GBPerSec;
+};
+
+Result timeBenchmark(SimulationData &sim, const Benchmark &b, const double dt,
+                     const int reps, const double nCells)
+{
+  b.run(dt);  // Warm-up: lab allocation, solver plans, first touch.
+  sim.reductions.wait();
+  // Penalization posts the extrema on every run, nothing collects them here.
+  sim.resetVelocityExtrema();
+
+  double sum = 0, min = HUGE_VAL;
+  for (int i = 0; i < reps; ++i) {
+    MPI_Barrier(sim.app_comm);
+    const double t0 = MPI_Wtime();
+    b.run(dt);
+    sim.reductions.wait();
+    double t = MPI_Wtime() - t0;
+    sim.resetVelocityExtrema();
+    MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, sim.app_comm);
+    sum += t;
+    min = std::min(min, t);
+  }
+  const double bytes = nCells * b.realsPerCell * sizeof(Real);
+  return Result{b.name, sum / reps, min, nCells / min, 1e-9 * bytes / min};
+}
+
+void writeJSON(const std::string &filename, const SimulationData &sim,
+               const double nCells, const int reps,
+               const std::vector<Result> &results)
+{
+  std::ofstream f(filename);
+  f.precision(8);
+  f << "{\n  \"cells\": " << (long long)nCells
+    << ",\n  \"ranks\": " << sim.nprocs
+    << ",\n  \"threads\": " << omp_get_max_threads()
+    << ",\n  \"realBytes\": " << sizeof(Real)
+    << ",\n  \"blockSize\": [" << FluidBlock::sizeX << ", " << FluidBlock::sizeY
+    << ", " << FluidBlock::sizeZ << "]"
+    << ",\n  \"stretchedGrid\": " << (sim.bUseStretchedGrid ? "true" : "false")
+    << ",\n  \"reps\": " << reps
+    << ",\n  \"kernels\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    f << "    {\"name\": \"" << r.name << "\", \"mean\": " << r.mean
+      << ", \"min\": " << r.min << ", \"cellsPerSec\": " << r.cellsPerSec
+      << ", \"GBPerSec\": " << r.GBPerSec << "}"
+      << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  f << "  ]\n}\n";
+}
+
+}  // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+  if (provided < MPI_THREAD_FUNNELED) {
+    printf("ERROR: MPI implementation does not have required thread support\n");
+    fflush(0); MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  cubism::ArgumentParser parser(argc, argv);
+  const int reps = parser("-benchReps").asInt(10);
+  const std::string output = parser("-benchOutput").asString("bench.json");
+
+  Simulation *S = new Simulation(MPI_COMM_WORLD, parser);
+  SimulationData &sim = S->sim;
+  sim.freqDiagnostics = 1;  // Otherwise ComputeDissipation does nothing.
+  sim.verbose = false;
+  const double dt = S->calcMaxTimestep();
+  const double nCells = (double)sim.bpdx * FluidBlock::sizeX
+                      * (double)sim.bpdy * FluidBlock::sizeY
+                      * (double)sim.bpdz * FluidBlock::sizeZ;
+  if (sim.rank == 0 && sim.nprocs > 1)
+    printf("Warning: benchmarking on %d ranks, reporting the slowest.\n",
+           sim.nprocs);
+
+  // The operators of the pipeline, as configured by the arguments. Lower
+  // bound of the memory traffic, Reals per cell read or written at least once:
+  const std::map<std::string, int> realsPerCell = {
+    {"AdvectionDiffusion", 12},             // u,v,w -> tmp -> u,v,w
+    {"AdvectionDiffusionPressureRHS", 13},  // same, and the RHS
+    {"SGS", 12},
+    {"ExternalForcing", 2},                 // u -> u
+    {"PressureRHS", 5},                     // chi,u,v,w -> RHS
+    {"PressureProjection", 9},              // solve, p,u,v,w -> u,v,w
+    {"CreateObstacles", 3},                 // sdf -> chi, tmpU reset
+    {"UpdateObstacles Vel", 4},             // chi,u,v,w
+    {"Penalization", 7},                    // chi,u,v,w -> u,v,w
+    {"ComputeForces", 5},                   // u,v,w,p near the surfaces
+    {"Dissipation", 5},                     // chi,u,v,w,p
+  };
+  std::vector<Benchmark> benchmarks;
+  for (Operator *op : sim.pipeline) {
+    const std::string name = op->getName();
+    if (name.compare(0, 10, "Checkpoint") == 0) continue;
+    const auto it = realsPerCell.find(name);
+    benchmarks.push_back(Benchmark{name,
+        it == realsPerCell.end() ? 0 : it->second, std::ref(*op)});
+  }
+  if (sim.pressureSolver != nullptr)  // The solve alone, on the current RHS.
+    benchmarks.push_back(Benchmark{"PoissonSolver", 2,
+        [&sim](double) { sim.pressureSolver->solve(); }});
+
+  std::vector<Result> results;
+  for (const Benchmark &b : benchmarks)
+    results.push_back(timeBenchmark(sim, b, dt, reps, nCells));
+
+  if (sim.rank == 0) {
+    printf("%-30s %12s %12s %14s %10s\n",
+           "operator", "mean [s]", "min [s]", "cells/s", "GB/s");
+    for (const Result &r : results)
+      printf("%-30s %12.5e %12.5e %14.5e %10.3f\n",
+             r.name.c_str(), r.mean, r.min, r.cellsPerSec, r.GBPerSec);
+    writeJSON(output, sim, nCells, reps, results);
+    printf("Results written to %s.\n", output.c_str());
+  }
+
+  delete S;
+  MPI_Finalize();
+  return 0;
+}
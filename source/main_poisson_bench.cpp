@@ -0,0 +1,365 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+// Verification and timing of the Poisson solvers on manufactured solutions.
+// For every combination of periodic and wall (zero-gradient) boundaries, and
+// for free space, the right-hand side of a known pressure is given to each
+// available solver, which reports the error, the time per solve, the
+// iterations and the memory high-water mark. Takes the usual grid arguments:
+//   cubismup3d_poisson_bench -bpdx 8 -bpdy 8 -bpdz 8 -nu 0.001
+//     -benchSolvers fft,multigrid,pcg -benchCases ppp,www,fff
+//     -benchReps 10 -benchOutput poisson_bench.json
+// Cases name the BCs along x, y, z: p periodic, w wall, f free space.
+// Solvers: fft (the FFT solver that PressureProjection picks for the BCs),
+// multigrid, pcg, bicgstab, hypre and petsc (if compiled in).
+// Timed solves alternate the sign of the right-hand side, so that iterative
+// solvers do not start from the solution. The error is measured on the first,
+// cold, solve. launch/poissonScaling.py runs it on several rank counts.
+
+#include "Simulation.h"
+#include "poisson/PoissonSolver.h"
+#ifdef _ACCFFT_
+#include "poisson/PoissonSolverACCPeriodic.h"
+#include "poisson/PoissonSolverACCUnbounded.h"
+#else
+#include "poisson/PoissonSolverPeriodic.h"
+#include "poisson/PoissonSolverUnbounded.h"
+#include "poisson/PoissonSolverMixedPencil.h"
+#include "poisson/PoissonSolverUnboundedPencil.h"
+#endif
+#include "poisson/PoissonSolverMixed.h"
+#include "poisson/PoissonSolverHYPREMixed.h"
+#include "poisson/PoissonSolverPETSCMixed.h"
+#include "poisson/PoissonSolverMultigrid.h"
+#include "poisson/PoissonSolverKrylov.h"
+
+#include <Cubism/ArgumentParser.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+using namespace cubismup3d;
+using namespace cubism;
+
+namespace {
+
+struct Result
+{
+  std::string caseName, solver;
+  double errL2, errLinf, mean, min, iterations, memoryMB;
+};
+
+std::vector<std::string> split(const std::string &list)
+{
+  std::vector<std::string> out;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (not item.empty()) out.push_back(item);
+  return out;
+}
+
+// Memory of the process from /proc/self/status, in kB, 0 if unavailable.
+double readStatus(const char *key)
+{
+  std::ifstream f("/proc/self/status");
+  std::string line;
+  while (std::getline(f, line))
+    if (line.compare(0, strlen(key), key) == 0)
+      return std::atof(line.c_str() + strlen(key));
+  return 0;
+}
+
+// Reset the high-water mark of the resident set to the current one (Linux).
+void resetPeakMemory()
+{
+  std::ofstream f("/proc/self/clear_refs");
+  if (f) f << "5";
+}
+
+// Manufactured pressure and its Laplacian. Periodic directions take a full
+// cosine, wall directions a half cosine with zero gradient at the faces, free
+// space the potential of a Gaussian charge in the middle of the domain.
+struct Manufactured
+{
+  bool freespace = false;
+  double k[3], L[3], sigma;
+
+  Manufactured(const SimulationData &sim)
+  {
+    const BCflag BC[3] = {sim.BCx_flag, sim.BCy_flag, sim.BCz_flag};
+    for (int d = 0; d < 3; ++d) {
+      L[d] = sim.extent[d];
+      k[d] = (BC[d] == periodic ? 2 : 1) * M_PI / L[d];
+    }
+    freespace = sim.bUseUnboundedBC;
+    sigma = std::min({L[0], L[1], L[2]}) / 12;
+  }
+
+  double radius(const Real x[3]) const
+  {
+    const double dx = x[0] - L[0]/2, dy = x[1] - L[1]/2, dz = x[2] - L[2]/2;
+    return std::sqrt(dx*dx + dy*dy + dz*dz);
+  }
+
+  double p(const Real x[3]) const
+  {
+    if (freespace) {
+      const double r = std::max(radius(x), 1e-12 * sigma);
+      return - std::erf(r / (std::sqrt(2.0) * sigma)) / (4 * M_PI * r);
+    }
+    return std::cos(k[0] * x[0]) * std::cos(k[1] * x[1]) * std::cos(k[2] * x[2]);
+  }
+
+  double f(const Real x[3]) const
+  {
+    if (freespace) {
+      const double r = radius(x);
+      return std::exp(-r*r / (2*sigma*sigma)) / std::pow(2*M_PI*sigma*sigma, 1.5);
+    }
+    return - (k[0]*k[0] + k[1]*k[1] + k[2]*k[2]) * p(x);
+  }
+};
+
+// The solver `name` for the BCs of `sim`, nullptr if it does not apply.
+PoissonSolver * makeSolver(SimulationData &sim, const std::string &name)
+{
+  sim.useSolver = name;  // read by the solvers which have variants
+  #ifndef _ACCFFT_
+  // FFTW slab solvers need the ranks to be split along x only, the pencil
+  // solvers along x and y
+  const bool bPencils = sim.nprocsy > 1;
+  #endif
+  if (name == "fft") {
+    #ifdef _ACCFFT_
+    if (sim.bUseFourierBC) return new PoissonSolverPeriodic(sim);
+    if (sim.bUseUnboundedBC) return new PoissonSolverUnbounded(sim);
+    #else
+    if (sim.bUseUnboundedBC)
+      return bPencils ? (PoissonSolver*) new PoissonSolverUnboundedPencil(sim)
+                      : (PoissonSolver*) new PoissonSolverUnbounded(sim);
+    if (sim.bUseFourierBC && not bPencils) return new PoissonSolverPeriodic(sim);
+    if (bPencils) return new PoissonSolverMixedPencil(sim);
+    #endif
+    return new PoissonSolverMixed(sim);
+  }
+  if (sim.bUseUnboundedBC) return nullptr;
+  if (name == "multigrid") return new PoissonSolverMultigrid(sim);
+  if (name == "pcg" || name == "bicgstab") return new PoissonSolverKrylov(sim);
+  #ifdef CUP_HYPRE
+  if (name == "hypre") return new PoissonSolverMixed_HYPRE(sim);
+  #endif
+  #ifdef CUP_PETSC
+  if (name == "petsc") return new PoissonSolverMixed_PETSC(sim);
+  #endif
+  return nullptr;
+}
+
+// Right-hand side of the manufactured solution, in the solver buffer.
+void setRHS(const SimulationData &sim, PoissonSolver &solver,
+            const Manufactured &M)
+{
+  const std::vector<BlockInfo> &vInfo = sim.vInfo();
+  solver.reset();
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < vInfo.size(); ++i) {
+    const size_t offset = solver._offset_ext(vInfo[i]);
+    for (int iz = 0; iz < FluidBlock::sizeZ; ++iz)
+    for (int iy = 0; iy < FluidBlock::sizeY; ++iy)
+    for (int ix = 0; ix < FluidBlock::sizeX; ++ix) {
+      Real x[3], h[3];
+      vInfo[i].pos(x, ix, iy, iz);
+      vInfo[i].spacing(h, ix, iy, iz);
+      solver.data[solver._dest(offset, iz, iy, ix)] = h[0]*h[1]*h[2] * M.f(x);
+    }
+  }
+}
+
+// Relative L2 and max norms of the error of the solution in the solver
+// buffer, up to a constant unless in free space.
+void computeError(const SimulationData &sim, const PoissonSolver &solver,
+                  const Manufactured &M, double &errL2, double &errLinf)
+{
+  const std::vector<BlockInfo> &vInfo = sim.vInfo();
+  // sum of the error, of its square, of p^2, and number of cells
+  double sums[4] = {0, 0, 0, 0}, maxs[2] = {0, 0};
+  for (int pass = 0; pass < 2; ++pass) {
+    const double shift = pass == 0 || M.freespace ? 0 : sums[0] / sums[3];
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0, m0 = 0, m1 = 0;
+    #pragma omp parallel for schedule(static) \
+        reduction(+ : s0, s1, s2, s3) reduction(max : m0, m1)
+    for (size_t i = 0; i < vInfo.size(); ++i) {
+      const size_t offset = solver._offset_ext(vInfo[i]);
+      for (int iz = 0; iz < FluidBlock::sizeZ; ++iz)
+      for (int iy = 0; iy < FluidBlock::sizeY; ++iy)
+      for (int ix = 0; ix < FluidBlock::sizeX; ++ix) {
+        Real x[3];
+        vInfo[i].pos(x, ix, iy, iz);
+        const double exact = M.p(x);
+        const double err = solver.data[solver._dest(offset, iz, iy, ix)]
+                         - exact - shift;
+        s0 += err; s1 += err * err; s2 += exact * exact; s3 += 1;
+        m0 = std::max(m0, std::fabs(err));
+        m1 = std::max(m1, std::fabs(exact));
+      }
+    }
+    sums[0] = s0; sums[1] = s1; sums[2] = s2; sums[3] = s3;
+    maxs[0] = m0; maxs[1] = m1;
+    MPI_Allreduce(MPI_IN_PLACE, sums, 4, MPI_DOUBLE, MPI_SUM, sim.app_comm);
+    MPI_Allreduce(MPI_IN_PLACE, maxs, 2, MPI_DOUBLE, MPI_MAX, sim.app_comm);
+  }
+  errL2 = std::sqrt(sums[1] / std::max(sums[2], 1e-300));
+  errLinf = maxs[0] / std::max(maxs[1], 1e-300);
+}
+
+Result benchSolver(SimulationData &sim, const std::string &caseName,
+                   const std::string &name, const int reps)
+{
+  resetPeakMemory();
+  const double rss0 = readStatus("VmRSS:");
+  std::unique_ptr<PoissonSolver> solver(makeSolver(sim, name));
+  if (solver == nullptr) return Result{caseName, name, -1, -1, 0, 0, 0, 0};
+
+  const Manufactured M(sim);
+  setRHS(sim, *solver, M);
+  std::vector<Real> rhs(solver->data, solver->data + solver->data_size);
+  solver->solve();
+  Result r{caseName, name, 0, 0, 0, HUGE_VAL, 0, 0};
+  computeError(sim, *solver, M, r.errL2, r.errLinf);
+
+  sim.poissonStats = SimulationData::PoissonStats();
+  for (int i = 0; i < reps; ++i) {
+    const Real sign = i % 2 ? 1 : -1;
+    #pragma omp parallel for schedule(static)
+    for (size_t j = 0; j < rhs.size(); ++j) solver->data[j] = sign * rhs[j];
+    MPI_Barrier(sim.app_comm);
+    const double t0 = MPI_Wtime();
+    solver->solve();
+    double t = MPI_Wtime() - t0;
+    MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, sim.app_comm);
+    r.mean += t / reps;
+    r.min = std::min(r.min, t);
+  }
+  if (sim.poissonStats.solves > 0)
+    r.iterations = sim.poissonStats.iterations / (double)sim.poissonStats.solves;
+
+  double memory = std::max(readStatus("VmHWM:") - rss0, 0.0) / 1024;
+  MPI_Allreduce(MPI_IN_PLACE, &memory, 1, MPI_DOUBLE, MPI_MAX, sim.app_comm);
+  r.memoryMB = memory;
+  return r;
+}
+
+void writeJSON(const std::string &filename, const int nprocs,
+               const bool bStretched, const double nCells, const int reps,
+               const std::vector<Result> &results)
+{
+  std::ofstream f(filename);
+  f.precision(8);
+  f << "{\n  \"cells\": " << (long long)nCells
+    << ",\n  \"ranks\": " << nprocs
+    << ",\n  \"threads\": " << omp_get_max_threads()
+    << ",\n  \"realBytes\": " << sizeof(Real)
+    << ",\n  \"stretchedGrid\": " << (bStretched ? "true" : "false")
+    << ",\n  \"reps\": " << reps
+    << ",\n  \"solves\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    f << "    {\"case\": \"" << r.caseName << "\", \"solver\": \"" << r.solver
+      << "\", \"errL2\": " << r.errL2 << ", \"errLinf\": " << r.errLinf
+      << ", \"mean\": " << r.mean << ", \"min\": " << r.min
+      << ", \"iterations\": " << r.iterations
+      << ", \"memoryMB\": " << r.memoryMB << "}"
+      << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  f << "  ]\n}\n";
+}
+
+}  // anonymous namespace
+
+int main(int argc, char **argv)
+{
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+  if (provided < MPI_THREAD_FUNNELED) {
+    printf("ERROR: MPI implementation does not have required thread support\n");
+    fflush(0); MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  ArgumentParser parser(argc, argv);
+  const int reps = parser("-benchReps").asInt(10);
+  const std::string output = parser("-benchOutput").asString("poisson_bench.json");
+  const std::vector<std::string> solvers = split(parser("-benchSolvers")
+    .asString("fft,multigrid,pcg,bicgstab,hypre,petsc"));
+  const std::vector<std::string> cases = split(parser("-benchCases")
+    .asString("ppp,ppw,pwp,pww,wpp,wpw,wwp,www,fff"));
+
+  // The simulation arguments without the BCs, which are set by each case.
+  std::vector<std::string> args;
+  for (int i = 0; i < argc; ++i) {
+    if (i > 0 && strncmp(argv[i], "-BC_", 4) == 0) { ++i; continue; }
+    args.push_back(argv[i]);
+  }
+
+  std::vector<Result> results;
+  double nCells = 0;
+  bool bStretched = false;
+  for (const std::string &c : cases)
+  {
+    if (c.size() != 3 || c.find_first_not_of("pwf") != std::string::npos
+        || (c.find('f') != std::string::npos && c != "fff")) {
+      fprintf(stderr, "Invalid case %s: p, w or f along x, y, z, f for all or none.\n", c.c_str());
+      fflush(0); MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    std::vector<std::string> caseArgs = args;
+    const char *dirs[3] = {"-BC_x", "-BC_y", "-BC_z"};
+    for (int d = 0; d < 3; ++d) {
+      caseArgs.push_back(dirs[d]);
+      caseArgs.push_back(c[d] == 'p' ? "periodic" : c[d] == 'w' ? "wall" : "freespace");
+    }
+    std::vector<char*> caseArgv;
+    for (std::string &a : caseArgs) caseArgv.push_back(&a[0]);
+    caseArgv.push_back(nullptr);
+    ArgumentParser caseParser((int) caseArgs.size(), caseArgv.data());
+
+    Simulation *S = new Simulation(MPI_COMM_WORLD, caseParser);
+    SimulationData &sim = S->sim;
+    sim.verbose = false;
+    nCells = (double)sim.bpdx * FluidBlock::sizeX
+           * (double)sim.bpdy * FluidBlock::sizeY
+           * (double)sim.bpdz * FluidBlock::sizeZ;
+    bStretched = sim.bUseStretchedGrid;
+    if (sim.bUseUnboundedBC && sim.bUseStretchedGrid) {
+      if (sim.rank == 0) printf("Skipping %s: free space needs a uniform grid.\n", c.c_str());
+      delete S;
+      continue;
+    }
+    for (const std::string &s : solvers) {
+      const Result r = benchSolver(sim, c, s, reps);
+      if (r.errL2 >= 0) results.push_back(r);
+    }
+    delete S;
+  }
+
+  int rank, nprocs;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+  if (rank == 0) {
+    printf("%-5s %-10s %11s %11s %12s %12s %7s %10s\n", "case", "solver",
+           "errL2", "errLinf", "mean [s]", "min [s]", "iters", "mem [MB]");
+    for (const Result &r : results)
+      printf("%-5s %-10s %11.3e %11.3e %12.5e %12.5e %7.1f %10.1f\n",
+             r.caseName.c_str(), r.solver.c_str(), r.errL2, r.errLinf,
+             r.mean, r.min, r.iterations, r.memoryMB);
+    writeJSON(output, nprocs, bStretched, nCells, reps, results);
+    printf("Results written to %s.\n", output.c_str());
+  }
+  MPI_Finalize();
+  return 0;
+}
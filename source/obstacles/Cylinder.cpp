@@ -133,16 +133,17 @@ void Cylinder::_init(void)
 void Cylinder::create()
 {
   const Real h = sim.maxH();
+  const Real bound = std::sqrt(radius*radius + halflength*halflength);
   if(section == "D")
   {
     const DCylinderObstacle::FillBlocks kernel(radius, halflength, _2Dangle,
                                                h, position);
-    create_base<DCylinderObstacle::FillBlocks>(kernel);
+    create_base_rigid<DCylinderObstacle::FillBlocks>(kernel, bound, false);
   }
   else /* else do square section, but figure how to make code smaller */
   {    /* else normal cylinder */
     const CylinderObstacle::FillBlocks kernel(radius, halflength, h, position);
-    create_base<CylinderObstacle::FillBlocks>(kernel);
+    create_base_rigid<CylinderObstacle::FillBlocks>(kernel, bound, false);
   }
 }
 
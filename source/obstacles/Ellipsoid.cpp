@@ -331,7 +331,8 @@ void Ellipsoid::create()
   const Real h = sim.maxH();
   const EllipsoidObstacle::FillBlocks K(e0,e1,e2, h, position, quaternion);
 
-  create_base<EllipsoidObstacle::FillBlocks>(K);
+  create_base_rigid<EllipsoidObstacle::FillBlocks>(K, std::max({e0,e1,e2}),
+                                                 true);
 }
 
 void Ellipsoid::finalize()
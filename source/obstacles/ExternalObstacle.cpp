@@ -101,10 +101,9 @@ void ExternalObstacle::create()
 
   const std::vector<cubism::BlockInfo>& vInfo = sim.vInfo();
   #pragma omp parallel for schedule(dynamic, 1)
-  for (int i = 0; i < (int)vInfo.size(); ++i) {
-    const BlockInfo &info = vInfo[i];
-    if (obstacleBlocks[info.blockID] == nullptr) continue;
-    kernel.setVelocity(info, obstacleBlocks[info.blockID]);
+  for (size_t i = 0; i < obstacleBlockList.size(); ++i) {
+    const ObstacleBlockRef &entry = obstacleBlockList[i];
+    kernel.setVelocity(vInfo[entry.blockID], entry.block);
   }
 }
 
@@ -12,6 +12,8 @@
 #include <Cubism/ArgumentParser.h>
 #include <Cubism/HDF5Dumper_MPI.h>
 
+#include <algorithm>
+
 CubismUP_3D_NAMESPACE_BEGIN
 using namespace cubism;
 
@@ -125,37 +127,15 @@ using intersect_t = std::vector<std::vector<VolumeSegment_OBB*>>;
 intersect_t Fish::prepare_segPerBlock(vecsegm_t& vSegments)
 {
   const std::vector<cubism::BlockInfo>& vInfo = sim.vInfo();
-  std::vector<std::vector<VolumeSegment_OBB*>> ret(vInfo.size());
-
-  // clear deformation velocities
-  for(auto & entry : obstacleBlocks) {
-    if(entry == nullptr) continue;
-    delete entry;
-    entry = nullptr;
-  }
-  obstacleBlocks.resize(vInfo.size(), nullptr);
+  // recycle the blocks of the previous step
+  releaseObstacleBlocks();
 
-  #pragma omp parallel for schedule(dynamic, 1)
-  for(size_t i=0; i<vInfo.size(); ++i)
-  {
-    const BlockInfo & info = vInfo[i];
-    const FluidBlock & b = *(FluidBlock*)info.ptrBlock;
-
-    for(size_t s=0; s<vSegments.size(); ++s)
-      if(vSegments[s].isIntersectingWithAABB(b.min_pos.data(), b.max_pos.data())) {
-        VolumeSegment_OBB*const ptr  = & vSegments[s];
-        ret[info.blockID].push_back( ptr );
-      }
+  intersect_t ret = findSegmentsPerBlock(vInfo, vSegments);
+  std::vector<char> touching(vInfo.size(), 0);
+  for(size_t i=0; i<vInfo.size(); ++i) touching[i] = not ret[i].empty();
 
-    // allocate new blocks if necessary
-    if( ret[info.blockID].size() > 0 ) {
-      assert( obstacleBlocks[info.blockID] == nullptr );
-      ObstacleBlock * const block = new ObstacleBlock();
-      assert(block not_eq nullptr);
-      obstacleBlocks[info.blockID] = block;
-      block->clear();
-    }
-  }
+  // PutFishOnBlocks overwrites the whole sdf, chi is used to accumulate udef
+  acquireObstacleBlocks(touching, true, false);
   return ret;
 }
 
@@ -166,20 +146,16 @@ void Fish::writeSDFOnBlocks(const intersect_t& segmentsPerBlock)
   {
     PutFishOnBlocks putfish(myFish, position, quaternion);
 
+    // only the blocks intersected by a segment have been allocated
     #pragma omp for schedule(dynamic, 1)
-    for(size_t i=0; i<vInfo.size(); i++)
+    for(size_t i=0; i<obstacleBlockList.size(); i++)
     {
-      const BlockInfo info = vInfo[i];
-      const std::vector<VolumeSegment_OBB*>& S = segmentsPerBlock[info.blockID];
+      const ObstacleBlockRef& entry = obstacleBlockList[i];
+      const BlockInfo info = vInfo[entry.blockID];
+      const std::vector<VolumeSegment_OBB*>& S = segmentsPerBlock[entry.blockID];
       FluidBlock& b = *(FluidBlock*)info.ptrBlock;
-
-      if(S.size() > 0)
-      {
-        assert(obstacleBlocks[info.blockID] not_eq nullptr);
-        ObstacleBlock*const block = obstacleBlocks[info.blockID];
-        putfish(info, b, block, S);
-      }
-      else assert(obstacleBlocks[info.blockID] == nullptr);
+      assert(S.size() > 0);
+      putfish(info, b, entry.block, S);
     }
   }
 
@@ -8,6 +8,9 @@
 
 #include "FishLibrary.h"
 
+#include <algorithm>
+#include <omp.h>
+
 CubismUP_3D_NAMESPACE_BEGIN
 using namespace cubism;
 
@@ -246,6 +249,116 @@ void FishMidlineData::surfaceToComputationalFrame(const double theta_comp, const
   }
 }
 
+namespace {
+
+// The blocks of the rank form a box of nx*ny*nz blocks, with bounds along each
+// axis that increase with the block index (also for stretched grids). Finds
+// the blocks whose bounds overlap a box with two binary searches per axis.
+struct LocalBlockLattice
+{
+  int n[3] = {0, 0, 0}, start[3] = {0, 0, 0};
+  std::vector<Real> lo[3], hi[3];  // min_pos and max_pos of each index
+  std::vector<int> id;  // position in vInfo of each block, or -1
+
+  LocalBlockLattice(const std::vector<BlockInfo>& vInfo)
+  {
+    if(vInfo.empty()) return;
+    int end[3];
+    for(int a=0; a<3; ++a) start[a] = end[a] = vInfo[0].index[a];
+    for(const BlockInfo& info : vInfo)
+      for(int a=0; a<3; ++a) {
+        start[a] = std::min(start[a], info.index[a]);
+        end[a] = std::max(end[a], info.index[a] + 1);
+      }
+    for(int a=0; a<3; ++a) {
+      n[a] = end[a] - start[a];
+      lo[a].resize(n[a]);
+      hi[a].resize(n[a]);
+    }
+    id.assign((size_t)n[0]*n[1]*n[2], -1);
+    for(size_t i=0; i<vInfo.size(); ++i) {
+      const FluidBlock& b = *(FluidBlock*)vInfo[i].ptrBlock;
+      int k[3];
+      for(int a=0; a<3; ++a) {
+        k[a] = vInfo[i].index[a] - start[a];
+        lo[a][k[a]] = b.min_pos[a];
+        hi[a][k[a]] = b.max_pos[a];
+      }
+      id[k[0] + (size_t)n[0]*(k[1] + (size_t)n[1]*k[2])] = i;
+    }
+  }
+
+  // Range [first, last) of the indices along axis a overlapping [low, high].
+  void range(const int a, const Real low, const Real high, int& first,
+             int& last) const
+  {
+    first = std::lower_bound(hi[a].begin(), hi[a].end(), low) - hi[a].begin();
+    last = std::upper_bound(lo[a].begin(), lo[a].end(), high) - lo[a].begin();
+  }
+
+  bool isEmpty() const { return id.empty(); }
+};
+
+}  // namespace (empty)
+
+std::vector<std::vector<VolumeSegment_OBB*>> findSegmentsPerBlock(
+    const std::vector<BlockInfo>& vInfo, std::vector<VolumeSegment_OBB>& vSegments)
+{
+  std::vector<std::vector<VolumeSegment_OBB*>> ret(vInfo.size());
+
+  // Broad phase: only the blocks overlapping the lab-frame box of a segment,
+  // grown by the safe distance like in isIntersectingWithAABB, are tested.
+  const LocalBlockLattice lattice(vInfo);
+  Real fishBox[3][2] = {{1e9, -1e9}, {1e9, -1e9}, {1e9, -1e9}};
+  for(size_t s=0; s<vSegments.size(); ++s)
+    for(int a=0; a<3; ++a) {
+      const Real safe = 1.001 * vSegments[s].safe_distance;
+      fishBox[a][0] = std::min(fishBox[a][0], vSegments[s].objBoxLabFr[a][0] - safe);
+      fishBox[a][1] = std::max(fishBox[a][1], vSegments[s].objBoxLabFr[a][1] + safe);
+    }
+  bool bTouchesRank = not lattice.isEmpty();
+  for(int a=0; a<3 && bTouchesRank; ++a)
+    bTouchesRank = fishBox[a][1] >= lattice.lo[a].front()
+                && fishBox[a][0] <= lattice.hi[a].back();
+  if(not bTouchesRank) return ret;
+
+  // (block, segment) pairs found by each thread
+  std::vector<std::vector<std::pair<int, int>>> hits(omp_get_max_threads());
+  #pragma omp parallel
+  {
+    std::vector<std::pair<int, int>>& myHits = hits[omp_get_thread_num()];
+    #pragma omp for schedule(dynamic, 1)
+    for(size_t s=0; s<vSegments.size(); ++s)
+    {
+      const VolumeSegment_OBB& segm = vSegments[s];
+      // slightly larger than the safe distance against round-off
+      const Real safe = 1.001 * segm.safe_distance;
+      int first[3], last[3];
+      for(int a=0; a<3; ++a)
+        lattice.range(a, segm.objBoxLabFr[a][0] - safe,
+                         segm.objBoxLabFr[a][1] + safe, first[a], last[a]);
+
+      for(int kz=first[2]; kz<last[2]; ++kz)
+      for(int ky=first[1]; ky<last[1]; ++ky)
+      for(int kx=first[0]; kx<last[0]; ++kx)
+      {
+        const int i = lattice.id[kx + (size_t)lattice.n[0]*(ky + (size_t)lattice.n[1]*kz)];
+        if(i < 0) continue;
+        const FluidBlock & b = *(FluidBlock*)vInfo[i].ptrBlock;
+        if(segm.isIntersectingWithAABB(b.min_pos.data(), b.max_pos.data()))
+          myHits.emplace_back(vInfo[i].blockID, (int)s);
+      }
+    }
+  }
+
+  for(const auto& myHits : hits)
+    for(const auto& hit : myHits) ret[hit.first].push_back(&vSegments[hit.second]);
+  // segments in increasing order, to get the same lists as the full search
+  #pragma omp parallel for schedule(static)
+  for(size_t i=0; i<ret.size(); ++i) std::sort(ret[i].begin(), ret[i].end());
+  return ret;
+}
+
 void VolumeSegment_OBB::prepare(std::pair<int, int> _s_range, const Real bbox[3][2], const Real h)
 {
   safe_distance = (SURFDH+2)*h; //two points on each side for Towers
@@ -271,6 +271,13 @@ struct VolumeSegment_OBB
   bool isIntersectingWithAABB(const Real start[3],const Real end[3]) const;
 };
 
+// Segments intersecting each block of `vInfo` (indexed by blockID), in
+// increasing order. A broad phase over the lattice of the rank's blocks picks
+// the candidate blocks of each segment for isIntersectingWithAABB.
+std::vector<std::vector<VolumeSegment_OBB*>> findSegmentsPerBlock(
+    const std::vector<cubism::BlockInfo>& vInfo,
+    std::vector<VolumeSegment_OBB>& vSegments);
+
 struct PutFishOnBlocks
 {
   const FishMidlineData * cfish;
@@ -167,19 +167,16 @@ void Naca::writeSDFOnBlocks(const intersect_t& segmentsPerBlock)
   {
     PutNacaOnBlocks putfish(myFish, position, quaternion);
 
+    // only the blocks intersected by a segment have been allocated
     #pragma omp for schedule(dynamic, 1)
-    for(size_t i=0; i<vInfo.size(); i++)
+    for(size_t i=0; i<obstacleBlockList.size(); i++)
     {
-      const BlockInfo info = vInfo[i];
-      const std::vector<VolumeSegment_OBB*>& S = segmentsPerBlock[info.blockID];
+      const ObstacleBlockRef& entry = obstacleBlockList[i];
+      const BlockInfo info = vInfo[entry.blockID];
+      const std::vector<VolumeSegment_OBB*>& S = segmentsPerBlock[entry.blockID];
       FluidBlock& b = *(FluidBlock*)info.ptrBlock;
-
-      if(S.size() > 0) {
-        assert(obstacleBlocks[info.blockID] not_eq nullptr);
-        ObstacleBlock* const block = obstacleBlocks[info.blockID];
-        putfish(info, b, block, S);
-      }
-      else assert(obstacleBlocks[info.blockID] == nullptr);
+      assert(S.size() > 0);
+      putfish(info, b, entry.block, S);
     }
   }
 
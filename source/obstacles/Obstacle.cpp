@@ -77,6 +77,9 @@ ObstacleArguments::ObstacleArguments(
   // into diagnostics forces (tasso del tasso del tasso):
   // If untouched forced only do diagnostics and selfprop only do surface.
   bComputeForces = parser("-computeForces").asBool(false);
+
+  // tabulate the signed distance of rigid obstacles once in their frame:
+  bSDFCache = parser("-sdfCache").asBool(false);
 }
 
 Obstacle::Obstacle(SimulationData&s, ArgumentParser&p)
@@ -95,6 +98,7 @@ Obstacle::Obstacle(
   quaternion[2] = args.quaternion[2];
   quaternion[3] = args.quaternion[3];
   _2Dangle = args.planarAngle;
+  bSDFCache = args.bSDFCache;
 
   if (!sim.rank) {
     printf("Obstacle L=%g, pos=[%g %g %g], q=[%g %g %g %g]\n",
@@ -267,13 +271,17 @@ void Obstacle::computeForces()
 {
   static const int nQoI = ObstacleBlock::nQoI;
   std::vector<double> sum = std::vector<double>(nQoI, 0);
-  for (auto & block : obstacleBlocks) {
-    if(block == nullptr) continue;
-    block->sumQoI(sum);
-  }
+  for (const ObstacleBlockRef & entry : obstacleBlockList)
+    entry.block->sumQoI(sum);
 
-  MPI_Allreduce(MPI_IN_PLACE, sum.data(), nQoI, MPI_DOUBLE, MPI_SUM, grid->getCartComm());
+  // reduced together for all obstacles by ComputeForces
+  sim.reductions.enqueue(sum.data(), nQoI, MPI_SUM, [this](const double * res) {
+    finalizeForces(res);
+  });
+}
 
+void Obstacle::finalizeForces(const double * const sum)
+{
   //additive quantities: (check against order in sumQoI of ObstacleBlocks.h )
   unsigned k = 0;
   surfForce[0]  = sum[k++]; surfForce[1]  = sum[k++]; surfForce[2]  = sum[k++];
@@ -299,10 +307,8 @@ void Obstacle::computeForces()
     char buf[500];
     sprintf(buf,"surface_%02d_%07d_rank%03d.raw",obstacleID,sim.step,sim.rank);
     FILE * pFile = fopen (buf, "wb");
-    for(auto & block : obstacleBlocks) {
-      if(block == nullptr) continue;
-      block->print(pFile);
-    }
+    for(const ObstacleBlockRef & entry : obstacleBlockList)
+      entry.block->print(pFile);
     fflush(pFile);
     fclose(pFile);
   }
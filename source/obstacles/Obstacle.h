@@ -11,8 +11,11 @@
 
 #include "../ObstacleBlock.h"
 #include "../SimulationData.h"
+#include "extra/BodySDFCache.h"
 
 #include <array>
+#include <memory>
+#include <utility>
 
 /*
  * HOW OBSTACLES WORK
@@ -68,6 +71,7 @@ struct ObstacleArguments
   std::array<bool, 3> bFixFrameOfRef = {{false, false, false}};
   bool bFixToPlanar = false;
   bool bComputeForces = true;
+  bool bSDFCache = false;  // Only for rigid obstacles, see create_base_rigid.
 
   ObstacleArguments() = default;
 
@@ -76,6 +80,13 @@ struct ObstacleArguments
 };
 
 
+// Entry of the compact list of the blocks touched by an obstacle.
+struct ObstacleBlockRef
+{
+  int blockID;
+  ObstacleBlock * block;
+};
+
 struct ObstacleVisitor
 {
   virtual ~ObstacleVisitor() {}
@@ -84,12 +95,29 @@ struct ObstacleVisitor
   //virtual void visit(IF3D_ObstacleVector  * const obstacle) {}
 };
 
+// Memory of the sdf caches (-sdfCache) of the obstacles of one rank, capped
+// by -sdfCacheMaxMB. Owned by ObstacleVector and shared with its obstacles.
+struct SDFCacheBudget
+{
+  size_t bytes = 0;
+  size_t maxBytes = 0;
+};
+
 class Obstacle
 {
 protected:
   const SimulationData & sim;
   FluidGridMPI * const grid = sim.grid;
   std::vector<ObstacleBlock*> obstacleBlocks;
+  // non-null entries of obstacleBlocks in increasing blockID, rebuilt by
+  // updateObstacleBlockList every time the blocks are allocated
+  std::vector<ObstacleBlockRef> obstacleBlockList;
+  // blocks of the previous steps, recycled instead of allocated every step
+  std::vector<ObstacleBlock*> obstacleBlockPool;
+  // signed distance of rigid obstacles in their frame, see create_base_rigid
+  bool bSDFCache = false;
+  BodySDFCache sdfCache;
+  std::shared_ptr<SDFCacheBudget> sdfCacheBudget;
   bool printedHeaderVels = false;
   bool isSelfPropelled = false;
 public:
@@ -147,6 +175,8 @@ public:
 
   virtual void computeVelocities();
   virtual void computeForces();
+  // called by computeForces with the QoIs reduced over all ranks
+  void finalizeForces(const double * sum);
   virtual void update();
   virtual void save(std::string filename = std::string());
   virtual void restart(std::string filename = std::string());
@@ -155,7 +185,7 @@ public:
   virtual void finalize();
 
   //methods that work for all obstacles
-  std::vector<ObstacleBlock*> getObstacleBlocks() const
+  const std::vector<ObstacleBlock*>& getObstacleBlocks() const
   {
       return obstacleBlocks;
   }
@@ -163,6 +193,11 @@ public:
   {
       return &obstacleBlocks;
   }
+  // only the blocks touched by the obstacle, to loop over
+  const std::vector<ObstacleBlockRef>& getObstacleBlockList() const
+  {
+      return obstacleBlockList;
+  }
 
   virtual ~Obstacle()
   {
@@ -173,37 +208,145 @@ public:
       }
     }
     obstacleBlocks.clear();
+    obstacleBlockList.clear();
+    for(auto & entry : obstacleBlockPool) delete entry;
+    obstacleBlockPool.clear();
+    if(sdfCacheBudget) sdfCacheBudget->bytes -= sdfCache.bytes();
+  }
+
+  // set by ObstacleVector::addObstacle, without it no sdf cache is built
+  void setSDFCacheBudget(std::shared_ptr<SDFCacheBudget> budget)
+  {
+    sdfCacheBudget = std::move(budget);
   }
 
   virtual std::array<double,3> getTranslationVelocity() const;
   virtual std::array<double,3> getAngularVelocity() const;
   virtual std::array<double,3> getCenterOfMass() const;
 
-  // driver to execute finite difference kernels either on all points relevant
-  // to the mass of the obstacle (where we have char func) or only on surface
+protected:
+  void updateObstacleBlockList()
+  {
+    obstacleBlockList.clear();
+    for (size_t i = 0; i < obstacleBlocks.size(); ++i)
+      if (obstacleBlocks[i] != nullptr)
+        obstacleBlockList.push_back({(int)i, obstacleBlocks[i]});
+  }
 
-  template<typename T>
-  void create_base(const T& kernel)
+  // Moves the blocks of the previous step to the pool and resizes the table to
+  // the current grid, with all entries null.
+  void releaseObstacleBlocks()
   {
     for(auto & entry : obstacleBlocks) {
       if(entry == nullptr) continue;
-      delete entry;
+      obstacleBlockPool.push_back(entry);
       entry = nullptr;
     }
+    obstacleBlocks.resize(sim.vInfo().size(), nullptr);
+  }
+
+  // Gives a block to every flagged blockID, taken from the pool if possible,
+  // and rebuilds obstacleBlockList. Blocks are reset in parallel: chi and sdf
+  // are only zeroed if the caller does not overwrite them entirely.
+  void acquireObstacleBlocks(const std::vector<char>& touching,
+                             const bool zeroChi, const bool zeroSdf)
+  {
+    assert(touching.size() == obstacleBlocks.size());
+    std::vector<char> isNew(touching.size(), 0);
+    for (size_t i = 0; i < touching.size(); ++i) {
+      if(not touching[i]) continue;
+      assert(obstacleBlocks[i] == nullptr);
+      if(obstacleBlockPool.empty()) {
+        obstacleBlocks[i] = new ObstacleBlock();
+        isNew[i] = 1;
+      } else {
+        obstacleBlocks[i] = obstacleBlockPool.back();
+        obstacleBlockPool.pop_back();
+      }
+    }
+    updateObstacleBlockList();
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < obstacleBlockList.size(); ++i) {
+      const ObstacleBlockRef& entry = obstacleBlockList[i];
+      // new blocks are not initialized: zero them entirely
+      if(isNew[entry.blockID]) entry.block->clear();
+      else entry.block->reset(zeroChi, zeroSdf);
+    }
+  }
+
+public:
+  // driver to execute finite difference kernels either on all points relevant
+  // to the mass of the obstacle (where we have char func) or only on surface
+
+  template<typename T>
+  void create_base(const T& kernel)
+  {
+    releaseObstacleBlocks();
     const std::vector<cubism::BlockInfo>& vInfo = sim.vInfo();
-    obstacleBlocks.resize(vInfo.size(), nullptr);
+    std::vector<char> touching(vInfo.size(), 0);
 
-    #pragma omp parallel for schedule(dynamic, 1)
+    #pragma omp parallel for schedule(static)
     for(size_t i=0; i<vInfo.size(); i++) {
-      const cubism::BlockInfo& info = vInfo[i];
-      const FluidBlock &b = *(FluidBlock *)info.ptrBlock;
-      if(kernel.isTouching(b)) {
-        assert(obstacleBlocks[info.blockID] == nullptr);
-        obstacleBlocks[info.blockID] = new ObstacleBlock();
-        obstacleBlocks[info.blockID]->clear(); //memset 0
-        kernel(info, obstacleBlocks[info.blockID]);
+      const FluidBlock &b = *(FluidBlock *)vInfo[i].ptrBlock;
+      touching[vInfo[i].blockID] = kernel.isTouching(b);
+    }
+
+    // the kernel overwrites the whole sdf and chi is computed from it later
+    acquireObstacleBlocks(touching, false, false);
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(size_t i=0; i<obstacleBlockList.size(); i++) {
+      const ObstacleBlockRef& entry = obstacleBlockList[i];
+      kernel(vInfo[entry.blockID], entry.block);
+    }
+  }
+
+  // whether the kernel touches any block of this rank
+  template<typename T>
+  bool touchesLocalBlocks(const T& kernel) const
+  {
+    const std::vector<cubism::BlockInfo>& vInfo = sim.vInfo();
+    bool touching = false;
+    #pragma omp parallel for schedule(static) reduction(||: touching)
+    for(size_t i=0; i<vInfo.size(); i++)
+      touching = touching || kernel.isTouching(*(FluidBlock *)vInfo[i].ptrBlock);
+    return touching;
+  }
+
+  // create_base for obstacles which only translate (bRotate=false) or move
+  // rigidly with the quaternion. With -sdfCache, the sdf is tabulated in the
+  // frame of the body, on a lattice of spacing h/2 covering the ball of given
+  // radius, and then interpolated. Each rank builds it at the first call in
+  // which the body touches its blocks, as long as the caches of the rank fit
+  // in the budget of the ObstacleVector; otherwise the sdf is computed
+  // exactly on that rank.
+  template<typename T>
+  void create_base_rigid(const T& kernel, const Real radius, const bool bRotate)
+  {
+    const double identity[4] = {1, 0, 0, 0};
+    const double * const q = bRotate ? quaternion : identity;
+    if(bSDFCache && sdfCacheBudget && not sdfCache.isBuilt() &&
+       touchesLocalBlocks(kernel)) {
+      // exact where chi, its gradient and the surface are computed
+      const Real h = sim.maxH(), dx = h/2, band = (4+SURFDH)*h + dx;
+      const double N = BodySDFCache::latticeSide(radius, dx, band);
+      const size_t bytes = N*N*N*sizeof(Real);
+      if(sdfCacheBudget->bytes + bytes > sdfCacheBudget->maxBytes) {
+        printf("WARNING: rank %d: sdfCache of obstacle %d exceeds "
+               "-sdfCacheMaxMB, not used.\n", sim.rank, obstacleID);
+        bSDFCache = false;
+      } else {
+        sdfCache.build(kernel, position, q, radius, dx, band);
+        sdfCacheBudget->bytes += sdfCache.bytes();
       }
     }
+    if(not sdfCache.isBuilt()) {
+      create_base(kernel);
+      return;
+    }
+    sdfCache.setPose(position, q);
+    create_base(CachedFillBlocks<T>(kernel, sdfCache));
   }
 };
 
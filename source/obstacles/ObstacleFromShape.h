@@ -98,10 +98,9 @@ public:
 
     const std::vector<cubism::BlockInfo> &vInfo = sim.vInfo();
     #pragma omp parallel for schedule(dynamic, 1)
-    for (int i = 0; i < (int)vInfo.size(); ++i) {
-      const cubism::BlockInfo &info = vInfo[i];
-      if (obstacleBlocks[info.blockID] != nullptr)
-        kernel.setVelocity(info, obstacleBlocks[info.blockID]);
+    for (size_t i = 0; i < obstacleBlockList.size(); ++i) {
+      const ObstacleBlockRef &entry = obstacleBlockList[i];
+      kernel.setVelocity(vInfo[entry.blockID], entry.block);
     }
   }
 
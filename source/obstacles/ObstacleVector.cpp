@@ -16,32 +16,32 @@ using namespace cubism;
 std::vector<std::array<int, 2>> ObstacleVector::collidingObstacles()
 {
   std::set<std::array<int, 2>> colliding; //IDs of colliding obstacles
-  //vector containing pointers to defBLock maps:
-  std::vector<std::vector<ObstacleBlock*>*> obstBlocks(obstacles.size());
-  int ID = 0;
-  std::vector<int> IDs;
-  for(const auto & obstacle_ptr : obstacles) {
-      IDs.push_back(ID);
-      obstBlocks[ID] = obstacle_ptr->getObstacleBlocksPtr();
-      assert(obstBlocks[ID] != nullptr);
-      ID++;
-  }
-
-  for(int i=1; i<ID; i++)
-  for(int j=0; j<i; j++) {
-    const auto& y = * obstBlocks[j];
-    const auto& x = * obstBlocks[i];
-    assert(x.size() == y.size());
-    for (size_t k=0; k<x.size(); k++) {
-      if(x[k] not_eq nullptr && y[k] not_eq nullptr) {
-        std::array<int,2> hit = {IDs[i],IDs[j]};
-        colliding.insert(hit); //it's a set: only unique pairs are inserted
-      }
+  for (const int blockID : touchedBlocks) {
+    const std::vector<int>& IDs = obstaclesPerBlock[blockID];
+    for(size_t i=1; i<IDs.size(); i++)
+    for(size_t j=0; j<i; j++) {
+      // IDs are increasing, keep the larger one first
+      std::array<int,2> hit = {IDs[i],IDs[j]};
+      colliding.insert(hit); //it's a set: only unique pairs are inserted
     }
   }
   return std::vector<std::array<int,2>>(colliding.begin(), colliding.end());
 }
 
+void ObstacleVector::updateObstaclesPerBlock()
+{
+  const size_t nBlocks = sim.vInfo().size();
+  obstaclesPerBlock.resize(nBlocks);
+  for (std::vector<int>& IDs : obstaclesPerBlock) IDs.clear();
+  for (size_t o = 0; o < obstacles.size(); ++o)
+    for (const ObstacleBlockRef& entry : obstacles[o]->getObstacleBlockList())
+      obstaclesPerBlock[entry.blockID].push_back((int)o);
+
+  touchedBlocks.clear();
+  for (size_t i = 0; i < nBlocks; ++i)
+    if (not obstaclesPerBlock[i].empty()) touchedBlocks.push_back((int)i);
+}
+
 void ObstacleVector::update()
 {
     for(const auto & obstacle_ptr : obstacles)
@@ -52,6 +52,7 @@ void ObstacleVector::create()
 {
   for(const auto & obstacle_ptr : obstacles)
     obstacle_ptr->create();
+  updateObstaclesPerBlock();
 }
 
 void ObstacleVector::finalize()
@@ -100,6 +101,12 @@ void ObstacleVector::Accept(ObstacleVisitor * visitor)
     obstacles[i]->Accept(visitor);
 }
 
+void ObstacleVector::Accept(ObstacleVisitor * visitor, const int blockID)
+{
+  for(const int i : obstaclesPerBlock[blockID])
+    obstacles[i]->Accept(visitor);
+}
+
 Real ObstacleVector::getD() const
 {
   Real maxL = 0;
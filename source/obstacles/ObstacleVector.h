@@ -21,7 +21,12 @@ class ObstacleVector : public Obstacle
  public:
     typedef std::vector<std::shared_ptr<Obstacle>> VectorType;
 
-    ObstacleVector(SimulationData&s) : Obstacle(s) {}
+    ObstacleVector(SimulationData&s) : Obstacle(s)
+    {
+        // the vector builds no cache itself, it shares its budget
+        sdfCacheBudget = std::make_shared<SDFCacheBudget>();
+        sdfCacheBudget->maxBytes = sim.sdfCacheMaxMB * 1024 * 1024;
+    }
 
     int nObstacles() const {return obstacles.size();}
     void computeVelocities() override;
@@ -34,12 +39,15 @@ class ObstacleVector : public Obstacle
     void create() override;
     void finalize() override;
     void Accept(ObstacleVisitor * visitor) override;
+    // visit only the obstacles which touch the block `blockID`
+    void Accept(ObstacleVisitor * visitor, int blockID);
 
     std::vector<std::array<int, 2>> collidingObstacles();
 
     void addObstacle(std::shared_ptr<Obstacle> obstacle)
     {
         obstacle->obstacleID = obstacles.size();
+        obstacle->setSDFCacheBudget(sdfCacheBudget);
         obstacles.emplace_back(std::move(obstacle));
     }
 
@@ -48,6 +56,17 @@ class ObstacleVector : public Obstacle
         return obstacles;
     }
 
+    // IDs of the obstacles touching each block of this rank, and IDs of the
+    // blocks touched by at least one obstacle, rebuilt by create()
+    const std::vector<std::vector<int>>& getObstaclesPerBlock() const
+    {
+        return obstaclesPerBlock;
+    }
+    const std::vector<int>& getTouchedBlocks() const
+    {
+        return touchedBlocks;
+    }
+
     std::vector<std::vector<ObstacleBlock*>*> getAllObstacleBlocks() const
     {
       const size_t Nobs = obstacles.size();
@@ -89,6 +108,10 @@ class ObstacleVector : public Obstacle
 
  protected:
     VectorType obstacles;
+    std::vector<std::vector<int>> obstaclesPerBlock;
+    std::vector<int> touchedBlocks;
+
+    void updateObstaclesPerBlock();
 };
 
 CubismUP_3D_NAMESPACE_END
@@ -267,7 +267,9 @@ void Plate::create()
       bx, by, bz,
       half_a, half_b, half_thickness, h);
 
-  create_base<PlateFillBlocks>(K);
+  const Real bound = std::sqrt(half_a*half_a + half_b*half_b
+                             + half_thickness*half_thickness);
+  create_base_rigid<PlateFillBlocks>(K, bound, false);
 }
 
 void Plate::finalize()
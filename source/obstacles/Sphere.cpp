@@ -129,10 +129,10 @@ void Sphere::create()
   const Real h = sim.maxH();
   if(bHemi) {
     const HemiSphereObstacle::FillBlocks K(radius, h, position);
-    create_base<HemiSphereObstacle::FillBlocks>(K);
+    create_base_rigid<HemiSphereObstacle::FillBlocks>(K, radius, false);
   } else {
     const SphereObstacle::FillBlocks K(radius, h, position);
-    create_base<SphereObstacle::FillBlocks>(K);
+    create_base_rigid<SphereObstacle::FillBlocks>(K, radius, false);
   }
 }
 
@@ -0,0 +1,156 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_BodySDFCache_h
+#define CubismUP_3D_BodySDFCache_h
+
+#include "ObstacleLibrary.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+/*
+ * Signed distance of a rigid body, tabulated once on a lattice in the frame of
+ * the body and sampled with trilinear interpolation after moving the point to
+ * that frame. Points interpolated closer than `band` to the surface, where chi
+ * and the surface quantities are computed, are evaluated exactly.
+ *
+ * The frame of the body is p_body = R(q) (p - position), with R as in the
+ * FillBlocks of the ellipsoid. Obstacles whose FillBlocks ignore the
+ * quaternion must pass the identity.
+ */
+class BodySDFCache
+{
+ public:
+  bool isBuilt() const { return not data.empty(); }
+  size_t bytes() const { return data.size() * sizeof(Real); }
+
+  // Points per side of the lattice tabulated by build.
+  static int latticeSide(const Real radius, const Real dx, const Real band)
+  {
+    return (int) std::ceil(2 * (radius + band + 2*dx) / dx) + 1;
+  }
+
+  // Tabulates kernel.signedDistance, at the current pose, on the cube of half
+  // side radius + band + 2*dx around the body. `radius` must bound the body.
+  template <typename Kernel>
+  void build(const Kernel & kernel, const double position[3],
+             const double quaternion[4], const Real radius, const Real _dx,
+             const Real _band)
+  {
+    dx = _dx; band = _band;
+    N = latticeSide(radius, dx, band);
+    half = (N - 1) * dx / 2;
+    setPose(position, quaternion);
+    data.resize((size_t) N * N * N);
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int iz = 0; iz < N; ++iz)
+    for (int iy = 0; iy < N; ++iy)
+    for (int ix = 0; ix < N; ++ix) {
+      const Real b[3] = {ix*dx - half, iy*dx - half, iz*dx - half};
+      Real p[3];
+      toWorld(b, p);
+      data[ix + (size_t) N * (iy + (size_t) N * iz)] =
+          kernel.signedDistance(p[0], p[1], p[2]);
+    }
+  }
+
+  void setPose(const double position[3], const double quaternion[4])
+  {
+    const double w = quaternion[0], x = quaternion[1];
+    const double y = quaternion[2], z = quaternion[3];
+    const double R[3][3] = {
+        {1-2*(y*y+z*z),   2*(x*y+z*w),   2*(x*z-y*w)},
+        {  2*(x*y-z*w), 1-2*(x*x+z*z),   2*(y*z+x*w)},
+        {  2*(x*z+y*w),   2*(y*z-x*w), 1-2*(x*x+y*y)}
+    };
+    for (int i = 0; i < 3; ++i) {
+      pos[i] = position[i];
+      for (int j = 0; j < 3; ++j) rot[i][j] = R[i][j];
+    }
+  }
+
+  // Interpolated distance, exact close to the surface. Outside of the lattice,
+  // which is further than band from the body, the distance to the lattice is
+  // subtracted from the value at its boundary.
+  template <typename Kernel>
+  Real signedDistance(const Kernel & kernel, const Real x, const Real y,
+                      const Real z) const
+  {
+    const Real d[3] = {x - pos[0], y - pos[1], z - pos[2]};
+    Real b[3], c[3], out = 0;
+    for (int i = 0; i < 3; ++i) {
+      b[i] = rot[i][0]*d[0] + rot[i][1]*d[1] + rot[i][2]*d[2];
+      c[i] = std::max(-half, std::min(half, b[i]));
+      out += (b[i] - c[i]) * (b[i] - c[i]);
+    }
+    const Real dist = interpolate(c);
+    if (out > 0) return dist - std::sqrt(out);
+    if (std::fabs(dist) < band) return kernel.signedDistance(x, y, z);
+    return dist;
+  }
+
+ private:
+  std::vector<Real> data;
+  int N = 0;
+  Real dx = 0, band = 0, half = 0;
+  Real pos[3] = {0, 0, 0};
+  Real rot[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+  void toWorld(const Real b[3], Real p[3]) const
+  {
+    // R is orthogonal: inverse is the transpose
+    for (int i = 0; i < 3; ++i)
+      p[i] = pos[i] + rot[0][i]*b[0] + rot[1][i]*b[1] + rot[2][i]*b[2];
+  }
+
+  Real interpolate(const Real c[3]) const
+  {
+    int i0[3];
+    Real w[3];
+    for (int i = 0; i < 3; ++i) {
+      const Real s = (c[i] + half) / dx;
+      i0[i] = std::min((int) s, N - 2);
+      w[i] = s - i0[i];
+    }
+    const size_t sy = N, sz = (size_t) N * N;
+    const Real * const v = data.data() + i0[0] + sy * i0[1] + sz * i0[2];
+    const Real v00 = v[0]       * (1-w[0]) + v[1]         * w[0];
+    const Real v10 = v[sy]      * (1-w[0]) + v[sy + 1]    * w[0];
+    const Real v01 = v[sz]      * (1-w[0]) + v[sz + 1]    * w[0];
+    const Real v11 = v[sz + sy] * (1-w[0]) + v[sz+sy + 1] * w[0];
+    return (v00 * (1-w[1]) + v10 * w[1]) * (1-w[2])
+         + (v01 * (1-w[1]) + v11 * w[1]) * w[2];
+  }
+};
+
+/*
+ * FillBlocks of a rigid obstacle which reads the signed distance from a
+ * BodySDFCache, built from the same kernel.
+ */
+template <typename Kernel>
+struct CachedFillBlocks : FillBlocksBase<CachedFillBlocks<Kernel>>
+{
+  const Kernel & kernel;
+  const BodySDFCache & cache;
+
+  CachedFillBlocks(const Kernel & k, const BodySDFCache & c) :
+    kernel(k), cache(c) { }
+
+  bool isTouching(const FluidBlock & b) const { return kernel.isTouching(b); }
+
+  Real signedDistance(const Real x, const Real y, const Real z) const
+  {
+    return cache.signedDistance(kernel, x, y, z);
+  }
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_BodySDFCache_h
@@ -7,12 +7,24 @@
 //
 
 #include "AdvectionDiffusion.h"
+#include "../obstacles/ObstacleVector.h"
+#include "../poisson/PoissonSolver.h"
 
 CubismUP_3D_NAMESPACE_BEGIN
 using namespace cubism;
 
 static constexpr Real EPS = std::numeric_limits<Real>::epsilon();
 
+// Clone the row kernels for AVX-512, AVX2 and generic x86-64 and pick the
+// best one at load time, independently of the -march the code is built with.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) \
+    && !defined(__INTEL_COMPILER)
+#define CUP_SIMD_DISPATCH \
+  __attribute__((target_clones("arch=skylake-avx512","arch=haswell","default")))
+#else
+#define CUP_SIMD_DISPATCH
+#endif
+
 namespace {
 
 struct KernelAdvectDiffuseBase
@@ -144,6 +156,96 @@ struct KernelAdvectDiffuse : public KernelAdvectDiffuseBase
   }
 };
 
+// Rows are padded by one ghost on each side. Strides of the SoA scratch:
+static constexpr int ROW_SY = FluidBlock::sizeX + 2;
+static constexpr int ROW_SZ = ROW_SY * (FluidBlock::sizeY + 2);
+
+// Same update as KernelAdvectDiffuse for a full x-row. Pointers are to the
+// first interior cell of the row.
+CUP_SIMD_DISPATCH
+void advectDiffuseRow(const Real * __restrict__ const U,
+  const Real * __restrict__ const V, const Real * __restrict__ const W,
+  Real * __restrict__ const outU, Real * __restrict__ const outV,
+  Real * __restrict__ const outW, const Real uInf0, const Real uInf1,
+  const Real uInf2, const Real facA, const Real facD)
+{
+  #pragma omp simd
+  for (int ix=0; ix<FluidBlock::sizeX; ++ix) {
+    const Real dudx= U[ix+1]-U[ix-1], dvdx= V[ix+1]-V[ix-1], dwdx= W[ix+1]-W[ix-1];
+    const Real dudy= U[ix+ROW_SY]-U[ix-ROW_SY], dvdy= V[ix+ROW_SY]-V[ix-ROW_SY];
+    const Real dwdy= W[ix+ROW_SY]-W[ix-ROW_SY];
+    const Real dudz= U[ix+ROW_SZ]-U[ix-ROW_SZ], dvdz= V[ix+ROW_SZ]-V[ix-ROW_SZ];
+    const Real dwdz= W[ix+ROW_SZ]-W[ix-ROW_SZ];
+    const Real u = U[ix]+uInf0, v = V[ix]+uInf1, w = W[ix]+uInf2;
+    const Real duD = U[ix+ROW_SY]+U[ix-ROW_SY] + U[ix+1]+U[ix-1]
+                   + U[ix+ROW_SZ]+U[ix-ROW_SZ] - U[ix]*6;
+    const Real dvD = V[ix+ROW_SY]+V[ix-ROW_SY] + V[ix+1]+V[ix-1]
+                   + V[ix+ROW_SZ]+V[ix-ROW_SZ] - V[ix]*6;
+    const Real dwD = W[ix+ROW_SY]+W[ix-ROW_SY] + W[ix+1]+W[ix-1]
+                   + W[ix+ROW_SZ]+W[ix-ROW_SZ] - W[ix]*6;
+    const Real duA = u * dudx + v * dudy + w * dudz;
+    const Real dvA = u * dvdx + v * dvdy + w * dvdz;
+    const Real dwA = u * dwdx + v * dwdy + w * dwdz;
+    outU[ix] = U[ix] + facA*duA + facD*duD;
+    outV[ix] = V[ix] + facA*dvA + facD*dvD;
+    outW[ix] = W[ix] + facA*dwA + facD*dwD;
+  }
+}
+
+// KernelAdvectDiffuse on unit-stride copies of u,v,w: the lab is transposed
+// once per block and each x-row is then updated with packed SIMD operations.
+struct KernelAdvectDiffuseSIMD : public KernelAdvectDiffuseBase
+{
+  static constexpr int BX = FluidBlock::sizeX;
+  static constexpr int BY = FluidBlock::sizeY;
+  static constexpr int BZ = FluidBlock::sizeZ;
+  // non-const non thread safe:
+  Real __attribute__((__aligned__(CUP_ALIGNMENT))) UVW[3][BZ+2][BY+2][BX+2];
+  Real __attribute__((__aligned__(CUP_ALIGNMENT))) OUT[3][BX];
+
+  KernelAdvectDiffuseSIMD(const SimulationData&s, double _dt) :
+    KernelAdvectDiffuseBase(s, _dt) {}
+
+  template <typename Lab, typename BlockType>
+  void operator()(Lab & lab, const BlockInfo& info, BlockType& o)
+  {
+    const Real facA = -dt/(2*info.h_gridpoint);
+    const Real facD = (mu/info.h_gridpoint) * (dt/info.h_gridpoint);
+    applyBCwest(info, lab);
+    applyBCeast(info, lab);
+    applyBCsouth(info, lab);
+    applyBCnorth(info, lab);
+    applyBCfront(info, lab);
+    applyBCback(info, lab);
+
+    // edges and corners of the lab are not part of the stencil
+    for (int iz=-1; iz<=BZ; ++iz)
+    for (int iy=-1; iy<=BY; ++iy) {
+      const bool ghostZ = iz<0 || iz==BZ, ghostY = iy<0 || iy==BY;
+      if(ghostZ && ghostY) continue;
+      const int beg = ghostZ || ghostY ? 0 : -1, end = ghostZ || ghostY ? BX : BX+1;
+      for (int ix=beg; ix<end; ++ix) {
+        const FluidElement & L = lab(ix,iy,iz);
+        UVW[0][iz+1][iy+1][ix+1] = L.u;
+        UVW[1][iz+1][iy+1][ix+1] = L.v;
+        UVW[2][iz+1][iy+1][ix+1] = L.w;
+      }
+    }
+
+    for (int iz=0; iz<BZ; ++iz)
+    for (int iy=0; iy<BY; ++iy) {
+      advectDiffuseRow(&UVW[0][iz+1][iy+1][1], &UVW[1][iz+1][iy+1][1],
+        &UVW[2][iz+1][iy+1][1], OUT[0], OUT[1], OUT[2],
+        uInf[0], uInf[1], uInf[2], facA, facD);
+      for (int ix=0; ix<BX; ++ix) {
+        o(ix,iy,iz).tmpU = OUT[0][ix];
+        o(ix,iy,iz).tmpV = OUT[1][ix];
+        o(ix,iy,iz).tmpW = OUT[2][ix];
+      }
+    }
+  }
+};
+
 struct KernelAdvectDiffuse_nonUniform : public KernelAdvectDiffuseBase
 {
   KernelAdvectDiffuse_nonUniform(const SimulationData&s, double _dt) :
@@ -203,6 +305,147 @@ struct KernelAdvectDiffuse_nonUniform : public KernelAdvectDiffuseBase
   }
 };
 
+// Advection-diffusion fused with the pressure RHS of PressureRHS. The lab is
+// two cells wide so that tmpU,V,W can also be computed on the first layer of
+// ghosts, from which the divergence of the new velocity is taken directly.
+// Only valid with periodic or wall BCs (no fading, no inflow correction) on
+// uniform grids, see Simulation::setupOperators.
+struct KernelAdvectDiffusePressureRHS : public KernelAdvectDiffuseBase
+{
+  static constexpr int BX = FluidBlock::sizeX;
+  static constexpr int BY = FluidBlock::sizeY;
+  static constexpr int BZ = FluidBlock::sizeZ;
+  PoissonSolver * const solver;
+  // advected-diffused velocity on the block and its first layer of ghosts
+  // non-const non thread safe:
+  Real TMP[3][BZ+2][BY+2][BX+2];
+
+  const StencilInfo stencil{-2,-2,-2, 3,3,3, true, {FE_U,FE_V,FE_W}};
+
+  KernelAdvectDiffusePressureRHS(const SimulationData&s, double _dt,
+    PoissonSolver* pois) : KernelAdvectDiffuseBase(s, _dt), solver(pois) {}
+
+  // Cubism fills wall ghosts only across the face of the block; the ring of
+  // tmp needs them on edges and corners too. Apply faces in sequence over
+  // the whole lab, so that later directions overwrite edges with consistent
+  // values.
+  template <typename Lab>
+  void applyBCwalls(const BlockInfo & I, Lab & L) const
+  {
+    static constexpr int S = -2;
+    const bool wallX = sim.BCx_flag == wall, wallY = sim.BCy_flag == wall;
+    const bool wallZ = sim.BCz_flag == wall;
+    const auto mirror = [](FluidElement& dst, const FluidElement& src) {
+      dst.u = - src.u; dst.v = - src.v; dst.w = - src.w;
+    };
+    if(wallX && I.index[0] == 0)
+      for(int iz=S; iz<BZ-S; ++iz) for(int iy=S; iy<BY-S; ++iy)
+      for(int ix=S; ix<0; ++ix) mirror(L(ix,iy,iz), L(-1-ix,iy,iz));
+    if(wallX && I.index[0] == sim.bpdx-1)
+      for(int iz=S; iz<BZ-S; ++iz) for(int iy=S; iy<BY-S; ++iy)
+      for(int ix=BX; ix<BX-S; ++ix) mirror(L(ix,iy,iz), L(2*BX-1-ix,iy,iz));
+    if(wallY && I.index[1] == 0)
+      for(int iz=S; iz<BZ-S; ++iz) for(int iy=S; iy<0; ++iy)
+      for(int ix=S; ix<BX-S; ++ix) mirror(L(ix,iy,iz), L(ix,-1-iy,iz));
+    if(wallY && I.index[1] == sim.bpdy-1)
+      for(int iz=S; iz<BZ-S; ++iz) for(int iy=BY; iy<BY-S; ++iy)
+      for(int ix=S; ix<BX-S; ++ix) mirror(L(ix,iy,iz), L(ix,2*BY-1-iy,iz));
+    if(wallZ && I.index[2] == 0)
+      for(int iz=S; iz<0; ++iz) for(int iy=S; iy<BY-S; ++iy)
+      for(int ix=S; ix<BX-S; ++ix) mirror(L(ix,iy,iz), L(ix,iy,-1-iz));
+    if(wallZ && I.index[2] == sim.bpdz-1)
+      for(int iz=BZ; iz<BZ-S; ++iz) for(int iy=S; iy<BY-S; ++iy)
+      for(int ix=S; ix<BX-S; ++ix) mirror(L(ix,iy,iz), L(ix,iy,2*BZ-1-iz));
+  }
+
+  // The ring of tmp must be what the lab of PressureRHS would contain after
+  // the velocity update: at walls that is the mirrored tmp.
+  void applyBCwallsTMP(const BlockInfo & I)
+  {
+    const bool wallX = sim.BCx_flag == wall, wallY = sim.BCy_flag == wall;
+    const bool wallZ = sim.BCz_flag == wall;
+    for(int c=0; c<3; ++c) {
+      if(wallX && I.index[0] == 0)
+        for(int iz=1; iz<=BZ; ++iz) for(int iy=1; iy<=BY; ++iy)
+          TMP[c][iz][iy][0] = - TMP[c][iz][iy][1];
+      if(wallX && I.index[0] == sim.bpdx-1)
+        for(int iz=1; iz<=BZ; ++iz) for(int iy=1; iy<=BY; ++iy)
+          TMP[c][iz][iy][BX+1] = - TMP[c][iz][iy][BX];
+      if(wallY && I.index[1] == 0)
+        for(int iz=1; iz<=BZ; ++iz) for(int ix=1; ix<=BX; ++ix)
+          TMP[c][iz][0][ix] = - TMP[c][iz][1][ix];
+      if(wallY && I.index[1] == sim.bpdy-1)
+        for(int iz=1; iz<=BZ; ++iz) for(int ix=1; ix<=BX; ++ix)
+          TMP[c][iz][BY+1][ix] = - TMP[c][iz][BY][ix];
+      if(wallZ && I.index[2] == 0)
+        for(int iy=1; iy<=BY; ++iy) for(int ix=1; ix<=BX; ++ix)
+          TMP[c][0][iy][ix] = - TMP[c][1][iy][ix];
+      if(wallZ && I.index[2] == sim.bpdz-1)
+        for(int iy=1; iy<=BY; ++iy) for(int ix=1; ix<=BX; ++ix)
+          TMP[c][BZ+1][iy][ix] = - TMP[c][BZ][iy][ix];
+    }
+  }
+
+  template <typename Lab>
+  inline void advectDiffuse(Lab & lab, const int ix, const int iy,
+    const int iz, const Real facA, const Real facD)
+  {
+    const FluidElement &L =lab(ix,iy,iz);
+    const FluidElement &LW=lab(ix-1,iy,iz), &LE=lab(ix+1,iy,iz);
+    const FluidElement &LS=lab(ix,iy-1,iz), &LN=lab(ix,iy+1,iz);
+    const FluidElement &LF=lab(ix,iy,iz-1), &LB=lab(ix,iy,iz+1);
+    const Real dudx= LE.u-LW.u, dvdx= LE.v-LW.v, dwdx= LE.w-LW.w;
+    const Real dudy= LN.u-LS.u, dvdy= LN.v-LS.v, dwdy= LN.w-LS.w;
+    const Real dudz= LB.u-LF.u, dvdz= LB.v-LF.v, dwdz= LB.w-LF.w;
+    const Real u = L.u+uInf[0], v = L.v+uInf[1], w = L.w+uInf[2];
+    const Real duD = LN.u+LS.u + LE.u+LW.u + LF.u+LB.u - L.u*6;
+    const Real dvD = LN.v+LS.v + LE.v+LW.v + LF.v+LB.v - L.v*6;
+    const Real dwD = LN.w+LS.w + LE.w+LW.w + LF.w+LB.w - L.w*6;
+    const Real duA = u * dudx + v * dudy + w * dudz;
+    const Real dvA = u * dvdx + v * dvdy + w * dvdz;
+    const Real dwA = u * dwdx + v * dwdy + w * dwdz;
+    TMP[0][iz+1][iy+1][ix+1] = L.u + facA*duA + facD*duD;
+    TMP[1][iz+1][iy+1][ix+1] = L.v + facA*dvA + facD*dvD;
+    TMP[2][iz+1][iy+1][ix+1] = L.w + facA*dwA + facD*dwD;
+  }
+
+  template <typename Lab, typename BlockType>
+  void operator()(Lab & lab, const BlockInfo& info, BlockType& o)
+  {
+    const Real h = info.h_gridpoint;
+    const Real facA = -dt/(2*h), facD = (mu/h) * (dt/h), facP = 0.5*h*h/dt;
+    applyBCwalls(info, lab);
+
+    // Block and the six faces of the ring. Edges and corners of the ring are
+    // not needed by the divergence.
+    for (int iz=-1; iz<=BZ; ++iz)
+    for (int iy=-1; iy<=BY; ++iy) {
+      const bool ghostZ = iz<0 || iz==BZ, ghostY = iy<0 || iy==BY;
+      if(ghostZ && ghostY) continue;
+      if(ghostZ || ghostY) {
+        for (int ix=0; ix<BX; ++ix) advectDiffuse(lab, ix,iy,iz, facA,facD);
+      } else {
+        for (int ix=-1; ix<=BX; ++ix) advectDiffuse(lab, ix,iy,iz, facA,facD);
+      }
+    }
+    applyBCwallsTMP(info);
+
+    Real* __restrict__ const ret = solver->data + solver->_offset_ext(info);
+    const unsigned SX=solver->stridex, SY=solver->stridey, SZ=solver->stridez;
+    for (int iz=0; iz<BZ; ++iz)
+    for (int iy=0; iy<BY; ++iy)
+    for (int ix=0; ix<BX; ++ix) {
+      const int x = ix+1, y = iy+1, z = iz+1;
+      o(ix,iy,iz).tmpU = TMP[0][z][y][x];
+      o(ix,iy,iz).tmpV = TMP[1][z][y][x];
+      o(ix,iy,iz).tmpW = TMP[2][z][y][x];
+      ret[SZ*iz +SY*iy +SX*ix] = facP * (TMP[0][z][y][x+1] - TMP[0][z][y][x-1]
+                                       + TMP[1][z][y+1][x] - TMP[1][z][y-1][x]
+                                       + TMP[2][z+1][y][x] - TMP[2][z-1][y][x]);
+    }
+  }
+};
+
 struct UpdateAndCorrectInflow
 {
   SimulationData & sim;
@@ -415,8 +658,20 @@ void AdvectionDiffusion::operator()(const double dt)
   else
   {
     sim.startProfiler("AdvDiff Kernel");
-    const KernelAdvectDiffuse K(sim, dt);
-    compute(K);
+    if(sim.bScalarAdvection) {
+      const KernelAdvectDiffuse K(sim, dt);
+      compute(K);
+    } else {
+      const int nthreads = omp_get_max_threads();
+      std::vector<KernelAdvectDiffuseSIMD*> K(nthreads, nullptr);
+      #pragma omp parallel for schedule(static, 1)
+      for(int i=0; i<nthreads; ++i)
+        K[i] = new KernelAdvectDiffuseSIMD(sim, dt);
+
+      compute<KernelAdvectDiffuseSIMD>(K);
+
+      for(int i=0; i<nthreads; i++) delete K[i];
+    }
     sim.stopProfiler();
     sim.startProfiler("AdvDiff copy");
     //const UpdateAndCorrectInflow U(sim);
@@ -427,4 +682,35 @@ void AdvectionDiffusion::operator()(const double dt)
   check("AdvectionDiffusion");
 }
 
+void AdvectionDiffusionPressureRHS::operator()(const double dt)
+{
+  if(sim.obstacle_vector->nObstacles() > 0) {
+    printf("AdvectionDiffusionPressureRHS does not support obstacles.\n");
+    fflush(0); MPI_Abort(sim.app_comm, 1);
+  }
+  sim.pressureSolver->reset();
+
+  sim.startProfiler("AdvDiffRHS Kernel");
+  {
+    const int nthreads = omp_get_max_threads();
+    std::vector<KernelAdvectDiffusePressureRHS*> K(nthreads, nullptr);
+    #pragma omp parallel for schedule(static, 1)
+    for(int i=0; i<nthreads; ++i)
+      K[i] = new KernelAdvectDiffusePressureRHS(sim, dt, sim.pressureSolver);
+
+    compute<KernelAdvectDiffusePressureRHS>(K);
+
+    for(int i=0; i<nthreads; i++) delete K[i];
+  }
+  sim.stopProfiler();
+
+  sim.startProfiler("AdvDiff copy");
+  // with periodic and wall BCs this is a plain copy, no inflow correction
+  const UpdateAndCorrectInflow_nonUniform U(sim);
+  U.operate();
+  sim.stopProfiler();
+
+  check("AdvectionDiffusionPressureRHS");
+}
+
 CubismUP_3D_NAMESPACE_END
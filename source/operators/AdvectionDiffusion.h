@@ -23,6 +23,29 @@ public:
   void operator()(const double dt);
 
   std::string getName() { return "AdvectionDiffusion"; }
+
+  unsigned reads() const override { return DATA_VEL | DATA_UINF; }
+  unsigned writes() const override { return DATA_VEL | DATA_TMP; }
+};
+
+// Performs AdvectionDiffusion and, in the same sweep, writes the RHS of the
+// pressure equation (as PressureRHS without obstacles) into the solver.
+class AdvectionDiffusionPressureRHS : public Operator
+{
+public:
+  AdvectionDiffusionPressureRHS(SimulationData & s) : Operator(s) { }
+
+  ~AdvectionDiffusionPressureRHS() { }
+
+  void operator()(const double dt);
+
+  std::string getName() { return "AdvectionDiffusionPressureRHS"; }
+
+  unsigned reads() const override { return DATA_VEL | DATA_UINF; }
+  unsigned writes() const override
+  {
+    return DATA_VEL | DATA_TMP | DATA_POISSON;
+  }
 };
 
 CubismUP_3D_NAMESPACE_END
@@ -179,8 +179,10 @@ void Analysis::operator()(const double dt)
       delete gradStats[i];
     }
 
-    MPI_Allreduce(MPI_IN_PLACE, &grad_mean, 1, MPI_DOUBLE,MPI_SUM,sim.app_comm);
-    MPI_Allreduce(MPI_IN_PLACE, &grad_std , 1, MPI_DOUBLE,MPI_SUM,sim.app_comm);
+    double grad_sums[2] = {grad_mean, grad_std};
+    sim.reductions.reduce(grad_sums, 2, MPI_SUM);
+    grad_mean = grad_sums[0];
+    grad_std  = grad_sums[1];
     grad_mean /= normalize;
     grad_std  /= normalize;
 
@@ -26,6 +26,14 @@ public:
   void operator()(const double dt);
 
   std::string getName() { return "Analysis"; }
+
+  unsigned reads() const override
+  {
+    return DATA_VEL | DATA_UINF | DATA_SPECTRAL;
+  }
+  // grad_mean and grad_std are only written to the analysis files.
+  unsigned writes() const override { return DATA_SPECTRAL; }
+  bool isDiagnostic() const override { return true; }
 };
 
 CubismUP_3D_NAMESPACE_END
@@ -39,6 +39,16 @@ public:
   /* Invoke all listeners. */
   void operator()(double dt) override;
 
+  /* Listeners may access anything, an empty checkpoint accesses nothing. */
+  unsigned reads() const override
+  {
+    return listeners_.empty() ? DATA_NONE : DATA_ALL;
+  }
+  unsigned writes() const override
+  {
+    return listeners_.empty() ? DATA_NONE : DATA_ALL;
+  }
+
   /* Add a listener to the checkpoint. */
   iterator addListener(listener_type listener);
 
@@ -156,22 +156,23 @@ void ComputeDissipation::operator()(const double dt)
     delete diss[i];
   }
 
-  MPI_Allreduce(MPI_IN_PLACE, RDX, 20,MPI_DOUBLE, MPI_SUM,grid->getCartComm());
-
-  if(sim.rank==0)
-  {
+  // only written to file: no need to wait for the reduction here
+  const int step = sim.step; const double time = sim.time;
+  const bool bWrite = sim.rank == 0;
+  sim.reductions.enqueue(RDX, 20, MPI_SUM, [=](const double * SUM) {
+    if(not bWrite) return;
     std::stringstream &fileDissip = logger.get_stream("diagnostics.dat");
-    if(sim.step==0)
+    if(step==0)
      fileDissip<<"step_id time circ_x circ_y circ_y linImp_x linImp_y linImp_z "
      "linMom_x linMom_y linMom_z angImp_x angImp_y angImp_z angMom_x angMom_y "
      "angMom_z presPow viscPow helicity kineticEn enstrophy"<<std::endl;
 
-    fileDissip<<sim.step<<" "<<sim.time<<" "<<
-     RDX[ 0]<<" "<<RDX[ 1]<<" "<<RDX[ 2]<<" "<<RDX[ 3]<<" "<<RDX[ 4]<<" "<<
-     RDX[ 5]<<" "<<RDX[ 6]<<" "<<RDX[ 7]<<" "<<RDX[ 8]<<" "<<RDX[ 9]<<" "<<
-     RDX[10]<<" "<<RDX[11]<<" "<<RDX[12]<<" "<<RDX[13]<<" "<<RDX[14]<<" "<<
-     RDX[15]<<" "<<RDX[16]<<" "<<RDX[17]<<" "<<RDX[18]<<" "<<RDX[19]<<std::endl;
-  }
+    fileDissip<<step<<" "<<time<<" "<<
+     SUM[ 0]<<" "<<SUM[ 1]<<" "<<SUM[ 2]<<" "<<SUM[ 3]<<" "<<SUM[ 4]<<" "<<
+     SUM[ 5]<<" "<<SUM[ 6]<<" "<<SUM[ 7]<<" "<<SUM[ 8]<<" "<<SUM[ 9]<<" "<<
+     SUM[10]<<" "<<SUM[11]<<" "<<SUM[12]<<" "<<SUM[13]<<" "<<SUM[14]<<" "<<
+     SUM[15]<<" "<<SUM[16]<<" "<<SUM[17]<<" "<<SUM[18]<<" "<<SUM[19]<<std::endl;
+  });
   sim.stopProfiler();
 
   check("ComputeDissipation");
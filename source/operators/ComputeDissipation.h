@@ -20,6 +20,10 @@ public:
   ComputeDissipation(SimulationData & s) : Operator(s) { }
   void operator()(const double dt);
   std::string getName() { return "Dissipation"; }
+
+  unsigned reads() const override { return DATA_CHI | DATA_VEL | DATA_PRES; }
+  unsigned writes() const override { return DATA_NONE; }
+  bool isDiagnostic() const override { return true; }
 };
 
 CubismUP_3D_NAMESPACE_END
@@ -47,14 +47,22 @@ class KernelFixedMassFlux_nonUniform
   KernelFixedMassFlux_nonUniform(double _dt, double _scale, double _y_max)
       : dt(_dt), scale(_scale), y_max(_y_max) { }
 
-  void operator()(const BlockInfo& info, FluidBlock& o) const
+  // also updates the extrema of the final velocity (see SimulationData)
+  void operator()(const BlockInfo& info, FluidBlock& o, double ext[6]) const
   {
     for (int iz = 0; iz < FluidBlock::sizeZ; ++iz)
     for (int iy = 0; iy < FluidBlock::sizeY; ++iy) {
       Real p[3]; info.pos(p, 0, iy, 0);
       const Real y = p[1];
-      for (int ix = 0; ix < FluidBlock::sizeX; ++ix)
-          o(ix, iy, iz).u += 6 * scale * y/y_max * (1.0 - y/y_max);
+      for (int ix = 0; ix < FluidBlock::sizeX; ++ix) {
+        o(ix, iy, iz).u += 6 * scale * y/y_max * (1.0 - y/y_max);
+        ext[0] = std::max(ext[0], (double)   o(ix, iy, iz).u);
+        ext[1] = std::max(ext[1], (double)   o(ix, iy, iz).v);
+        ext[2] = std::max(ext[2], (double)   o(ix, iy, iz).w);
+        ext[3] = std::max(ext[3], (double) - o(ix, iy, iz).u);
+        ext[4] = std::max(ext[4], (double) - o(ix, iy, iz).v);
+        ext[5] = std::max(ext[5], (double) - o(ix, iy, iz).w);
+      }
     }
   }
 };
@@ -72,9 +80,9 @@ void FixedMassFlux_nonUniform::operator()(const double dt)
   const Real y_max = sim.extent[1];
   const Real u_avg = 2.0/3.0 * sim.uMax_forced;
 
-  u_avg_msr = avgUx_nonUniform(vInfo, sim.uinf.data(), volume);
-  MPI_Allreduce(MPI_IN_PLACE, &u_avg_msr, 1, MPI_DOUBLE, MPI_SUM,
-                grid->getCartComm());
+  double u_avg_sum = avgUx_nonUniform(vInfo, sim.uinf.data(), volume);
+  sim.reductions.reduce(&u_avg_sum, 1, MPI_SUM);
+  u_avg_msr = u_avg_sum;
 
   delta_u = u_avg - u_avg_msr;
   const Real reTau = std::sqrt(std::fabs(delta_u/sim.dt)) / sim.nu;
@@ -90,9 +98,16 @@ void FixedMassFlux_nonUniform::operator()(const double dt)
         u_avg_msr, u_avg, delta_u, scale, reTau);
   }
   KernelFixedMassFlux_nonUniform K(sim.dt, scale, y_max);
-  #pragma omp parallel for schedule(static)
+  const double lowest = - std::numeric_limits<double>::max();
+  double ext[6] = {lowest, lowest, lowest, lowest, lowest, lowest};
+  #pragma omp parallel for schedule(static) reduction(max : ext[:6])
   for(size_t i=0; i<vInfo.size(); i++)
-    K(vInfo[i], *(FluidBlock*)vInfo[i].ptrBlock);
+    K(vInfo[i], *(FluidBlock*)vInfo[i].ptrBlock, ext);
+
+  // this is the last operator to modify the velocity in the step
+  sim.resetVelocityExtrema();
+  sim.accumulateVelocityExtrema(ext);
+  sim.postVelocityExtrema();
 
   sim.stopProfiler();
   check("FixedMassFlux");
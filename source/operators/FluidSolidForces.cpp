@@ -34,7 +34,7 @@ struct KernelComputeForces : public ObstacleVisitor
     info_ptr = & info;
     ObstacleVisitor* const base = static_cast<ObstacleVisitor*> (this);
     assert( base not_eq nullptr );
-    obstacle_vector->Accept( base );
+    obstacle_vector->Accept( base, info.blockID );
     lab_ptr = nullptr;
     info_ptr = nullptr;
   }
@@ -70,9 +70,9 @@ struct KernelComputeForces : public ObstacleVisitor
     for(int i=0; i<o->nPoints; i++)
     {
       Real p[3];
-      const int ix = o->surface[i]->ix;
-      const int iy = o->surface[i]->iy;
-      const int iz = o->surface[i]->iz;
+      const int ix = o->surfIx[i];
+      const int iy = o->surfIy[i];
+      const int iz = o->surfIz[i];
 
       // WAS A SOURCE OF HUGE BUG - due to unzeroed values in surfData arrays. The kid had forgotten to initialize allocated arrays in surfData to zero!!
       //if(o->chi[iz][iy][ix] < 1e-16) continue;
@@ -94,9 +94,9 @@ struct KernelComputeForces : public ObstacleVisitor
       // Actually using the volume integral, since (\iint -P \hat{n} dS) = (\iiint -\nabla P dV). Also, P*\nabla\Chi = \nabla P
       // penalty-accel and surf-force match up if resolution is high enough (200 points per fish)
       const double P = l(ix,iy,iz).p;
-      const double normX = o->surface[i]->dchidx; //*h^3 (multiplied in dchidx)
-      const double normY = o->surface[i]->dchidy; //*h^3 (multiplied in dchidy)
-      const double normZ = o->surface[i]->dchidz; //*h^3 (multiplied in dchidz)
+      const double normX = o->dchidx[i]; //*h^3 (multiplied in dchidx)
+      const double normY = o->dchidy[i]; //*h^3 (multiplied in dchidy)
+      const double normZ = o->dchidz[i]; //*h^3 (multiplied in dchidz)
       const double fXV = D11 * normX + D12 * normY + D13 * normZ;
       const double fYV = D12 * normX + D22 * normY + D23 * normZ;
       const double fZV = D13 * normX + D23 * normY + D33 * normZ;
@@ -112,7 +112,7 @@ struct KernelComputeForces : public ObstacleVisitor
       o->vzDef[i] = o->udef[iz][iy][ix][2]; o->vZ[i] = l(ix,iy,iz).w;
 
       //additive quantities:
-      // o->surface += o->surface[i]->delta;
+      // o->surface += o->delta[i];
       o->gammax += normY*o->vZ[i] - normZ*o->vY[i];
       o->gammay += normZ*o->vX[i] - normX*o->vZ[i];
       o->gammaz += normX*o->vY[i] - normY*o->vX[i];
@@ -213,11 +213,13 @@ void ComputeForces::operator()(const double dt)
   for(int i=0; i<nthreads; ++i)
     K[i] = new KernelComputeForces(sim.nu, sim.dt, sim.obstacle_vector);
 
-  compute<KernelComputeForces>(K);
+  // only the blocks with an obstacle surface need a lab
+  compute<KernelComputeForces>(K, &sim.obstacle_vector->getObstaclesPerBlock());
 
   for(int i=0; i<nthreads; i++) delete K[i];
   // do the final reductions and so on
   sim.obstacle_vector->computeForces();
+  sim.reductions.wait(); // one reduction for all obstacles
   sim.stopProfiler();
   check("ComputeForces");
 }
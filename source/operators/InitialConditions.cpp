@@ -116,17 +116,16 @@ struct InitialPenalization : public ObstacleVisitor
     using UDEFMAT = Real[CUP_BLOCK_SIZE][CUP_BLOCK_SIZE][CUP_BLOCK_SIZE][3];
     #pragma omp parallel
     {
-      const auto& obstblocks = obstacle->getObstacleBlocks();
+      const auto& obstblocks = obstacle->getObstacleBlockList();
       const std::array<double,3> centerOfMass = obstacle->getCenterOfMass();
       const std::array<double,3> uBody = obstacle->getTranslationVelocity();
       const std::array<double,3> omegaBody = obstacle->getAngularVelocity();
 
       #pragma omp for schedule(dynamic)
-      for (size_t i = 0; i < vInfo.size(); ++i)
+      for (size_t i = 0; i < obstblocks.size(); ++i)
       {
-        const BlockInfo& info = vInfo[i];
-        const auto pos = obstblocks[info.blockID];
-        if(pos == nullptr) continue;
+        const BlockInfo& info = vInfo[obstblocks[i].blockID];
+        const auto pos = obstblocks[i].block;
 
         FluidBlock& b = *(FluidBlock*)info.ptrBlock;
         CHI_MAT & __restrict__ CHI = pos->chi;
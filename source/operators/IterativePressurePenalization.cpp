@@ -55,12 +55,11 @@ struct PressureRHSObstacleVisitor : public ObstacleVisitor
   {
     #pragma omp parallel
     {
-      const auto& obstblocks = obstacle->getObstacleBlocks();
+      const auto& obstblocks = obstacle->getObstacleBlockList();
       #pragma omp for schedule(dynamic, 1)
-      for (size_t i = 0; i < vInfo.size(); ++i) {
-        const cubism::BlockInfo& info = vInfo[i];
-        const auto pos = obstblocks[info.blockID];
-        if(pos == nullptr) continue;
+      for (size_t i = 0; i < obstblocks.size(); ++i) {
+        const cubism::BlockInfo& info = vInfo[obstblocks[i].blockID];
+        const auto pos = obstblocks[i].block;
 
         FluidBlock& b = *(FluidBlock*)info.ptrBlock;
         const UDEFMAT & __restrict__ UDEF = pos->udef;
@@ -159,7 +158,7 @@ struct KernelIntegrateFluidMomenta : public ObstacleVisitor
     info_ptr = & info;
     ObstacleVisitor* const base = static_cast<ObstacleVisitor*> (this);
     assert( base not_eq nullptr );
-    obstacle_vector->Accept( base );
+    obstacle_vector->Accept( base, info.blockID );
     info_ptr = nullptr;
   }
 
@@ -258,23 +257,23 @@ struct KernelFinalizeObstacleVel : public ObstacleVisitor
   {
     static constexpr int nQoI = 29;
     double M[nQoI] = { 0 };
-    const auto& oBlock = obst->getObstacleBlocks();
+    const auto& oBlock = obst->getObstacleBlockList();
     #pragma omp parallel for schedule(static,1) reduction(+ : M[:nQoI])
     for (size_t i=0; i<oBlock.size(); i++)
     {
-      if(oBlock[i] == nullptr) continue;
-      M[ 0] += oBlock[i]->V ;
-      M[ 1] += oBlock[i]->FX; M[ 2] += oBlock[i]->FY; M[ 3] += oBlock[i]->FZ;
-      M[ 4] += oBlock[i]->TX; M[ 5] += oBlock[i]->TY; M[ 6] += oBlock[i]->TZ;
-      M[ 7] += oBlock[i]->J0; M[ 8] += oBlock[i]->J1; M[ 9] += oBlock[i]->J2;
-      M[10] += oBlock[i]->J3; M[11] += oBlock[i]->J4; M[12] += oBlock[i]->J5;
+      const ObstacleBlock * const o = oBlock[i].block;
+      M[ 0] += o->V ;
+      M[ 1] += o->FX; M[ 2] += o->FY; M[ 3] += o->FZ;
+      M[ 4] += o->TX; M[ 5] += o->TY; M[ 6] += o->TZ;
+      M[ 7] += o->J0; M[ 8] += o->J1; M[ 9] += o->J2;
+      M[10] += o->J3; M[11] += o->J4; M[12] += o->J5;
       #ifndef EXPL_INTEGRATE_MOM
-        M[13]+= oBlock[i]->GfX;
-        M[14]+= oBlock[i]->GpX; M[15]+= oBlock[i]->GpY; M[16]+= oBlock[i]->GpZ;
-        M[17]+= oBlock[i]->Gj0; M[18]+= oBlock[i]->Gj1; M[19]+= oBlock[i]->Gj2;
-        M[20]+= oBlock[i]->Gj3; M[21]+= oBlock[i]->Gj4; M[22]+= oBlock[i]->Gj5;
-        M[23]+= oBlock[i]->GuX; M[24]+= oBlock[i]->GuY; M[25]+= oBlock[i]->GuZ;
-        M[26]+= oBlock[i]->GaX; M[27]+= oBlock[i]->GaY; M[28]+= oBlock[i]->GaZ;
+        M[13]+= o->GfX;
+        M[14]+= o->GpX; M[15]+= o->GpY; M[16]+= o->GpZ;
+        M[17]+= o->Gj0; M[18]+= o->Gj1; M[19]+= o->Gj2;
+        M[20]+= o->Gj3; M[21]+= o->Gj4; M[22]+= o->Gj5;
+        M[23]+= o->GuX; M[24]+= o->GuY; M[25]+= o->GuZ;
+        M[26]+= o->GaX; M[27]+= o->GaY; M[28]+= o->GaZ;
       #endif
     }
     const auto comm = grid->getCartComm();
@@ -316,12 +315,12 @@ struct KernelFinalizePenalizationForce : public ObstacleVisitor
   {
     static constexpr int nQoI = 6;
     double M[nQoI] = { 0 };
-    const auto& oBlock = obst->getObstacleBlocks();
+    const auto& oBlock = obst->getObstacleBlockList();
     #pragma omp parallel for schedule(static) reduction(+ : M[:nQoI])
     for (size_t i=0; i<oBlock.size(); ++i) {
-      if(oBlock[i] == nullptr) continue;
-      M[0] += oBlock[i]->FX; M[1] += oBlock[i]->FY; M[2] += oBlock[i]->FZ;
-      M[3] += oBlock[i]->TX; M[4] += oBlock[i]->TY; M[5] += oBlock[i]->TZ;
+      const ObstacleBlock * const o = oBlock[i].block;
+      M[0] += o->FX; M[1] += o->FY; M[2] += o->FZ;
+      M[3] += o->TX; M[4] += o->TY; M[5] += o->TZ;
     }
     const auto comm = grid->getCartComm();
     MPI_Allreduce(MPI_IN_PLACE, M, nQoI, MPI_DOUBLE, MPI_SUM, comm);
@@ -352,7 +351,7 @@ struct KernelPenalization : public ObstacleVisitor
     info_ptr = & info;
     ObstacleVisitor* const base = static_cast<ObstacleVisitor*> (this);
     assert( base not_eq nullptr );
-    obstacle_vector->Accept( base );
+    obstacle_vector->Accept( base, info.blockID );
     info_ptr = nullptr;
   }
 
@@ -490,6 +489,27 @@ struct KernelGradP
   }
 };
 
+// translational and angular velocities of all obstacles, 6 per obstacle
+std::vector<double> getObstacleVelocities(ObstacleVector * const obstacles)
+{
+  std::vector<double> vel;
+  for (const auto &obst : obstacles->getObstacleVector()) {
+    vel.insert(vel.end(), obst->transVel, obst->transVel + 3);
+    vel.insert(vel.end(), obst->angVel, obst->angVel + 3);
+  }
+  return vel;
+}
+
+void setObstacleVelocities(ObstacleVector * const obstacles,
+                           const std::vector<double> &vel)
+{
+  size_t i = 0;
+  for (const auto &obst : obstacles->getObstacleVector()) {
+    for (int d = 0; d < 3; ++d) obst->transVel[d] = vel[i++];
+    for (int d = 0; d < 3; ++d) obst->angVel[d] = vel[i++];
+  }
+}
+
 }
 
 void IterativePressurePenalization::initializeFields()
@@ -526,7 +546,7 @@ void IterativePressurePenalization::initializeFields()
 }
 
 IterativePressurePenalization::IterativePressurePenalization(SimulationData& s)
-  : Operator(s)
+  : Operator(s), anderson(s.penalAndersonDepth)
 {
   if(sim.bUseFourierBC)
   pressureSolver = new PoissonSolverPeriodic(sim);
@@ -561,6 +581,8 @@ void IterativePressurePenalization::operator()(const double dt)
   // first copy velocity before either Pres or Penal onto penalization blocks
   // also put udef into tmpU fields
   initializeFields();
+  // the fixed-point map depends on dt and on the obstacles' shapes
+  anderson.reset();
 
   int iter=0;
   Real relDF = 1e3;
@@ -578,17 +600,30 @@ void IterativePressurePenalization::operator()(const double dt)
 
     { // integrate momenta by looping over grid
       sim.startProfiler("Obst Int Vel");
+      // velocities used by the last penalization, input of this iteration
+      const std::vector<double> velIn = getObstacleVelocities(sim.obstacle_vector);
+      // only the blocks touched by an obstacle
+      const std::vector<int>& touched = sim.obstacle_vector->getTouchedBlocks();
       #pragma omp parallel
       { // each thread needs to call its own non-const operator() function
         KernelIntegrateFluidMomenta K(dt, sim.lambda,
             sim.obstacle_vector, penalizationGrid);
         #pragma omp for schedule(dynamic, 1)
-        for (size_t i = 0; i < vInfo.size(); ++i) K(vInfo[i]);
+        for (size_t i = 0; i < touched.size(); ++i) K(vInfo[touched[i]]);
       }
 
       ObstacleVisitor*K = new KernelFinalizeObstacleVel(dt, sim.lambda, sim.grid);
       sim.obstacle_vector->Accept(K); // accept you son of a french cow
       delete K;
+
+      // extrapolate the velocities from the history of the iterations, the
+      // same on all ranks since the momenta are reduced over all of them.
+      // At iter 0 no penalization has run yet in this step: velIn is the
+      // velocity of the last step and not the input which produced the new
+      // one, so that pair is kept out of the history
+      if (anderson.depth() > 0 && iter > 0)
+        setObstacleVelocities(sim.obstacle_vector, anderson.mix(velIn,
+            getObstacleVelocities(sim.obstacle_vector)));
       sim.stopProfiler();
     }
 
@@ -596,11 +631,13 @@ void IterativePressurePenalization::operator()(const double dt)
     {
       sim.startProfiler("Penalization");
       double M[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+      // only the blocks touched by an obstacle
+      const std::vector<int>& touched = sim.obstacle_vector->getTouchedBlocks();
       #pragma omp parallel reduction (+ : M[:6])
       { // each thread needs to call its own non-const operator() function
         KernelPenalization K(sim.lambda, dt, sim.obstacle_vector, iter, penalizationGrid);
         #pragma omp for schedule(dynamic, 1)
-        for (size_t i = 0; i < vInfo.size(); ++i) K(vInfo[i]);
+        for (size_t i = 0; i < touched.size(); ++i) K(vInfo[touched[i]]);
         M[0] += K.MX; M[3] += K.DMX;
         M[1] += K.MY; M[4] += K.DMY;
         M[2] += K.MZ; M[5] += K.DMZ;
@@ -618,7 +655,7 @@ void IterativePressurePenalization::operator()(const double dt)
 
     if(sim.verbose) printf("iter:%02d - max relative error: %f\n", iter, relDF);
     //if(relDF < 0.001) break;
-    if(iter>0 && relDF<0.001) bConverged = true;
+    if(iter>0 && relDF<sim.penalTol) bConverged = true;
 
     {
       sim.startProfiler("PresRHS Kernel");
@@ -649,6 +686,9 @@ void IterativePressurePenalization::operator()(const double dt)
 
     if(bConverged) break;
   }
+  if(sim.verbose)
+    printf("IterativePressurePenalization: %d iterations, relative error %e\n",
+           std::min(iter + 1, 1000), relDF);
 
   sim.startProfiler("GradP"); //pressure correction dudt* = - grad P / rho
   {
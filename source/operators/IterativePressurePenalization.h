@@ -10,6 +10,7 @@
 #define CubismUP_3D_IterativePressurePenalization_h
 
 #include "Operator.h"
+#include "../utils/AndersonMixer.h"
 
 CubismUP_3D_NAMESPACE_BEGIN
 
@@ -18,6 +19,8 @@ class IterativePressurePenalization : public Operator
  protected:
   PoissonSolver * pressureSolver;
   PenalizationGridMPI * penalizationGrid = nullptr;
+  // acceleration of the fixed-point iterations on the obstacle velocities
+  AndersonMixer anderson;
 
   void initializeFields();
 
@@ -23,6 +23,8 @@ class KernelCharacteristicFunction
 {
   using v_v_ob = std::vector<std::vector<ObstacleBlock*>*>;
   const v_v_ob & vec_obstacleBlocks;
+  // obstacles touching each block, the others are skipped
+  const std::vector<std::vector<int>> & obstaclesPerBlock;
 
   public:
   const std::array<int, 3> stencil_start = {-1,-1,-1}, stencil_end = {2, 2, 2};
@@ -46,18 +48,20 @@ class KernelCharacteristicFunction
   }
   */
 
-  KernelCharacteristicFunction(const v_v_ob& v) : vec_obstacleBlocks(v) {}
+  KernelCharacteristicFunction(const v_v_ob& v,
+    const std::vector<std::vector<int>>& o) : vec_obstacleBlocks(v),
+    obstaclesPerBlock(o) {}
 
   template <typename Lab, typename BlockType>
   void operator()(Lab & lab, const BlockInfo& info, BlockType& b) const
   {
     const Real h = info.h_gridpoint, inv2h = .5/h, fac1 = .5*h*h, vol = h*h*h;
 
-    for (size_t obst_id = 0; obst_id<vec_obstacleBlocks.size(); obst_id++)
+    for (const int obst_id : obstaclesPerBlock[info.blockID])
     {
       const auto& obstacleBlocks = * vec_obstacleBlocks[obst_id];
       ObstacleBlock* const o = obstacleBlocks[info.blockID];
-      if(o == nullptr) continue;
+      assert(o != nullptr);
       CHIMAT & __restrict__ CHI = o->chi;
       const CHIMAT & __restrict__ SDF = o->sdf;
       o->CoM_x = 0; o->CoM_y = 0; o->CoM_z = 0; o->mass  = 0;
@@ -140,23 +144,27 @@ class KernelCharacteristicFunction_nonUniform
 {
   using v_v_ob = std::vector<std::vector<ObstacleBlock*>*>;
   const v_v_ob & vec_obstacleBlocks;
+  // obstacles touching each block, the others are skipped
+  const std::vector<std::vector<int>> & obstaclesPerBlock;
 
   public:
   const std::array<int, 3> stencil_start = {-1,-1,-1}, stencil_end = {2, 2, 2};
   const StencilInfo stencil{-1,-1,-1, 2,2,2, false, {{FE_TMPU}}};
 
-  KernelCharacteristicFunction_nonUniform(const v_v_ob& v) : vec_obstacleBlocks(v) {}
+  KernelCharacteristicFunction_nonUniform(const v_v_ob& v,
+    const std::vector<std::vector<int>>& o) : vec_obstacleBlocks(v),
+    obstaclesPerBlock(o) {}
 
   template <typename Lab, typename BlockType>
   void operator()(Lab & lab, const BlockInfo& info, BlockType& b) const
   {
     const BlkCoeffX &cx =b.fd_cx.first, &cy =b.fd_cy.first, &cz =b.fd_cz.first;
 
-    for (size_t obst_id = 0; obst_id<vec_obstacleBlocks.size(); obst_id++)
+    for (const int obst_id : obstaclesPerBlock[info.blockID])
     {
       const auto& obstacleBlocks = * vec_obstacleBlocks[obst_id];
       ObstacleBlock*const o = obstacleBlocks[info.blockID];
-      if(o == nullptr) continue;
+      assert(o != nullptr);
       CHIMAT & __restrict__ CHI = o->chi;
       const CHIMAT & __restrict__ SDF = o->sdf;
       o->CoM_x = 0; o->CoM_y = 0; o->CoM_z = 0; o->mass  = 0;
@@ -237,14 +245,13 @@ struct KernelComputeGridCoM : public ObstacleVisitor
   void visit(Obstacle* const obstacle)
   {
     double com[4] = {0.0, 0.0, 0.0, 0.0};
-    const auto& obstblocks = obstacle->getObstacleBlocks();
+    const auto& obstblocks = obstacle->getObstacleBlockList();
     #pragma omp parallel for schedule(static,1) reduction(+ : com[:4])
     for (size_t i=0; i<obstblocks.size(); i++) {
-      if(obstblocks[i] == nullptr) continue;
-      com[0] += obstblocks[i]->mass;
-      com[1] += obstblocks[i]->CoM_x;
-      com[2] += obstblocks[i]->CoM_y;
-      com[3] += obstblocks[i]->CoM_z;
+      com[0] += obstblocks[i].block->mass;
+      com[1] += obstblocks[i].block->CoM_x;
+      com[2] += obstblocks[i].block->CoM_y;
+      com[3] += obstblocks[i].block->CoM_z;
     }
     MPI_Allreduce(MPI_IN_PLACE, com, 4,MPI_DOUBLE,MPI_SUM, grid->getCartComm());
 
@@ -273,7 +280,7 @@ struct KernelIntegrateUdefMomenta : public ObstacleVisitor
     info_ptr = & info;
     ObstacleVisitor* const base = static_cast<ObstacleVisitor*> (this);
     assert( base not_eq nullptr );
-    obstacle_vector->Accept( base );
+    obstacle_vector->Accept( base, info.blockID );
     info_ptr = nullptr;
   }
 
@@ -343,15 +350,15 @@ struct KernelAccumulateUdefMomenta : public ObstacleVisitor
   void visit(Obstacle* const obst)
   {
     double M[13] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    const auto& oBlock = obst->getObstacleBlocks();
+    const auto& oBlock = obst->getObstacleBlockList();
     #pragma omp parallel for schedule(static,1) reduction(+ : M[:13])
     for (size_t i=0; i<oBlock.size(); i++) {
-      if(oBlock[i] == nullptr) continue;
-      M[ 0] += oBlock[i]->V ;
-      M[ 1] += oBlock[i]->FX; M[ 2] += oBlock[i]->FY; M[ 3] += oBlock[i]->FZ;
-      M[ 4] += oBlock[i]->TX; M[ 5] += oBlock[i]->TY; M[ 6] += oBlock[i]->TZ;
-      M[ 7] += oBlock[i]->J0; M[ 8] += oBlock[i]->J1; M[ 9] += oBlock[i]->J2;
-      M[10] += oBlock[i]->J3; M[11] += oBlock[i]->J4; M[12] += oBlock[i]->J5;
+      const ObstacleBlock * const o = oBlock[i].block;
+      M[ 0] += o->V ;
+      M[ 1] += o->FX; M[ 2] += o->FY; M[ 3] += o->FZ;
+      M[ 4] += o->TX; M[ 5] += o->TY; M[ 6] += o->TZ;
+      M[ 7] += o->J0; M[ 8] += o->J1; M[ 9] += o->J2;
+      M[10] += o->J3; M[11] += o->J4; M[12] += o->J5;
     }
     const auto comm = grid->getCartComm();
     MPI_Allreduce(MPI_IN_PLACE, M, 13, MPI_DOUBLE, MPI_SUM, comm);
@@ -412,14 +419,13 @@ struct KernelRemoveUdefMomenta : public ObstacleVisitor
     #endif
 
     const std::array<double,3> CM = obstacle->getCenterOfMass();
-    const auto & obstacleBlocks = obstacle->getObstacleBlocks();
+    const auto & obstacleBlocks = obstacle->getObstacleBlockList();
 
     #pragma omp parallel for schedule(dynamic, 1)
-    for(size_t i=0; i < vInfo.size(); i++)
+    for(size_t i=0; i < obstacleBlocks.size(); i++)
     {
-      const BlockInfo& info = vInfo[i];
-      const auto pos = obstacleBlocks[info.blockID];
-      if(pos == nullptr) continue;
+      const BlockInfo& info = vInfo[obstacleBlocks[i].blockID];
+      const auto pos = obstacleBlocks[i].block;
       UDEFMAT & __restrict__ UDEF = pos->udef;
       for(int iz=0; iz<FluidBlock::sizeZ; ++iz)
       for(int iy=0; iy<FluidBlock::sizeY; ++iy)
@@ -441,6 +447,18 @@ struct KernelRemoveUdefMomenta : public ObstacleVisitor
 
 }
 
+unsigned CreateObstacles::reads() const
+{
+  if(sim.obstacle_vector->nObstacles() == 0) return DATA_NONE;
+  return DATA_OBSTACLES | DATA_UINF;
+}
+
+unsigned CreateObstacles::writes() const
+{
+  if(sim.obstacle_vector->nObstacles() == 0) return DATA_NONE;
+  return DATA_CHI | DATA_TMP | DATA_OBSTACLES | DATA_UINF;
+}
+
 void CreateObstacles::operator()(const double dt)
 {
   if(sim.obstacle_vector->nObstacles() == 0) return;
@@ -473,14 +491,16 @@ void CreateObstacles::operator()(const double dt)
   if(sim.bUseStretchedGrid)
   {
     auto vecOB = sim.obstacle_vector->getAllObstacleBlocks();
-    const KernelCharacteristicFunction_nonUniform K(vecOB);
-    compute<KernelCharacteristicFunction_nonUniform>(K);
+    const auto& obstaclesPerBlock = sim.obstacle_vector->getObstaclesPerBlock();
+    const KernelCharacteristicFunction_nonUniform K(vecOB, obstaclesPerBlock);
+    compute<KernelCharacteristicFunction_nonUniform>(K, &obstaclesPerBlock);
   }
   else
   {
     auto vecOB = sim.obstacle_vector->getAllObstacleBlocks();
-    const KernelCharacteristicFunction K(vecOB);
-    compute<KernelCharacteristicFunction>(K);
+    const auto& obstaclesPerBlock = sim.obstacle_vector->getObstaclesPerBlock();
+    const KernelCharacteristicFunction K(vecOB, obstaclesPerBlock);
+    compute<KernelCharacteristicFunction>(K, &obstaclesPerBlock);
   }
   sim.stopProfiler();
 
@@ -494,11 +514,13 @@ void CreateObstacles::operator()(const double dt)
 
   sim.startProfiler("Obst Int Mom");
   { // integrate momenta by looping over grid
+    // only the blocks touched by an obstacle
+    const std::vector<int>& touched = sim.obstacle_vector->getTouchedBlocks();
     #pragma omp parallel
     { // each thread needs to call its own non-const operator() function
       KernelIntegrateUdefMomenta K(sim.obstacle_vector);
       #pragma omp for schedule(dynamic, 1)
-      for (size_t i = 0; i < vInfo.size(); ++i) K(vInfo[i]);
+      for (size_t i = 0; i < touched.size(); ++i) K(vInfo[touched[i]]);
     }
   }
   sim.stopProfiler();
@@ -521,11 +543,13 @@ void CreateObstacles::operator()(const double dt)
 
   #ifndef NDEBUG
   { // integrate momenta by looping over grid
+    // only the blocks touched by an obstacle
+    const std::vector<int>& touched = sim.obstacle_vector->getTouchedBlocks();
     #pragma omp parallel
     { // each thread needs to call its own non-const operator() function
       KernelIntegrateUdefMomenta K(sim.obstacle_vector);
       #pragma omp for schedule(dynamic, 1)
-      for (size_t i = 0; i < vInfo.size(); ++i) K(vInfo[i]);
+      for (size_t i = 0; i < touched.size(); ++i) K(vInfo[touched[i]]);
     }
     ObstacleVisitor* visitor = new KernelAccumulateUdefMomenta(grid, true);
     sim.obstacle_vector->Accept(visitor);
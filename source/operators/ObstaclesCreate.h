@@ -21,6 +21,9 @@ class CreateObstacles : public Operator
   void operator()(const double dt);
 
   std::string getName() { return "CreateObstacles"; }
+
+  unsigned reads() const override;
+  unsigned writes() const override;
 };
 
 CubismUP_3D_NAMESPACE_END
@@ -42,7 +42,7 @@ struct KernelIntegrateFluidMomenta : public ObstacleVisitor
     info_ptr = & info;
     ObstacleVisitor* const base = static_cast<ObstacleVisitor*> (this);
     assert( base not_eq nullptr );
-    obstacle_vector->Accept( base );
+    obstacle_vector->Accept( base, info.blockID );
     info_ptr = nullptr;
   }
 
@@ -134,38 +134,43 @@ template<bool implicitPenalization>
 struct KernelFinalizeObstacleVel : public ObstacleVisitor
 {
   const double dt, lambda;
-  FluidGridMPI * const grid;
+  ReductionRegistry & reductions;
 
-  KernelFinalizeObstacleVel(double _dt, double _lambda, FluidGridMPI*g) :
-    dt(_dt), lambda(_lambda), grid(g) { }
+  KernelFinalizeObstacleVel(double _dt, double _lambda, ReductionRegistry&r) :
+    dt(_dt), lambda(_lambda), reductions(r) { }
 
   void visit(Obstacle* const obst)
   {
     static constexpr int nQoI = 29;
     double M[nQoI] = { 0 };
-    const auto& oBlock = obst->getObstacleBlocks();
+    const auto& oBlock = obst->getObstacleBlockList();
     #pragma omp parallel for schedule(static,1) reduction(+ : M[:nQoI])
     for (size_t i=0; i<oBlock.size(); i++) {
-      if(oBlock[i] == nullptr) continue;
+      const ObstacleBlock * const o = oBlock[i].block;
       int k = 0;
-      M[k++] += oBlock[i]->V ;
-      M[k++] += oBlock[i]->FX; M[k++] += oBlock[i]->FY; M[k++] += oBlock[i]->FZ;
-      M[k++] += oBlock[i]->TX; M[k++] += oBlock[i]->TY; M[k++] += oBlock[i]->TZ;
-      M[k++] += oBlock[i]->J0; M[k++] += oBlock[i]->J1; M[k++] += oBlock[i]->J2;
-      M[k++] += oBlock[i]->J3; M[k++] += oBlock[i]->J4; M[k++] += oBlock[i]->J5;
+      M[k++] += o->V ;
+      M[k++] += o->FX; M[k++] += o->FY; M[k++] += o->FZ;
+      M[k++] += o->TX; M[k++] += o->TY; M[k++] += o->TZ;
+      M[k++] += o->J0; M[k++] += o->J1; M[k++] += o->J2;
+      M[k++] += o->J3; M[k++] += o->J4; M[k++] += o->J5;
       if(implicitPenalization) {
-      M[k++] +=oBlock[i]->GfX;
-      M[k++] +=oBlock[i]->GpX; M[k++] +=oBlock[i]->GpY; M[k++] +=oBlock[i]->GpZ;
-      M[k++] +=oBlock[i]->Gj0; M[k++] +=oBlock[i]->Gj1; M[k++] +=oBlock[i]->Gj2;
-      M[k++] +=oBlock[i]->Gj3; M[k++] +=oBlock[i]->Gj4; M[k++] +=oBlock[i]->Gj5;
-      M[k++] +=oBlock[i]->GuX; M[k++] +=oBlock[i]->GuY; M[k++] +=oBlock[i]->GuZ;
-      M[k++] +=oBlock[i]->GaX; M[k++] +=oBlock[i]->GaY; M[k++] +=oBlock[i]->GaZ;
+      M[k++] +=o->GfX;
+      M[k++] +=o->GpX; M[k++] +=o->GpY; M[k++] +=o->GpZ;
+      M[k++] +=o->Gj0; M[k++] +=o->Gj1; M[k++] +=o->Gj2;
+      M[k++] +=o->Gj3; M[k++] +=o->Gj4; M[k++] +=o->Gj5;
+      M[k++] +=o->GuX; M[k++] +=o->GuY; M[k++] +=o->GuZ;
+      M[k++] +=o->GaX; M[k++] +=o->GaY; M[k++] +=o->GaZ;
       assert(k==29);
       } else  assert(k==13);
     }
-    const auto comm = grid->getCartComm();
-    MPI_Allreduce(MPI_IN_PLACE, M, nQoI, MPI_DOUBLE, MPI_SUM, comm);
+    // reduced together for all obstacles, see UpdateObstacles::operator()
+    reductions.enqueue(M, nQoI, MPI_SUM, [obst](const double * sum) {
+      finalize(obst, sum);
+    });
+  }
 
+  static void finalize(Obstacle* const obst, const double * const M)
+  {
     #ifndef NDEBUG
       const Real J_magnitude = obst->J[0] + obst->J[1] + obst->J[2];
       static constexpr Real EPS = std::numeric_limits<Real>::epsilon();
@@ -205,16 +210,18 @@ void UpdateObstacles::operator()(const double dt)
 
   sim.startProfiler("Obst Int Vel");
   { // integrate momenta by looping over grid
+    // only the blocks touched by an obstacle
+    const std::vector<int>& touched = sim.obstacle_vector->getTouchedBlocks();
     #pragma omp parallel
     { // each thread needs to call its own non-const operator() function
       if(sim.bImplicitPenalization) {
         KernelIntegrateFluidMomenta<1> K(dt, sim.lambda, sim.obstacle_vector);
         #pragma omp for schedule(dynamic, 1)
-        for (size_t i = 0; i < vInfo.size(); ++i) K(vInfo[i]);
+        for (size_t i = 0; i < touched.size(); ++i) K(vInfo[touched[i]]);
       } else {
         KernelIntegrateFluidMomenta<0> K(dt, sim.lambda, sim.obstacle_vector);
         #pragma omp for schedule(dynamic, 1)
-        for (size_t i = 0; i < vInfo.size(); ++i) K(vInfo[i]);
+        for (size_t i = 0; i < touched.size(); ++i) K(vInfo[touched[i]]);
       }
     }
   }
@@ -222,14 +229,15 @@ void UpdateObstacles::operator()(const double dt)
 
   sim.startProfiler("Obst Upd Vel");
   if(sim.bImplicitPenalization) {
-    ObstacleVisitor*K= new KernelFinalizeObstacleVel<1>(dt,sim.lambda,sim.grid);
+    ObstacleVisitor*K= new KernelFinalizeObstacleVel<1>(dt,sim.lambda,sim.reductions);
     sim.obstacle_vector->Accept(K); // accept you son of a french cow
     delete K;
   } else {
-    ObstacleVisitor*K= new KernelFinalizeObstacleVel<0>(dt,sim.lambda,sim.grid);
+    ObstacleVisitor*K= new KernelFinalizeObstacleVel<0>(dt,sim.lambda,sim.reductions);
     sim.obstacle_vector->Accept(K); // accept you son of a french cow
     delete K;
   }
+  sim.reductions.wait(); // computes the velocities of the obstacles
   sim.stopProfiler();
 
   check("UpdateObstacles");
@@ -10,9 +10,26 @@
 #define CubismUP_3D_Operator_h
 
 #include "../SimulationData.h"
+#include "../utils/TraceRecorder.h"
 
 CubismUP_3D_NAMESPACE_BEGIN
 
+// Data read or written by an operator, used by the OperatorScheduler to find
+// which operators may be reordered.
+enum OperatorData : unsigned
+{
+  DATA_NONE      = 0,
+  DATA_CHI       = 1 << 0, // chi
+  DATA_VEL       = 1 << 1, // u, v, w
+  DATA_PRES      = 1 << 2, // p
+  DATA_TMP       = 1 << 3, // tmpU, tmpV, tmpW
+  DATA_OBSTACLES = 1 << 4, // obstacle state, obstacle blocks, forces
+  DATA_UINF      = 1 << 5, // uinf and the other global flow quantities
+  DATA_POISSON   = 1 << 6, // pressure solver buffers
+  DATA_SPECTRAL  = 1 << 7, // spectral manipulator buffers
+  DATA_ALL       = ~0u
+};
+
 class Operator
 {
  protected:
@@ -49,124 +66,84 @@ class Operator
     #endif
   }
 
+  // Blocks per obstacle, see ObstacleVector::getObstaclesPerBlock.
+  using ObstaclesPerBlock = std::vector<std::vector<int>>;
+
   template <typename Kernel>
-  void compute(const std::vector<Kernel*>& kernels)
+  void _process(const std::vector<cubism::BlockInfo>& all,
+                const std::vector<Kernel*>& kernels,
+                const std::vector<LabMPI*>& labs,
+                const ObstaclesPerBlock * const obstaclesPerBlock)
   {
-    cubism::SynchronizerMPI<Real>& Synch = grid->sync(*(kernels[0]));
-    const int nthreads = omp_get_max_threads();
-    LabMPI * labs = new LabMPI[nthreads];
-    #pragma omp parallel for schedule(static, 1)
-    for(int i = 0; i < nthreads; ++i) {
-      labs[i].setBC(sim.BCx_flag, sim.BCy_flag, sim.BCz_flag);
-      labs[i].prepare(* sim.grid, Synch);
-    }
-
-    int rank;
-    MPI_Comm_rank(grid->getCartComm(), &rank);
-    MPI_Barrier(grid->getCartComm());
-    std::vector<cubism::BlockInfo> avail0 = Synch.avail_inner();
-    const int Ninner = avail0.size();
-
+    std::vector<cubism::BlockInfo> touched;
+    if(obstaclesPerBlock != nullptr)
+      for(const cubism::BlockInfo& I : all)
+        if(not (*obstaclesPerBlock)[I.blockID].empty()) touched.push_back(I);
+    const std::vector<cubism::BlockInfo>& avail =
+        obstaclesPerBlock != nullptr ? touched : all;
+    const int N = avail.size();
+    // per-thread sections: the gaps in the trace are the imbalance
+    TraceRecorder * const trace = sim.trace;
+    const int traceId = trace ? trace->intern("Blocks") : -1;
     #pragma omp parallel
     {
       int tid = omp_get_thread_num();
-      Kernel& kernel = * (kernels[tid]); LabMPI& lab = labs[tid];
+      Kernel& kernel = * (kernels[tid]); LabMPI& lab = * labs[tid];
+      if(trace) trace->begin(traceId);
 
-      #pragma omp for schedule(static)
-      for(int i=0; i<Ninner; i++) {
-        const cubism::BlockInfo& I = avail0[i];
+      #pragma omp for schedule(static) nowait
+      for(int i=0; i<N; i++) {
+        const cubism::BlockInfo& I = avail[i];
         FluidBlock& b = *(FluidBlock*)I.ptrBlock;
         lab.load(I, 0);
         kernel(lab, I, b);
       }
+      if(trace) trace->end();
     }
-
-    if(sim.nprocs>1)
-    {
-      std::vector<cubism::BlockInfo> avail1 = Synch.avail_halo();
-      const int Nhalo = avail1.size();
-
-      #pragma omp parallel
-      {
-        int tid = omp_get_thread_num();
-        Kernel& kernel = * (kernels[tid]); LabMPI& lab = labs[tid];
-
-        #pragma omp for schedule(static)
-        for(int i=0; i<Nhalo; i++) {
-          const cubism::BlockInfo& I = avail1[i];
-          FluidBlock& b = *(FluidBlock*)I.ptrBlock;
-          lab.load(I, 0);
-          kernel(lab, I, b);
-        }
-      }
-    }
-
-    if(labs!=NULL) {
-      delete [] labs;
-      labs=NULL;
-    }
-
-    MPI_Barrier(grid->getCartComm());
   }
 
+  // If `obstaclesPerBlock` is given, only the blocks touched by an obstacle
+  // are loaded and processed, the ghosts are exchanged as usual.
   template <typename Kernel>
-  void compute(const Kernel& kernel)
+  void compute(const std::vector<Kernel*>& kernels,
+               const ObstaclesPerBlock * const obstaclesPerBlock = nullptr)
   {
-    cubism::SynchronizerMPI<Real>& Synch = grid->sync(kernel);
-    const int nthreads = omp_get_max_threads();
-    LabMPI * labs = new LabMPI[nthreads];
-    #pragma omp parallel for schedule(static, 1)
-    for(int i = 0; i < nthreads; ++i) {
-      labs[i].setBC(sim.BCx_flag, sim.BCy_flag, sim.BCz_flag);
-      labs[i].prepare(* sim.grid, Synch);
-    }
-
-    int rank;
-    MPI_Comm_rank(grid->getCartComm(), &rank);
-    MPI_Barrier(grid->getCartComm());
-    std::vector<cubism::BlockInfo> avail0 = Synch.avail_inner();
-    const int Ninner = avail0.size();
-
-    #pragma omp parallel
-    {
-      int tid = omp_get_thread_num();
-      LabMPI& lab = labs[tid];
+    cubism::SynchronizerMPI<Real>& Synch = grid->sync(*(kernels[0]));
+    const std::vector<LabMPI*>& labs = sim.getLabs(kernels[0]->stencil, Synch);
 
-      #pragma omp for schedule(static)
-      for(int i=0; i<Ninner; i++) {
-        const cubism::BlockInfo I = avail0[i];
-        FluidBlock& b = *(FluidBlock*)I.ptrBlock;
-        lab.load(I, 0);
-        kernel(lab, I, b);
-      }
-    }
+    // Blocks whose stencil does not leave the rank, overlapped with the
+    // ghost exchange posted by `sync`:
+    _process(Synch.avail_inner(), kernels, labs, obstaclesPerBlock);
 
     if(sim.nprocs>1)
     {
-      std::vector<cubism::BlockInfo> avail1 = Synch.avail_halo();
-      const int Nhalo = avail1.size();
-
-      #pragma omp parallel
+      if(sim.bAsyncOperators)
       {
-        int tid = omp_get_thread_num();
-        LabMPI& lab = labs[tid];
-
-        #pragma omp for schedule(static)
-        for(int i=0; i<Nhalo; i++) {
-          const cubism::BlockInfo I = avail1[i];
-          FluidBlock& b = *(FluidBlock*)I.ptrBlock;
-          lab.load(I, 0);
-          kernel(lab, I, b);
+        // Process halo blocks in batches as soon as their ghosts arrive,
+        // rather than waiting for the whole exchange to complete.
+        const int nthreads = omp_get_max_threads();
+        while(true) {
+          const std::vector<cubism::BlockInfo> avail1 = Synch.avail(nthreads);
+          if(avail1.size() == 0) break;
+          _process(avail1, kernels, labs, obstaclesPerBlock);
         }
       }
+      // Waits for all the remaining ghosts (all of them in synchronous mode):
+      _process(Synch.avail_halo(), kernels, labs, obstaclesPerBlock);
     }
 
-    if(labs != nullptr) {
-      delete [] labs;
-      labs = nullptr;
-    }
+    // Correctness does not require this barrier (`sync` waits for its own
+    // pending sends), but it keeps the per-operator profiler timings free of
+    // imbalance inherited from the previous operator.
+    if(not sim.bAsyncOperators) MPI_Barrier(grid->getCartComm());
+  }
 
-    MPI_Barrier(grid->getCartComm());
+  template <typename Kernel>
+  void compute(const Kernel& kernel,
+               const ObstaclesPerBlock * const obstaclesPerBlock = nullptr)
+  {
+    const std::vector<const Kernel*> kernels(omp_get_max_threads(), & kernel);
+    compute(kernels, obstaclesPerBlock);
   }
 
 public:
@@ -174,6 +151,15 @@ public:
   virtual ~Operator() = default;
   virtual void operator()(const double dt) = 0;
   virtual std::string getName() = 0;
+
+  // Data accessed by the operator. The default is conservative: operators
+  // that do not declare their accesses are never reordered.
+  virtual unsigned reads() const { return DATA_ALL; }
+  virtual unsigned writes() const { return DATA_ALL; }
+
+  // Diagnostics only produce output. With `-deferDiagnostics` they may run
+  // later than their position in the pipeline, see OperatorScheduler.
+  virtual bool isDiagnostic() const { return false; }
 };
 
 CubismUP_3D_NAMESPACE_END
@@ -0,0 +1,62 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "OperatorScheduler.h"
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+// Whether `later` must run after `earlier` (read-after-write, write-after-read
+// or write-after-write on any of the declared data).
+static bool dependsOn(const Operator &later, const Operator &earlier)
+{
+  return (later.reads() & earlier.writes())
+      || (later.writes() & (earlier.reads() | earlier.writes()));
+}
+
+void OperatorScheduler::run(const std::vector<Operator*> &pipeline,
+                            const double dt)
+{
+  for (Operator *op : pipeline) {
+    drainConflicting(*op);
+    if (sim.bDeferDiagnostics && op->isDiagnostic())
+      deferred_.push_back(Deferred{op, dt, sim.step, sim.time});
+    else
+      (*op)(dt);
+  }
+}
+
+void OperatorScheduler::drain()
+{
+  for (const Deferred &d : deferred_) runDeferred(d);
+  deferred_.clear();
+}
+
+void OperatorScheduler::drainConflicting(const Operator &next)
+{
+  // Deferred operators keep their relative order, so everything before the
+  // last conflicting one runs as well. An operator that is still pending
+  // from the previous step conflicts with itself.
+  int last = -1;
+  for (int i = 0; i < (int)deferred_.size(); ++i)
+    if (deferred_[i].op == &next || dependsOn(next, *deferred_[i].op))
+      last = i;
+  for (int i = 0; i <= last; ++i) runDeferred(deferred_[i]);
+  deferred_.erase(deferred_.begin(), deferred_.begin() + last + 1);
+}
+
+void OperatorScheduler::runDeferred(const Deferred &d)
+{
+  // diagnostics label their output with the step they were scheduled in
+  const int step = sim.step;
+  const double time = sim.time;
+  sim.step = d.step;
+  sim.time = d.time;
+  (*d.op)(d.dt);
+  sim.step = step;
+  sim.time = time;
+}
+
+CubismUP_3D_NAMESPACE_END
@@ -0,0 +1,60 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_OperatorScheduler_h
+#define CubismUP_3D_OperatorScheduler_h
+
+#include "Operator.h"
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+/*
+ * Runs the operator pipeline of one time step.
+ *
+ * Without `-deferDiagnostics` the operators run in pipeline order. With it,
+ * each diagnostic operator is deferred until the first operator (possibly of
+ * the next step) which writes data it reads, or accesses data it writes, and
+ * runs right before that operator. A deferred operator therefore sees exactly
+ * the data it would have seen in pipeline order, as well as the step and time
+ * at which it was scheduled. This only reorders the work, it does not overlap
+ * it with anything. Code outside of the pipeline which modifies the fields
+ * must call drain() first.
+ *
+ * The order only depends on the declared accesses, so it is the same on all
+ * ranks and collective calls issued by the operators stay matched.
+ */
+class OperatorScheduler
+{
+public:
+  OperatorScheduler(SimulationData & s) : sim(s) { }
+
+  /* Run `pipeline` for a step of size `dt`. */
+  void run(const std::vector<Operator*> &pipeline, double dt);
+
+  /* Run all deferred operators. */
+  void drain();
+
+  bool empty() const { return deferred_.empty(); }
+
+private:
+  struct Deferred {
+    Operator *op;
+    double dt;
+    int step;
+    double time;
+  };
+
+  /* Run the deferred operators up to and including the last one which must
+     run before `next`. */
+  void drainConflicting(const Operator &next);
+  void runDeferred(const Deferred &d);
+
+  SimulationData & sim;
+  std::vector<Deferred> deferred_;
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_OperatorScheduler_h
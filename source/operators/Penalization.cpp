@@ -16,6 +16,7 @@ namespace {
 
 using CHIMAT = Real[CUP_BLOCK_SIZE][CUP_BLOCK_SIZE][CUP_BLOCK_SIZE];
 using UDEFMAT = Real[CUP_BLOCK_SIZE][CUP_BLOCK_SIZE][CUP_BLOCK_SIZE][3];
+static constexpr double LOWEST = - std::numeric_limits<double>::max();
 
 template<bool implicitPenalization>
 struct KernelPenalization : public ObstacleVisitor
@@ -23,6 +24,8 @@ struct KernelPenalization : public ObstacleVisitor
   const Real dt, invdt = 1.0/dt, lambda;
   ObstacleVector * const obstacle_vector;
   const cubism::BlockInfo * info_ptr = nullptr;
+  // extrema of the penalized velocity (see SimulationData::velExtrema)
+  double velExt[6] = {LOWEST, LOWEST, LOWEST, LOWEST, LOWEST, LOWEST};
 
   KernelPenalization(double _dt, double _lambda, ObstacleVector* ov) :
     dt(_dt), lambda(_lambda), obstacle_vector(ov) {}
@@ -33,7 +36,7 @@ struct KernelPenalization : public ObstacleVisitor
     info_ptr = & info;
     ObstacleVisitor* const base = static_cast<ObstacleVisitor*> (this);
     assert( base not_eq nullptr );
-    obstacle_vector->Accept( base );
+    obstacle_vector->Accept( base, info.blockID );
     info_ptr = nullptr;
   }
 
@@ -89,6 +92,12 @@ struct KernelPenalization : public ObstacleVisitor
       b(ix,iy,iz).u = b(ix,iy,iz).u + dt * FPX;
       b(ix,iy,iz).v = b(ix,iy,iz).v + dt * FPY;
       b(ix,iy,iz).w = b(ix,iy,iz).w + dt * FPZ;
+      velExt[0] = std::max(velExt[0], (double)   b(ix,iy,iz).u);
+      velExt[1] = std::max(velExt[1], (double)   b(ix,iy,iz).v);
+      velExt[2] = std::max(velExt[2], (double)   b(ix,iy,iz).w);
+      velExt[3] = std::max(velExt[3], (double) - b(ix,iy,iz).u);
+      velExt[4] = std::max(velExt[4], (double) - b(ix,iy,iz).v);
+      velExt[5] = std::max(velExt[5], (double) - b(ix,iy,iz).w);
 
       FX += dv * FPX; FY += dv * FPY; FZ += dv * FPZ;
       TX += dv * ( p[1] * FPZ - p[2] * FPY );
@@ -100,25 +109,26 @@ struct KernelPenalization : public ObstacleVisitor
 
 struct KernelFinalizePenalizationForce : public ObstacleVisitor
 {
-  FluidGridMPI * const grid;
+  ReductionRegistry & reductions;
 
-  KernelFinalizePenalizationForce(FluidGridMPI*g) : grid(g) { }
+  KernelFinalizePenalizationForce(ReductionRegistry&r) : reductions(r) { }
 
   void visit(Obstacle* const obst)
   {
     static constexpr int nQoI = 6;
     double M[nQoI] = { 0 };
-    const auto& oBlock = obst->getObstacleBlocks();
+    const auto& oBlock = obst->getObstacleBlockList();
     #pragma omp parallel for schedule(static) reduction(+ : M[:nQoI])
     for (size_t i=0; i<oBlock.size(); ++i) {
-      if(oBlock[i] == nullptr) continue;
-      M[0] += oBlock[i]->FX; M[1] += oBlock[i]->FY; M[2] += oBlock[i]->FZ;
-      M[3] += oBlock[i]->TX; M[4] += oBlock[i]->TY; M[5] += oBlock[i]->TZ;
+      const ObstacleBlock * const o = oBlock[i].block;
+      M[0] += o->FX; M[1] += o->FY; M[2] += o->FZ;
+      M[3] += o->TX; M[4] += o->TY; M[5] += o->TZ;
     }
-    const auto comm = grid->getCartComm();
-    MPI_Allreduce(MPI_IN_PLACE, M, nQoI, MPI_DOUBLE, MPI_SUM, comm);
-    obst->force[0]  = M[0]; obst->force[1]  = M[1]; obst->force[2]  = M[2];
-    obst->torque[0] = M[3]; obst->torque[1] = M[4]; obst->torque[2] = M[5];
+    // reduced together for all obstacles, see Penalization::operator()
+    reductions.enqueue(M, nQoI, MPI_SUM, [obst](const double * sum) {
+      obst->force[0]  = sum[0]; obst->force[1]  = sum[1]; obst->force[2]  = sum[2];
+      obst->torque[0] = sum[3]; obst->torque[1] = sum[4]; obst->torque[2] = sum[5];
+    });
   }
 };
 
@@ -128,28 +138,43 @@ Penalization::Penalization(SimulationData & s) : Operator(s) {}
 
 void Penalization::operator()(const double dt)
 {
-  if(sim.obstacle_vector->nObstacles() == 0) return;
+  // GradP measured the velocity outside of obstacles, unless FixedMassFlux
+  // changes it again this is the final velocity of the step
+  const bool bPostExtrema = not sim.bChannelFixedMassFlux;
+  if(sim.obstacle_vector->nObstacles() == 0) {
+    if(bPostExtrema) sim.postVelocityExtrema();
+    return;
+  }
 
   sim.startProfiler("Penalization");
+  // only the blocks touched by an obstacle
+  const std::vector<int>& touched = sim.obstacle_vector->getTouchedBlocks();
   #pragma omp parallel
   { // each thread needs to call its own non-const operator() function
     if(sim.bImplicitPenalization)
     {
       KernelPenalization<1> K(dt, sim.lambda, sim.obstacle_vector);
       #pragma omp for schedule(dynamic, 1)
-      for (size_t i = 0; i < vInfo.size(); ++i) K(vInfo[i]);
+      for (size_t i = 0; i < touched.size(); ++i) K(vInfo[touched[i]]);
+      #pragma omp critical
+      sim.accumulateVelocityExtrema(K.velExt);
     }
     else
     {
       KernelPenalization<0> K(dt, sim.lambda, sim.obstacle_vector);
       #pragma omp for schedule(dynamic, 1)
-      for (size_t i = 0; i < vInfo.size(); ++i) K(vInfo[i]);
+      for (size_t i = 0; i < touched.size(); ++i) K(vInfo[touched[i]]);
+      #pragma omp critical
+      sim.accumulateVelocityExtrema(K.velExt);
     }
   }
 
-  ObstacleVisitor*K = new KernelFinalizePenalizationForce(sim.grid);
+  ObstacleVisitor*K = new KernelFinalizePenalizationForce(sim.reductions);
   sim.obstacle_vector->Accept(K); // accept you son of a french cow
   delete K;
+  sim.reductions.wait(); // penalization forces of all obstacles at once
+  // not needed before the next step, posted with the diagnostics at step end
+  if(bPostExtrema) sim.postVelocityExtrema();
 
   sim.stopProfiler();
   check("Penalization");
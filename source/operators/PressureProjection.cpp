@@ -13,82 +13,160 @@
 #else
 #include "../poisson/PoissonSolverPeriodic.h"
 #include "../poisson/PoissonSolverUnbounded.h"
+#include "../poisson/PoissonSolverMixedPencil.h"
+#include "../poisson/PoissonSolverUnboundedPencil.h"
 #endif
 // TODO : Cosine transform on GPU!?
 #include "../poisson/PoissonSolverMixed.h"
 #include "../poisson/PoissonSolverHYPREMixed.h"
 #include "../poisson/PoissonSolverPETSCMixed.h"
+#include "../poisson/PoissonSolverMultigrid.h"
+#include "../poisson/PoissonSolverKrylov.h"
 
 CubismUP_3D_NAMESPACE_BEGIN
 using namespace cubism;
 
 namespace {
 
-class KernelGradP
-{
-  const Real dt;
- public:
-  const std::array<int, 3> stencil_start = {-1,-1,-1}, stencil_end = {2, 2, 2};
-  const StencilInfo stencil{-1,-1,-1, 2,2,2, false, {{FE_P}}};
+static constexpr double LOWEST = - std::numeric_limits<double>::max();
 
-  KernelGradP(double _dt, const std::array<Real, 3> &ext): dt(_dt) {}
+template <typename Element>
+inline void updateExtrema(double ext[6], const Element & E)
+{
+  ext[0] = std::max(ext[0], (double)  E.u);
+  ext[1] = std::max(ext[1], (double)  E.v);
+  ext[2] = std::max(ext[2], (double)  E.w);
+  ext[3] = std::max(ext[3], (double) -E.u);
+  ext[4] = std::max(ext[4], (double) -E.v);
+  ext[5] = std::max(ext[5], (double) -E.w);
+}
 
-  ~KernelGradP() {}
+struct KernelGradP
+{
+  const Real dt;
 
-  template <typename Lab, typename BlockType>
-  void operator()(Lab & lab, const BlockInfo& info, BlockType& o) const
+  void operator()(FluidElement& E, const BlockInfo& info, const FluidBlock& o,
+    const int ix, const int iy, const int iz, const Real pC,
+    const Real pW, const Real pE, const Real pS, const Real pN,
+    const Real pF, const Real pB) const
   {
     const Real fac = - 0.5 * dt / info.h_gridpoint;
-    for(int iz=0; iz<FluidBlock::sizeZ; ++iz)
-    for(int iy=0; iy<FluidBlock::sizeY; ++iy)
-    for(int ix=0; ix<FluidBlock::sizeX; ++ix) {
-       // p contains the pressure correction after the Poisson solver
-       o(ix,iy,iz).u += fac*(lab(ix+1,iy,iz).p-lab(ix-1,iy,iz).p);
-       o(ix,iy,iz).v += fac*(lab(ix,iy+1,iz).p-lab(ix,iy-1,iz).p);
-       o(ix,iy,iz).w += fac*(lab(ix,iy,iz+1).p-lab(ix,iy,iz-1).p);
-    }
+    E.u += fac * (pE - pW);
+    E.v += fac * (pN - pS);
+    E.w += fac * (pB - pF);
   }
 };
 
-class KernelGradP_nonUniform
+struct KernelGradP_nonUniform
 {
   const Real dt;
- public:
-  const std::array<int, 3> stencil_start = {-1,-1,-1}, stencil_end = {2, 2, 2};
-  const StencilInfo stencil{-1,-1,-1, 2,2,2, false, {{FE_P}}};
-
-  KernelGradP_nonUniform(double _dt, const std::array<Real, 3> &ext): dt(_dt) {}
 
-  template <typename Lab, typename BlockType>
-  void operator()(Lab & lab, const BlockInfo& info, BlockType& o) const
+  void operator()(FluidElement& E, const BlockInfo& info, const FluidBlock& o,
+    const int ix, const int iy, const int iz, const Real pC,
+    const Real pW, const Real pE, const Real pS, const Real pN,
+    const Real pF, const Real pB) const
   {
     // FD coefficients for first derivative
     const BlkCoeffX& cx = o.fd_cx.first;
     const BlkCoeffY& cy = o.fd_cy.first;
     const BlkCoeffZ& cz = o.fd_cz.first;
-    for(int iz=0; iz<FluidBlock::sizeZ; ++iz)
-    for(int iy=0; iy<FluidBlock::sizeY; ++iy)
-    for(int ix=0; ix<FluidBlock::sizeX; ++ix) {
-      const FluidElement &L =lab(ix,iy,iz);
-      const FluidElement &LW=lab(ix-1,iy,iz), &LE=lab(ix+1,iy,iz);
-      const FluidElement &LS=lab(ix,iy-1,iz), &LN=lab(ix,iy+1,iz);
-      const FluidElement &LF=lab(ix,iy,iz-1), &LB=lab(ix,iy,iz+1);
-     // p contains the pressure correction after the Poisson solver
-     o(ix,iy,iz).u -= dt * __FD_2ND(ix, cx, LW.p, L.p, LE.p);
-     o(ix,iy,iz).v -= dt * __FD_2ND(iy, cy, LS.p, L.p, LN.p);
-     o(ix,iy,iz).w -= dt * __FD_2ND(iz, cz, LF.p, L.p, LB.p);
-    }
+    E.u -= dt * __FD_2ND(ix, cx, pW, pC, pE);
+    E.v -= dt * __FD_2ND(iy, cy, pS, pC, pN);
+    E.w -= dt * __FD_2ND(iz, cz, pF, pC, pB);
   }
 };
 
+// Applies the pressure correction reading the solution straight from the
+// solver buffer and its ghosts, and stores p in the blocks in the same sweep.
+template<typename Kernel>
+void gradPFromSolver(SimulationData& sim, const PoissonSolver& S,
+                     const Kernel& kernel)
+{
+  const std::vector<BlockInfo>& vInfo = sim.vInfo();
+  const Real * const P = S.data;
+  const size_t sx = S.stridex, sy = S.stridey, sz = S.stridez;
+  const int NX = S._localN(0), NY = S._localN(1), NZ = S._localN(2);
+
+  #pragma omp parallel
+  {
+    // extrema of the projected velocity outside of obstacles (see SimulationData)
+    double velExt[6] = {LOWEST, LOWEST, LOWEST, LOWEST, LOWEST, LOWEST};
+
+    #pragma omp for schedule(static)
+    for(size_t i=0; i<vInfo.size(); ++i)
+    {
+      const BlockInfo& info = vInfo[i];
+      FluidBlock& o = *(FluidBlock*) info.ptrBlock;
+      const BlockInfo& local = S._localInfo(info);
+      const size_t offset = S._offset(local);
+      const int X0 = local.index[0] * FluidBlock::sizeX;
+      const int Y0 = local.index[1] * FluidBlock::sizeY;
+      const int Z0 = local.index[2] * FluidBlock::sizeZ;
+      for(int iz=0; iz<FluidBlock::sizeZ; ++iz)
+      for(int iy=0; iy<FluidBlock::sizeY; ++iy)
+      for(int ix=0; ix<FluidBlock::sizeX; ++ix) {
+        const int X = X0 + ix, Y = Y0 + iy, Z = Z0 + iz;
+        const size_t c = S._dest(offset, iz, iy, ix);
+        // p contains the pressure correction after the Poisson solver
+        const Real pC = P[c];
+        const Real pW = X > 0    ? P[c - sx] : S._ghost(0, Y, Z);
+        const Real pE = X < NX-1 ? P[c + sx] : S._ghost(1, Y, Z);
+        const Real pS = Y > 0    ? P[c - sy] : S._ghost(2, X, Z);
+        const Real pN = Y < NY-1 ? P[c + sy] : S._ghost(3, X, Z);
+        const Real pF = Z > 0    ? P[c - sz] : S._ghost(4, X, Y);
+        const Real pB = Z < NZ-1 ? P[c + sz] : S._ghost(5, X, Y);
+        FluidElement& E = o(ix,iy,iz);
+        kernel(E, info, o, ix, iy, iz, pC, pW, pE, pS, pN, pF, pB);
+        E.p = pC;
+        if(E.chi > 0) continue; // measured by Penalization
+        updateExtrema(velExt, E);
+      }
+    }
+
+    #pragma omp critical
+    sim.accumulateVelocityExtrema(velExt);
+  }
+}
+
 }
 
 PressureProjection::PressureProjection(SimulationData & s) : Operator(s)
 {
+  // all solvers but these use FFTW, which needs the ranks to be split along
+  // x only (slabs) or along x and y (pencils)
+  bool bIterative = sim.useSolver == "multigrid" ||
+      ((sim.useSolver == "pcg" || sim.useSolver == "bicgstab") &&
+       sim.poissonPreconditioner == "multigrid");
+  #ifdef CUP_HYPRE
+  bIterative = bIterative || sim.useSolver == "hypre";
+  #endif
+  #ifdef CUP_PETSC
+  bIterative = bIterative || sim.useSolver == "petsc";
+  #endif
+  if (sim.bUseFourierBC || sim.bUseUnboundedBC) bIterative = false;
+  if (sim.nprocsz > 1 && not bIterative) {
+    fprintf(stderr, "PressureProjection: ERROR: FFT Poisson solvers need "
+            "-nprocsz 1, split the ranks along x and y or use -useSolver "
+            "multigrid.\n");
+    fflush(0); exit(1);
+  }
+
+  #ifndef _ACCFFT_
+  const bool bPencils = sim.nprocsy > 1;
+  if(bPencils && sim.bUseFourierBC)
+  pressureSolver = new PoissonSolverMixedPencil(sim);
+  else if(bPencils && sim.bUseUnboundedBC)
+  pressureSolver = new PoissonSolverUnboundedPencil(sim);
+  else
+  #endif
   if(sim.bUseFourierBC)
   pressureSolver = new PoissonSolverPeriodic(sim);
   else if (sim.bUseUnboundedBC)
   pressureSolver = new PoissonSolverUnbounded(sim);
+  else if (sim.useSolver == "multigrid")
+  pressureSolver = new PoissonSolverMultigrid(sim);
+  else if (sim.useSolver == "pcg" || sim.useSolver == "bicgstab")
+  pressureSolver = new PoissonSolverKrylov(sim);
   #ifdef CUP_HYPRE
   else if (sim.useSolver == "hypre")
   pressureSolver = new PoissonSolverMixed_HYPRE(sim);
@@ -99,6 +177,10 @@ PressureProjection::PressureProjection(SimulationData & s) : Operator(s)
   pressureSolver = new PoissonSolverMixed_PETSC(sim);
   }
   #endif
+  #ifndef _ACCFFT_
+  else if(bPencils)
+  pressureSolver = new PoissonSolverMixedPencil(sim);
+  #endif
   else
   pressureSolver = new PoissonSolverMixed(sim);
   sim.pressureSolver = pressureSolver;
@@ -108,21 +190,13 @@ void PressureProjection::operator()(const double dt)
 {
   pressureSolver->solve();
 
-  sim.startProfiler("sol2cub");
-  pressureSolver->_fftw2cub();
-  sim.stopProfiler();
-
   sim.startProfiler("GradP"); //pressure correction dudt* = - grad P / rho
+  sim.resetVelocityExtrema();
+  pressureSolver->exchangeGhosts();
   if(sim.bUseStretchedGrid)
-  {
-    const KernelGradP_nonUniform K(dt, sim.extent);
-    compute<KernelGradP_nonUniform>(K);
-  }
+    gradPFromSolver(sim, *pressureSolver, KernelGradP_nonUniform{(Real)dt});
   else
-  {
-    const KernelGradP K(dt, sim.extent);
-    compute<KernelGradP>(K);
-  }
+    gradPFromSolver(sim, *pressureSolver, KernelGradP{(Real)dt});
   sim.stopProfiler();
 
   check("PressureProjection");
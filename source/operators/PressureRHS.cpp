@@ -71,7 +71,7 @@ struct KernelPressureRHS : public ObstacleVisitor
     info_ptr =  & info; lab_ptr =   & lab;
     ObstacleVisitor* const base = static_cast<ObstacleVisitor*> (this);
     assert( base not_eq nullptr );
-    obstacle_vector->Accept( base );
+    obstacle_vector->Accept( base, info.blockID );
     info_ptr = nullptr; lab_ptr = nullptr;
   }
 
@@ -163,7 +163,7 @@ struct KernelPressureRHS_nonUniform : public ObstacleVisitor
     lab_ptr = & lab;
     ObstacleVisitor* const base = static_cast<ObstacleVisitor*> (this);
     assert( base not_eq nullptr );
-    obstacle_vector->Accept( base );
+    obstacle_vector->Accept( base, info.blockID );
     info_ptr = nullptr;
     lab_ptr = nullptr;
   }
@@ -232,12 +232,11 @@ struct KernelFinalizePerimeters : public ObstacleVisitor
 
     #pragma omp parallel
     {
-      const auto& obstblocks = obstacle->getObstacleBlocks();
+      const auto& obstblocks = obstacle->getObstacleBlockList();
       #pragma omp for schedule(dynamic, 1)
-      for (size_t i = 0; i < vInfo.size(); ++i)
+      for (size_t i = 0; i < obstblocks.size(); ++i)
       {
-        const cubism::BlockInfo& info = vInfo[i];
-        if(obstblocks[info.blockID] == nullptr) continue;
+        const cubism::BlockInfo& info = vInfo[obstblocks[i].blockID];
 
         const size_t offset = solver->_offset_ext(info);
         Real* __restrict__ const ret = solver->data;
@@ -324,10 +323,14 @@ void PressureRHS::operator()(const double dt)
   // meaning that they will have net out/in flow
   // usually it is a small number and here we correct this:
 
-  const auto& COMM = sim.app_comm;
-  MPI_Allreduce(MPI_IN_PLACE, sumRHS.data(), nShapes, MPI_DOUBLE,MPI_SUM, COMM);
-  MPI_Allreduce(MPI_IN_PLACE, posRHS.data(), nShapes, MPI_DOUBLE,MPI_SUM, COMM);
-  MPI_Allreduce(MPI_IN_PLACE, negRHS.data(), nShapes, MPI_DOUBLE,MPI_SUM, COMM);
+  // one batched reduction for the three vectors
+  const auto copyTo = [](std::vector<double>& dst) {
+    return [&dst](const double * res) { std::copy(res, res+dst.size(), dst.begin()); };
+  };
+  sim.reductions.enqueue(sumRHS.data(), nShapes, MPI_SUM, copyTo(sumRHS));
+  sim.reductions.enqueue(posRHS.data(), nShapes, MPI_SUM, copyTo(posRHS));
+  sim.reductions.enqueue(negRHS.data(), nShapes, MPI_SUM, copyTo(negRHS));
+  sim.reductions.wait();
   for(size_t j = 0; j<nShapes; ++j) {
     const double corrDenom = sumRHS[j]>0 ? posRHS[j] : negRHS[j];
     corrFactors[j] = sumRHS[j] / std::max(corrDenom, (double) EPS);
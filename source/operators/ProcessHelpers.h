@@ -104,7 +104,8 @@ using v_v_ob = std::vector<std::vector<ObstacleBlock*>*>;
 
 inline void putCHIonGrid(
         const std::vector<cubism::BlockInfo>& vInfo,
-        const v_v_ob & vec_obstacleBlocks )
+        const v_v_ob & vec_obstacleBlocks,
+        const std::vector<std::vector<int>> & obstaclesPerBlock )
 {
   #pragma omp parallel for schedule(dynamic,1)
   for(size_t i=0; i<vInfo.size(); i++)
@@ -113,10 +114,9 @@ inline void putCHIonGrid(
     for(int iz=0; iz<FluidBlock::sizeZ; iz++)
     for(int iy=0; iy<FluidBlock::sizeY; iy++)
     for(int ix=0; ix<FluidBlock::sizeX; ix++) b(ix,iy,iz).chi = 0;
-    for(size_t o=0; o<vec_obstacleBlocks.size(); o++)
+    for(const int o : obstaclesPerBlock[vInfo[i].blockID])
     {
       const auto& pos = ( * vec_obstacleBlocks[o] )[vInfo[i].blockID];
-      if(pos == nullptr) continue;
       for(int iz=0; iz<FluidBlock::sizeZ; iz++)
       for(int iy=0; iy<FluidBlock::sizeY; iy++)
       for(int ix=0; ix<FluidBlock::sizeX; ix++)
@@ -127,7 +127,8 @@ inline void putCHIonGrid(
 
 inline void putSDFonGrid(
         const std::vector<cubism::BlockInfo>& vInfo,
-        const v_v_ob & vec_obstacleBlocks )
+        const v_v_ob & vec_obstacleBlocks,
+        const std::vector<std::vector<int>> & obstaclesPerBlock )
 {
   #pragma omp parallel for schedule(dynamic,1)
   for(size_t i=0; i<vInfo.size(); i++)
@@ -136,10 +137,9 @@ inline void putSDFonGrid(
     for(int iz=0; iz<FluidBlock::sizeZ; iz++)
     for(int iy=0; iy<FluidBlock::sizeY; iy++)
     for(int ix=0; ix<FluidBlock::sizeX; ix++) b(ix,iy,iz).p = -1;
-    for(size_t o=0; o<vec_obstacleBlocks.size(); o++)
+    for(const int o : obstaclesPerBlock[vInfo[i].blockID])
     {
       const auto& pos = ( * vec_obstacleBlocks[o] )[vInfo[i].blockID];
-      if(pos == nullptr) continue;
       for(int iz=0; iz<FluidBlock::sizeZ; iz++)
       for(int iy=0; iy<FluidBlock::sizeY; iy++)
       for(int ix=0; ix<FluidBlock::sizeX; ix++)
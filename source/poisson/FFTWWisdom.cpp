@@ -0,0 +1,123 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "FFTWWisdom.h"
+#include "PoissonSolver_common.h"
+
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <vector>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+namespace {
+
+std::string wisdomFilename(const SimulationData & sim, const std::string & what,
+                           const char precision)
+{
+  std::ostringstream name;
+  name << sim.fftwWisdom << "." << what
+       << "_" << sim.bpdx * FluidBlock::sizeX
+       << "x" << sim.bpdy * FluidBlock::sizeY
+       << "x" << sim.bpdz * FluidBlock::sizeZ
+       << "_r" << sim.nprocsx << "x" << sim.nprocsy << "x" << sim.nprocsz
+       << "_t" << omp_get_max_threads()
+       << "_" << precision
+       << "_bc" << sim.BCx_flag << sim.BCy_flag << sim.BCz_flag << ".wisdom";
+  return name.str();
+}
+
+// FFTW wisdom functions of one precision.
+struct WisdomIO
+{
+  int (*importFile)(const char *);
+  int (*exportFile)(const char *);
+  char *(*exportString)(void);
+  void (*broadcast)(MPI_Comm);
+  void (*gather)(MPI_Comm);
+  char precision;
+};
+
+std::vector<WisdomIO> wisdomIOs()
+{
+  std::vector<WisdomIO> io;
+  #ifndef CUP_SINGLE_PRECISION
+    io.push_back({fftw_import_wisdom_from_filename, fftw_export_wisdom_to_filename,
+                  fftw_export_wisdom_to_string, fftw_mpi_broadcast_wisdom, fftw_mpi_gather_wisdom, 'd'});
+  #endif
+  #if defined(CUP_SINGLE_PRECISION) || defined(CUP_POISSON_MIXED_PRECISION)
+    io.push_back({fftwf_import_wisdom_from_filename, fftwf_export_wisdom_to_filename,
+                  fftwf_export_wisdom_to_string, fftwf_mpi_broadcast_wisdom, fftwf_mpi_gather_wisdom, 'f'});
+  #endif
+  return io;
+}
+
+std::string wisdomString(const WisdomIO & io)
+{
+  char * const s = io.exportString();
+  const std::string out = s != nullptr ? s : "";
+  free(s);
+  return out;
+}
+
+// Local wisdom of each file right after its import, empty if the file was
+// not found: planning measured if the wisdom differs from it afterwards.
+std::map<std::string, std::string> imported;
+
+}
+
+// With CUP_POISSON_MIXED_PRECISION, the single precision wisdom of the
+// transforms of PoissonSolverMixed and PoissonSolverPeriodic is kept in its
+// own file next to the double precision one.
+void importFFTWWisdom(const SimulationData & sim, const MPI_Comm comm,
+                      const std::string & what)
+{
+  if (sim.fftwWisdom.empty()) return;
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  for (const WisdomIO & io : wisdomIOs()) {
+    const std::string filename = wisdomFilename(sim, what, io.precision);
+    int found = 0;
+    if (rank == 0) {
+      found = io.importFile(filename.c_str());
+      if (sim.verbose)
+        printf("FFTW wisdom %s %s\n", filename.c_str(),
+               found ? "imported." : "not found, planning from scratch.");
+    }
+    MPI_Bcast(&found, 1, MPI_INT, 0, comm);
+    if (found) io.broadcast(comm);
+    imported[filename] = found ? wisdomString(io) : "";
+  }
+}
+
+void exportFFTWWisdom(const SimulationData & sim, const MPI_Comm comm,
+                      const std::string & what)
+{
+  if (sim.fftwWisdom.empty()) return;
+  int rank;
+  MPI_Comm_rank(comm, &rank);
+  for (const WisdomIO & io : wisdomIOs()) {
+    const std::string filename = wisdomFilename(sim, what, io.precision);
+    const auto it = imported.find(filename);
+    int bMeasured = it == imported.end() || it->second.empty()
+                 || it->second != wisdomString(io);
+    if (it != imported.end()) imported.erase(it);
+    MPI_Allreduce(MPI_IN_PLACE, &bMeasured, 1, MPI_INT, MPI_LOR, comm);
+    if (not bMeasured) continue;  // the file already has all the plans
+    io.gather(comm);
+    if (rank == 0) {
+      if (!io.exportFile(filename.c_str())) {
+        printf("FFTW wisdom could not be written to %s.\n", filename.c_str());
+        fflush(0);
+      }
+    }
+  }
+}
+
+CubismUP_3D_NAMESPACE_END
+#undef MPIREAL
+#undef MPITREAL
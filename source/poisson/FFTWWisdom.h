@@ -0,0 +1,32 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_FFTWWisdom_h
+#define CubismUP_3D_FFTWWisdom_h
+
+#include "../SimulationData.h"
+
+#include <string>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+// Persistent FFTW wisdom, enabled with -fftwWisdom <prefix>. The wisdom of
+// the plans of `what` (e.g. "mixed") is kept in one file per grid size,
+// process grid, thread count, precision and boundary conditions, so
+// FFTW_MEASURE planning is only paid by the first run of a configuration.
+// Collective over `comm`, both do nothing if no prefix was given.
+
+// Rank 0 reads the file, if any, and broadcasts it. Call before planning.
+void importFFTWWisdom(const SimulationData & sim, MPI_Comm comm,
+                      const std::string & what);
+// Call after planning. If the file was not found, or planning measured on
+// any rank since the import, gathers the wisdom of all ranks and rank 0
+// writes it.
+void exportFFTWWisdom(const SimulationData & sim, MPI_Comm comm,
+                      const std::string & what);
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_FFTWWisdom_h
@@ -0,0 +1,149 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "Krylov.h"
+
+#include <algorithm>
+#include <cmath>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+Krylov::Krylov(const MPI_Comm comm, const size_t n, const Method method)
+    : comm_(comm), n_(n), method_(method)
+{
+  r_.resize(n_);
+  z_.resize(n_);
+  p_.resize(n_);
+  q_.resize(n_);
+  if (method_ == BiCGStab) {
+    rhat_.resize(n_);
+    s_.resize(n_);
+    t_.resize(n_);
+  }
+}
+
+int Krylov::solve(const Operator &A, const Operator &M, const Real * const b,
+                  Real * const x, const double tolRel, const double tolAbs,
+                  const int maxIter)
+{
+  rhsNorm_ = std::sqrt(dot(b, b));
+  A(x, q_.data());
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n_; ++i) r_[i] = b[i] - q_[i];
+  residual_ = std::sqrt(dot(r_.data(), r_.data()));
+
+  const double tol = std::max(tolRel * rhsNorm_, tolAbs);
+  if (residual_ <= tol) return 0;
+  return method_ == CG ? solveCG(A, M, x, tol, maxIter)
+                       : solveBiCGStab(A, M, x, tol, maxIter);
+}
+
+int Krylov::solveCG(const Operator &A, const Operator &M, Real * const x,
+                    const double tol, const int maxIter)
+{
+  Real *const r = r_.data(), *const z = z_.data();
+  Real *const p = p_.data(), *const q = q_.data();
+  M(r, z);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n_; ++i) p[i] = z[i];
+  double rz = dot(r, z);
+
+  int iter = 0;
+  while (iter < maxIter) {
+    A(p, q);
+    const double alpha = rz / dot(p, q);
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n_; ++i) {
+      x[i] += alpha * p[i];
+      r[i] -= alpha * q[i];
+    }
+    ++iter;
+    residual_ = std::sqrt(dot(r, r));
+    if (residual_ <= tol) break;
+
+    M(r, z);
+    const double rzNew = dot(r, z);
+    const double beta = rzNew / rz;
+    rz = rzNew;
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n_; ++i) p[i] = z[i] + beta * p[i];
+  }
+  return iter;
+}
+
+int Krylov::solveBiCGStab(const Operator &A, const Operator &M,
+                          Real * const x, const double tol, const int maxIter)
+{
+  Real *const r = r_.data(), *const rhat = rhat_.data();
+  Real *const p = p_.data(), *const v = q_.data(), *const z = z_.data();
+  Real *const s = s_.data(), *const t = t_.data();
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n_; ++i) {
+    rhat[i] = r[i];
+    p[i] = 0;
+    v[i] = 0;
+  }
+  double rho = 1, alpha = 1, omega = 1;
+
+  int iter = 0;
+  while (iter < maxIter) {
+    const double rhoNew = dot(rhat, r);
+    if (rhoNew == 0) break;  // Breakdown, keep the current iterate.
+    const double beta = (rhoNew / rho) * (alpha / omega);
+    rho = rhoNew;
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n_; ++i) p[i] = r[i] + beta * (p[i] - omega * v[i]);
+
+    M(p, z);
+    A(z, v);
+    alpha = rho / dot(rhat, v);
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n_; ++i) {
+      x[i] += alpha * z[i];
+      s[i] = r[i] - alpha * v[i];
+    }
+    ++iter;
+    residual_ = std::sqrt(dot(s, s));
+    if (residual_ <= tol) break;
+
+    M(s, z);
+    A(z, t);
+    double ts[2];
+    const Real *const u[2] = {t, t}, *const w[2] = {s, t};
+    dots(2, u, w, ts);
+    omega = ts[0] / ts[1];
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n_; ++i) {
+      x[i] += omega * z[i];
+      r[i] = s[i] - omega * t[i];
+    }
+    residual_ = std::sqrt(dot(r, r));
+    if (residual_ <= tol || omega == 0) break;
+  }
+  return iter;
+}
+
+void Krylov::dots(const int count, const Real * const u[],
+                  const Real * const v[], double out[]) const
+{
+  for (int k = 0; k < count; ++k) {
+    const Real *const a = u[k], *const b = v[k];
+    double sum = 0;
+    #pragma omp parallel for schedule(static) reduction(+ : sum)
+    for (size_t i = 0; i < n_; ++i) sum += (double)a[i] * b[i];
+    out[k] = sum;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, out, count, MPI_DOUBLE, MPI_SUM, comm_);
+}
+
+double Krylov::dot(const Real * const u, const Real * const v) const
+{
+  double out;
+  dots(1, &u, &v, &out);
+  return out;
+}
+
+CubismUP_3D_NAMESPACE_END
@@ -0,0 +1,68 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_Krylov_h
+#define CubismUP_3D_Krylov_h
+
+#include "../Base.h"
+
+#include <mpi.h>
+
+#include <functional>
+#include <vector>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+/*
+ * Preconditioned conjugate gradient and BiCGStab for distributed vectors of
+ * `n` local entries. The operator and the preconditioner are callbacks, the
+ * class only does the vector updates and the reductions on `comm`.
+ *
+ * CG needs a symmetric operator and preconditioner of the same definiteness.
+ * BiCGStab (right preconditioned) accepts nonsymmetric ones, e.g. the
+ * stretched grid operator, at twice the cost per iteration.
+ */
+class Krylov
+{
+public:
+  enum Method { CG, BiCGStab };
+
+  // y = A x or z = M^-1 r, vectors of the local size.
+  using Operator = std::function<void(const Real *x, Real *y)>;
+
+  Krylov(MPI_Comm comm, size_t n, Method method);
+
+  /*
+   * Solve A x = b, with the initial guess in x, until ||b - A x||_2 is below
+   * max(tolRel ||b||_2, tolAbs). Returns the number of iterations done.
+   */
+  int solve(const Operator &A, const Operator &M, const Real *b, Real *x,
+            double tolRel, double tolAbs, int maxIter);
+
+  /* Residual norm ||b - A x||_2 and ||b||_2 of the last solve. */
+  double lastResidual() const { return residual_; }
+  double lastRHSNorm() const { return rhsNorm_; }
+
+private:
+  int solveCG(const Operator &A, const Operator &M, Real *x, double tol,
+              int maxIter);
+  int solveBiCGStab(const Operator &A, const Operator &M, Real *x,
+                    double tol, int maxIter);
+
+  // Global dot products, `count` pairs in one reduction.
+  void dots(int count, const Real *const u[], const Real *const v[],
+            double out[]) const;
+  double dot(const Real *u, const Real *v) const;
+
+  MPI_Comm comm_;
+  size_t n_;
+  Method method_;
+  std::vector<Real> r_, z_, p_, q_, rhat_, s_, t_;
+  double residual_ = 0, rhsNorm_ = 0;
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_Krylov_h
@@ -0,0 +1,530 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "Multigrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifndef CUP_SINGLE_PRECISION
+#define MPIREAL MPI_DOUBLE
+#else
+#define MPIREAL MPI_FLOAT
+#endif /* CUP_SINGLE_PRECISION */
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+static constexpr int PRE_SWEEPS = 2, POST_SWEEPS = 2;
+
+Multigrid::Multigrid(MPI_Comm cartComm, const int cells[3],
+                     const bool periodic[3], const Coefficients coeffs[3])
+    : comm_(cartComm)
+{
+  int dims[3], periods[3], coords[3];
+  MPI_Cart_get(comm_, 3, dims, periods, coords);
+  nGlobal_ = 1;
+  for (int d = 0; d < 3; ++d) {
+    nGlobal_ *= (double)cells[d] * dims[d];
+    for (int side = 0; side < 2; ++side) {
+      int c[3] = {coords[0], coords[1], coords[2]};
+      c[d] += side ? 1 : -1;
+      if (c[d] < 0 || c[d] >= dims[d]) {
+        if (not periodic[d]) {
+          neighbours_[2 * d + side] = MPI_PROC_NULL;
+          continue;
+        }
+        c[d] = (c[d] + dims[d]) % dims[d];
+      }
+      MPI_Cart_rank(comm_, c, &neighbours_[2 * d + side]);
+    }
+  }
+
+  // Finest level, with the given coefficients.
+  levels_.emplace_back();
+  {
+    Level &L = levels_.back();
+    const int offset[3] = {coords[0] * cells[0], coords[1] * cells[1],
+                           coords[2] * cells[2]};
+    initLevel(L, cells, offset);
+    for (int d = 0; d < 3; ++d) {
+      std::copy(coeffs[d].h.begin(), coeffs[d].h.end(), L.h[d].begin() + 1);
+      exchangeSpacing(L, d);
+      L.cm[d] = coeffs[d].cm;
+      L.cp[d] = coeffs[d].cp;
+      if (neighbours_[2 * d] == MPI_PROC_NULL) L.cm[d][0] = 0;
+      if (neighbours_[2 * d + 1] == MPI_PROC_NULL) L.cp[d][cells[d] - 1] = 0;
+    }
+    // Work vectors of apply and precondition, see stash().
+    saved_[0].assign(L.size(), 0);
+    saved_[1].assign(L.size(), 0);
+  }
+
+  // Coarsen while every direction can be halved and keeps at least 2 cells.
+  for (;;) {
+    const Level &F = levels_.back();
+    if (F.n[0] % 2 || F.n[1] % 2 || F.n[2] % 2 ||
+        F.n[0] < 4 || F.n[1] < 4 || F.n[2] < 4) break;
+    Level C;
+    const int n[3] = {F.n[0] / 2, F.n[1] / 2, F.n[2] / 2};
+    const int offset[3] = {F.offset[0] / 2, F.offset[1] / 2, F.offset[2] / 2};
+    initLevel(C, n, offset);
+    coarsenSpacing(F, C);
+    for (int d = 0; d < 3; ++d) {
+      exchangeSpacing(C, d);
+      setCoefficients(C, d);
+    }
+    levels_.push_back(std::move(C));
+  }
+
+  // Gauss-Seidel needs O(N) sweeps to reduce the smoothest error modes of
+  // an N-cells wide coarsest grid by a constant factor. With several ranks
+  // each sweep would need a halo exchange, the level is gathered instead.
+  const Level &C = levels_.back();
+  const int maxN = std::max({C.n[0], C.n[1], C.n[2]});
+  coarseSweeps_ = std::min(1000, std::max(10, 2 * maxN));
+  if (dims[0] * dims[1] * dims[2] > 1) initCoarseSolve(periodic);
+}
+
+Multigrid::~Multigrid()
+{
+  coarse_.reset();
+  if (coarseComm_ != MPI_COMM_NULL) MPI_Comm_free(&coarseComm_);
+}
+
+void Multigrid::initCoarseSolve(const bool periodic[3])
+{
+  const Level &C = levels_.back();
+  int rank, size;
+  MPI_Comm_rank(comm_, &rank);
+  MPI_Comm_size(comm_, &size);
+  bGatherCoarse_ = true;
+  packed_.resize((size_t)C.n[0] * C.n[1] * C.n[2]);
+
+  const int box[6] = {C.n[0], C.n[1], C.n[2],
+                      C.offset[0], C.offset[1], C.offset[2]};
+  if (rank == 0) coarseBoxes_.resize(6 * size);
+  MPI_Gather(box, 6, MPI_INT, coarseBoxes_.data(), 6, MPI_INT, 0, comm_);
+  int N[3] = {0, 0, 0};
+  if (rank == 0) {
+    counts_.resize(size);
+    displs_.resize(size);
+    for (int r = 0, displ = 0; r < size; ++r) {
+      const int *const b = &coarseBoxes_[6 * r];
+      counts_[r] = b[0] * b[1] * b[2];
+      displs_[r] = displ;
+      displ += counts_[r];
+      for (int d = 0; d < 3; ++d) N[d] = std::max(N[d], b[3 + d] + b[d]);
+    }
+    gathered_.resize(displs_.back() + counts_.back());
+  }
+  MPI_Bcast(N, 3, MPI_INT, 0, comm_);
+
+  // Spacing and coefficients along each direction of the whole coarse grid.
+  // Ranks at the same position along d hold the same (non-negative) values.
+  Coefficients coeffs[3];
+  for (int d = 0; d < 3; ++d) {
+    std::vector<Real> local(3 * N[d], 0), global(rank == 0 ? 3 * N[d] : 0);
+    for (int i = 0; i < C.n[d]; ++i) {
+      local[C.offset[d] + i] = C.h[d][i + 1];
+      local[N[d] + C.offset[d] + i] = C.cm[d][i];
+      local[2 * N[d] + C.offset[d] + i] = C.cp[d][i];
+    }
+    MPI_Reduce(local.data(), global.data(), 3 * N[d], MPIREAL, MPI_MAX, 0,
+               comm_);
+    if (rank != 0) continue;
+    coeffs[d].h.assign(global.begin(), global.begin() + N[d]);
+    coeffs[d].cm.assign(global.begin() + N[d], global.begin() + 2 * N[d]);
+    coeffs[d].cp.assign(global.begin() + 2 * N[d], global.end());
+  }
+  if (rank != 0) return;
+
+  const int dims[3] = {1, 1, 1};
+  const int periods[3] = {periodic[0], periodic[1], periodic[2]};
+  MPI_Cart_create(MPI_COMM_SELF, 3, dims, periods, 0, &coarseComm_);
+  std::copy(N, N + 3, coarseN_);
+  coarse_ = std::make_unique<Multigrid>(coarseComm_, N, periodic, coeffs);
+  coarseB_.resize((size_t)N[0] * N[1] * N[2]);
+  coarseX_.resize(coarseB_.size());
+}
+
+void Multigrid::coarseSolve(Level &L)
+{
+  // Gather the coarsest level on rank 0, one serial V-cycle, scatter back.
+  const size_t nx = L.n[0], ny = L.n[1];
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+  for (int ix = 0; ix < L.n[0]; ++ix)
+    packed_[ix + nx * (iy + ny * iz)] = L.b[L.idx(ix, iy, iz)];
+  MPI_Gatherv(packed_.data(), (int)packed_.size(), MPIREAL, gathered_.data(),
+              counts_.data(), displs_.data(), MPIREAL, 0, comm_);
+
+  if (coarse_ != nullptr) {
+    const size_t Nx = coarseN_[0], Ny = coarseN_[1];
+    // Calls op(index in gathered_, index in the whole grid) for all cells.
+    const auto forCells = [&](auto &&op) {
+      #pragma omp parallel for schedule(static)
+      for (size_t r = 0; r < counts_.size(); ++r) {
+        const int *const b = &coarseBoxes_[6 * r];
+        size_t k = displs_[r];
+        for (int iz = 0; iz < b[2]; ++iz)
+        for (int iy = 0; iy < b[1]; ++iy)
+        for (int ix = 0; ix < b[0]; ++ix)
+          op(k++, b[3] + ix + Nx * (b[4] + iy + Ny * (b[5] + iz)));
+      }
+    };
+    forCells([this](size_t k, size_t i) { coarseB_[i] = gathered_[k]; });
+    coarse_->precondition(coarseB_.data(), coarseX_.data());
+    // The problem is singular, keep the correction free of a drifting mean.
+    double mean = 0;
+    for (const Real v : coarseX_) mean += v;
+    mean /= coarseX_.size();
+    forCells([this, mean](size_t k, size_t i) {
+      gathered_[k] = coarseX_[i] - mean;
+    });
+  }
+
+  MPI_Scatterv(gathered_.data(), counts_.data(), displs_.data(), MPIREAL,
+               packed_.data(), (int)packed_.size(), MPIREAL, 0, comm_);
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+  for (int ix = 0; ix < L.n[0]; ++ix)
+    L.x[L.idx(ix, iy, iz)] = packed_[ix + nx * (iy + ny * iz)];
+}
+
+void Multigrid::initLevel(Level &L, const int cells[3], const int offset[3])
+{
+  for (int d = 0; d < 3; ++d) {
+    L.n[d] = cells[d];
+    L.offset[d] = offset[d];
+    L.h[d].assign(cells[d] + 2, 0);
+    L.cm[d].assign(cells[d], 0);
+    L.cp[d].assign(cells[d], 0);
+  }
+  L.sy = L.n[0] + 2;
+  L.sz = L.sy * (L.n[1] + 2);
+  L.x.assign(L.size(), 0);
+  L.b.assign(L.size(), 0);
+  L.r.assign(L.size(), 0);
+  for (int f = 0; f < 6; ++f) {
+    const int d = f / 2;
+    const size_t face = (size_t)L.n[(d + 1) % 3] * L.n[(d + 2) % 3];
+    L.sendBuf[f].resize(face);
+    L.recvBuf[f].resize(face);
+  }
+}
+
+void Multigrid::coarsenSpacing(const Level &fine, Level &coarse)
+{
+  for (int d = 0; d < 3; ++d)
+  for (int i = 0; i < coarse.n[d]; ++i)
+    coarse.h[d][i + 1] = fine.h[d][2 * i + 1] + fine.h[d][2 * i + 2];
+}
+
+void Multigrid::exchangeSpacing(Level &L, const int d)
+{
+  std::vector<Real> &h = L.h[d];
+  const int n = L.n[d];
+  const int lo = neighbours_[2 * d], hi = neighbours_[2 * d + 1];
+  MPI_Sendrecv(&h[1], 1, MPIREAL, lo, 0, &h[n + 1], 1, MPIREAL, hi, 0,
+               comm_, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(&h[n], 1, MPIREAL, hi, 1, &h[0], 1, MPIREAL, lo, 1,
+               comm_, MPI_STATUS_IGNORE);
+  if (lo == MPI_PROC_NULL) h[0] = h[1];
+  if (hi == MPI_PROC_NULL) h[n + 1] = h[n];
+}
+
+void Multigrid::setCoefficients(Level &L, const int d)
+{
+  // Second derivative on the cell centres of a non-uniform grid.
+  const std::vector<Real> &h = L.h[d];
+  for (int i = 0; i < L.n[d]; ++i) {
+    const Real dm = (h[i] + h[i + 1]) / 2, dp = (h[i + 1] + h[i + 2]) / 2;
+    L.cm[d][i] = 2 / (dm * (dm + dp));
+    L.cp[d][i] = 2 / (dp * (dm + dp));
+  }
+  if (neighbours_[2 * d] == MPI_PROC_NULL) L.cm[d][0] = 0;
+  if (neighbours_[2 * d + 1] == MPI_PROC_NULL) L.cp[d][L.n[d] - 1] = 0;
+}
+
+void Multigrid::exchange(Level &L, std::vector<Real> &v)
+{
+  // Calls op(k, index) for the k-th cell of the layer `layer` normal to the
+  // direction of face f.
+  const auto forFace = [&L](const int f, const int layer, auto &&op) {
+    const int d = f / 2, a = (d + 1) % 3, c = (d + 2) % 3;
+    size_t k = 0;
+    int p[3];
+    p[d] = layer;
+    for (p[c] = 0; p[c] < L.n[c]; ++p[c])
+    for (p[a] = 0; p[a] < L.n[a]; ++p[a])
+      op(k++, L.idx(p[0], p[1], p[2]));
+  };
+
+  // A message travelling towards face f of the sender has tag f.
+  MPI_Request reqs[12];
+  int nreqs = 0;
+  for (int f = 0; f < 6; ++f) {
+    if (neighbours_[f] == MPI_PROC_NULL) continue;
+    MPI_Irecv(L.recvBuf[f].data(), (int)L.recvBuf[f].size(), MPIREAL,
+              neighbours_[f], f ^ 1, comm_, &reqs[nreqs++]);
+  }
+  for (int f = 0; f < 6; ++f) {
+    if (neighbours_[f] == MPI_PROC_NULL) continue;
+    Real * const buf = L.sendBuf[f].data();
+    forFace(f, f % 2 ? L.n[f / 2] - 1 : 0,
+            [buf, &v](size_t k, size_t i) { buf[k] = v[i]; });
+    MPI_Isend(buf, (int)L.sendBuf[f].size(), MPIREAL, neighbours_[f], f,
+              comm_, &reqs[nreqs++]);
+  }
+  MPI_Waitall(nreqs, reqs, MPI_STATUSES_IGNORE);
+  for (int f = 0; f < 6; ++f) {
+    if (neighbours_[f] == MPI_PROC_NULL) continue;
+    const Real * const buf = L.recvBuf[f].data();
+    forFace(f, f % 2 ? L.n[f / 2] : -1,
+            [buf, &v](size_t k, size_t i) { v[i] = buf[k]; });
+  }
+}
+
+void Multigrid::smooth(Level &L, const int sweeps)
+{
+  const size_t sy = L.sy, sz = L.sz;
+  const Real *const hx = L.h[0].data() + 1, *const hy = L.h[1].data() + 1,
+             *const hz = L.h[2].data() + 1;
+  const Real *const cmx = L.cm[0].data(), *const cpx = L.cp[0].data();
+  const Real *const cmy = L.cm[1].data(), *const cpy = L.cp[1].data();
+  const Real *const cmz = L.cm[2].data(), *const cpz = L.cp[2].data();
+  Real * const x = L.x.data();
+  const Real * const b = L.b.data();
+
+  for (int s = 0; s < sweeps; ++s)
+  for (int color = 0; color < 2; ++color) {
+    exchange(L, L.x);
+    #pragma omp parallel for schedule(static)
+    for (int iz = 0; iz < L.n[2]; ++iz)
+    for (int iy = 0; iy < L.n[1]; ++iy) {
+      const int start = (color + L.offset[0] + L.offset[1] + iy
+                         + L.offset[2] + iz) & 1;
+      for (int ix = start; ix < L.n[0]; ix += 2) {
+        const size_t i = L.idx(ix, iy, iz);
+        const Real dv = hx[ix] * hy[iy] * hz[iz];
+        const Real S = cmx[ix] * x[i - 1]  + cpx[ix] * x[i + 1]
+                     + cmy[iy] * x[i - sy] + cpy[iy] * x[i + sy]
+                     + cmz[iz] * x[i - sz] + cpz[iz] * x[i + sz];
+        const Real D = cmx[ix] + cpx[ix] + cmy[iy] + cpy[iy]
+                     + cmz[iz] + cpz[iz];
+        x[i] = (S - b[i] / dv) / D;
+      }
+    }
+  }
+}
+
+void Multigrid::residual(Level &L)
+{
+  const size_t sy = L.sy, sz = L.sz;
+  const Real *const hx = L.h[0].data() + 1, *const hy = L.h[1].data() + 1,
+             *const hz = L.h[2].data() + 1;
+  const Real *const cmx = L.cm[0].data(), *const cpx = L.cp[0].data();
+  const Real *const cmy = L.cm[1].data(), *const cpy = L.cp[1].data();
+  const Real *const cmz = L.cm[2].data(), *const cpz = L.cp[2].data();
+  exchange(L, L.x);
+  const Real * const x = L.x.data();
+  const Real * const b = L.b.data();
+  Real * const r = L.r.data();
+
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+  for (int ix = 0; ix < L.n[0]; ++ix) {
+    const size_t i = L.idx(ix, iy, iz);
+    const Real dv = hx[ix] * hy[iy] * hz[iz];
+    const Real Ax = cmx[ix] * (x[i - 1]  - x[i]) + cpx[ix] * (x[i + 1]  - x[i])
+                  + cmy[iy] * (x[i - sy] - x[i]) + cpy[iy] * (x[i + sy] - x[i])
+                  + cmz[iz] * (x[i - sz] - x[i]) + cpz[iz] * (x[i + sz] - x[i]);
+    r[i] = b[i] - dv * Ax;
+  }
+}
+
+void Multigrid::restrictResidual(const Level &fine, Level &coarse)
+{
+  // The right-hand side is volume integrated, coarse cells sum their children.
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < coarse.n[2]; ++iz)
+  for (int iy = 0; iy < coarse.n[1]; ++iy)
+  for (int ix = 0; ix < coarse.n[0]; ++ix) {
+    const size_t f = fine.idx(2 * ix, 2 * iy, 2 * iz);
+    const size_t sy = fine.sy, sz = fine.sz;
+    const Real * const r = fine.r.data();
+    coarse.b[coarse.idx(ix, iy, iz)] =
+        r[f]          + r[f + 1]          + r[f + sy]          + r[f + sy + 1]
+      + r[f + sz]     + r[f + sz + 1]     + r[f + sz + sy]     + r[f + sz + sy + 1];
+  }
+}
+
+void Multigrid::prolongateAdd(const Level &coarse, Level &fine)
+{
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < fine.n[2]; ++iz)
+  for (int iy = 0; iy < fine.n[1]; ++iy)
+  for (int ix = 0; ix < fine.n[0]; ++ix)
+    fine.x[fine.idx(ix, iy, iz)] += coarse.x[coarse.idx(ix / 2, iy / 2, iz / 2)];
+}
+
+void Multigrid::vcycle(const size_t l)
+{
+  Level &L = levels_[l];
+  if (l + 1 == levels_.size()) {
+    if (bGatherCoarse_) {
+      coarseSolve(L);
+      return;
+    }
+    smooth(L, coarseSweeps_);
+    // The problem is singular, keep the correction free of a drifting mean.
+    addConstant(L, L.x, -sum(L, L.x) / (nGlobal_ / std::pow(8, l)));
+    return;
+  }
+  Level &C = levels_[l + 1];
+  smooth(L, PRE_SWEEPS);
+  residual(L);
+  restrictResidual(L, C);
+  std::fill(C.x.begin(), C.x.end(), 0);
+  vcycle(l + 1);
+  prolongateAdd(C, L);
+  smooth(L, POST_SWEEPS);
+}
+
+int Multigrid::solve(Real * const data, const double tolRel,
+                     const double tolAbs, const int maxCycles)
+{
+  Level &L = levels_[0];
+  copyIn(data, L.b, L);
+  addConstant(L, L.b, -sum(L, L.b) / nGlobal_);
+  rhsNorm_ = std::sqrt(sumSquares(L, L.b));
+
+  const double tol = std::max(tolRel * rhsNorm_, tolAbs);
+  residual(L);
+  residual_ = std::sqrt(sumSquares(L, L.r));
+  int cycles = 0;
+  while (residual_ > tol && cycles < maxCycles) {
+    vcycle(0);
+    residual(L);
+    residual_ = std::sqrt(sumSquares(L, L.r));
+    ++cycles;
+  }
+
+  addConstant(L, L.x, -sum(L, L.x) / nGlobal_);
+  copyOut(L.x, data, L);
+  return cycles;
+}
+
+void Multigrid::apply(const Real * const x, Real * const y)
+{
+  // Residual of the zero right-hand side, r = -A x, on the finest level.
+  Level &L = levels_[0];
+  stash(L);
+  setZero(L.b);
+  copyIn(x, L.x, L);
+  residual(L);
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+  for (int ix = 0; ix < L.n[0]; ++ix)
+    y[ix + L.n[0] * (iy + (size_t)L.n[1] * iz)] = -L.r[L.idx(ix, iy, iz)];
+  unstash(L);
+}
+
+void Multigrid::precondition(const Real * const r, Real * const z)
+{
+  Level &L = levels_[0];
+  stash(L);
+  setZero(L.x);
+  copyIn(r, L.b, L);
+  vcycle(0);
+  copyOut(L.x, z, L);
+  unstash(L);
+}
+
+void Multigrid::stash(Level &L)
+{
+  // Keep the solution and the right-hand side of `solve` aside and work on
+  // the persistent vectors of saved_, which the caller initializes.
+  L.x.swap(saved_[0]);
+  L.b.swap(saved_[1]);
+}
+
+void Multigrid::unstash(Level &L)
+{
+  L.x.swap(saved_[0]);
+  L.b.swap(saved_[1]);
+}
+
+void Multigrid::setZero(std::vector<Real> &v) const
+{
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < v.size(); ++i) v[i] = 0;
+}
+
+void Multigrid::resetGuess()
+{
+  std::fill(levels_[0].x.begin(), levels_[0].x.end(), 0);
+}
+
+void Multigrid::copyIn(const Real * const src, std::vector<Real> &dst,
+                       const Level &L) const
+{
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+    std::copy_n(src + L.n[0] * (iy + (size_t)L.n[1] * iz), L.n[0],
+                dst.begin() + L.idx(0, iy, iz));
+}
+
+void Multigrid::copyOut(const std::vector<Real> &src, Real * const dst,
+                        const Level &L) const
+{
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+    std::copy_n(src.begin() + L.idx(0, iy, iz), L.n[0],
+                dst + L.n[0] * (iy + (size_t)L.n[1] * iz));
+}
+
+double Multigrid::sumSquares(const Level &L, const std::vector<Real> &v) const
+{
+  double s = 0;
+  #pragma omp parallel for schedule(static) reduction(+ : s)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+  for (int ix = 0; ix < L.n[0]; ++ix)
+    s += (double)v[L.idx(ix, iy, iz)] * v[L.idx(ix, iy, iz)];
+  MPI_Allreduce(MPI_IN_PLACE, &s, 1, MPI_DOUBLE, MPI_SUM, comm_);
+  return s;
+}
+
+double Multigrid::sum(const Level &L, const std::vector<Real> &v) const
+{
+  double s = 0;
+  #pragma omp parallel for schedule(static) reduction(+ : s)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+  for (int ix = 0; ix < L.n[0]; ++ix)
+    s += v[L.idx(ix, iy, iz)];
+  MPI_Allreduce(MPI_IN_PLACE, &s, 1, MPI_DOUBLE, MPI_SUM, comm_);
+  return s;
+}
+
+void Multigrid::addConstant(Level &L, std::vector<Real> &v, const Real c) const
+{
+  #pragma omp parallel for schedule(static)
+  for (int iz = 0; iz < L.n[2]; ++iz)
+  for (int iy = 0; iy < L.n[1]; ++iy)
+  for (int ix = 0; ix < L.n[0]; ++ix)
+    v[L.idx(ix, iy, iz)] += c;
+}
+
+CubismUP_3D_NAMESPACE_END
+#undef MPIREAL
@@ -0,0 +1,141 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_Multigrid_h
+#define CubismUP_3D_Multigrid_h
+
+#include "../Base.h"
+
+#include <mpi.h>
+
+#include <memory>
+#include <vector>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+/*
+ * Matrix-free geometric multigrid for the cell-centred 7-point Poisson
+ * problem of the pressure solvers:
+ *
+ *   (A x)_i = dv_i sum_d [ cm_d (x_{i-e_d} - x_i) + cp_d (x_{i+e_d} - x_i) ],
+ *
+ * with dv_i the cell volume and cm_d, cp_d the second derivative coefficients
+ * along d, which only depend on the index along d (tensor-product grids). Each
+ * rank holds a box of cells of the Cartesian communicator, directions are
+ * either periodic or have a zero-gradient boundary.
+ *
+ * V-cycles with red-black Gauss-Seidel smoothing, volume-summing restriction,
+ * piecewise constant prolongation and coarse operators rediscretized from the
+ * coarsened spacing. Levels are coarsened on each rank independently, so all
+ * the communication is a face exchange with the six neighbours, plus one
+ * reduction per cycle for the residual. With several ranks, the coarsest of
+ * these levels is gathered on rank 0, which solves it with one V-cycle of a
+ * serial Multigrid of the whole coarse grid, and scattered back.
+ *
+ * Vectors passed to and from the class are in the rank-local layout with x
+ * fastest and no ghosts.
+ */
+class Multigrid
+{
+public:
+  // Spacing and second derivative coefficients along one direction.
+  struct Coefficients
+  {
+    std::vector<Real> h, cm, cp;  // One entry per local cell.
+  };
+
+  Multigrid(MPI_Comm cartComm, const int cells[3], const bool periodic[3],
+            const Coefficients coeffs[3]);
+  ~Multigrid();
+  Multigrid(const Multigrid &) = delete;
+  Multigrid &operator=(const Multigrid &) = delete;
+
+  /*
+   * Replace the right-hand side in `data` with the zero-mean solution.
+   * The previous solution is the initial guess. The mean of the right-hand
+   * side is removed first, as the problem is singular.
+   * Returns the number of V-cycles done.
+   */
+  int solve(Real *data, double tolRel, double tolAbs, int maxCycles);
+
+  /* y = A x. */
+  void apply(const Real *x, Real *y);
+
+  /* One V-cycle for A z = r starting from z = 0, usable as a preconditioner. */
+  void precondition(const Real *r, Real *z);
+
+  /* Forget the previous solution. */
+  void resetGuess();
+
+  /* Residual norm ||b - A x||_2 and ||b||_2 of the last solve. */
+  double lastResidual() const { return residual_; }
+  double lastRHSNorm() const { return rhsNorm_; }
+  int numLevels() const { return (int)levels_.size(); }
+
+private:
+  struct Level
+  {
+    int n[3];        // Local cells.
+    int offset[3];   // Global index of the first local cell, for colouring.
+    size_t sy, sz;   // Strides of the ghosted arrays, x is contiguous.
+    std::vector<Real> x, b, r;
+    // Per direction: spacing with one ghost on each side, coefficients
+    // without ghosts (zero at zero-gradient boundaries).
+    std::vector<Real> h[3], cm[3], cp[3];
+    std::vector<Real> sendBuf[6], recvBuf[6];
+
+    size_t idx(int ix, int iy, int iz) const
+    {
+      return (size_t)(ix + 1) + sy * (iy + 1) + sz * (iz + 1);
+    }
+    size_t size() const { return sz * (n[2] + 2); }
+  };
+
+  void initLevel(Level &L, const int cells[3], const int offset[3]);
+  void coarsenSpacing(const Level &fine, Level &coarse);
+  void exchangeSpacing(Level &L, int d);
+  void setCoefficients(Level &L, int d);
+  void exchange(Level &L, std::vector<Real> &v);
+
+  void smooth(Level &L, int sweeps);
+  void residual(Level &L);
+  void restrictResidual(const Level &fine, Level &coarse);
+  void prolongateAdd(const Level &coarse, Level &fine);
+  void vcycle(size_t l);
+  void initCoarseSolve(const bool periodic[3]);
+  void coarseSolve(Level &L);
+  void stash(Level &L);
+  void unstash(Level &L);
+
+  void copyIn(const Real *src, std::vector<Real> &dst, const Level &L) const;
+  void copyOut(const std::vector<Real> &src, Real *dst, const Level &L) const;
+  double sumSquares(const Level &L, const std::vector<Real> &v) const;
+  double sum(const Level &L, const std::vector<Real> &v) const;
+  void addConstant(Level &L, std::vector<Real> &v, Real c) const;
+  void setZero(std::vector<Real> &v) const;
+
+  MPI_Comm comm_;
+  int neighbours_[6];    // -x, +x, -y, +y, -z, +z; MPI_PROC_NULL at walls.
+  double nGlobal_;       // Number of cells of the whole domain.
+  int coarseSweeps_;
+  std::vector<Level> levels_;
+  // Several ranks only, see coarseSolve(). The coarsest level of the rank
+  // packed without ghosts and, on rank 0: cells and global offset of the
+  // coarsest level of each rank, the gathered levels and the serial
+  // Multigrid of the whole coarse grid on coarseComm_.
+  bool bGatherCoarse_ = false;
+  std::vector<Real> packed_;
+  std::vector<int> coarseBoxes_, counts_, displs_;
+  std::vector<Real> gathered_, coarseB_, coarseX_;
+  int coarseN_[3] = {0, 0, 0};
+  MPI_Comm coarseComm_ = MPI_COMM_NULL;
+  std::unique_ptr<Multigrid> coarse_;
+  std::vector<Real> saved_[2];  // x and b of the finest level, see stash().
+  double residual_ = 0, rhsNorm_ = 0;
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_Multigrid_h
@@ -0,0 +1,167 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "PencilTranspose.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+
+#ifndef CUP_SINGLE_PRECISION
+#define MPIREAL MPI_DOUBLE
+#else
+#define MPIREAL MPI_FLOAT
+#endif /* CUP_SINGLE_PRECISION */
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+std::vector<int> PencilTranspose::split(const int n, const int parts)
+{
+  std::vector<int> counts(parts, n / parts);
+  for (int i = 0; i < n % parts; ++i) ++counts[i];
+  return counts;
+}
+
+PencilTranspose::PencilTranspose(
+    const MPI_Comm comm, const int A, const std::vector<int> &bCounts,
+    const int bPadded, const std::vector<int> &cCounts, const int tuple)
+    : comm_(comm), A_(A), bPadded_(bPadded), tuple_(tuple),
+      bCount_(bCounts), cCount_(cCounts)
+{
+  MPI_Comm_rank(comm_, &rank_);
+  MPI_Comm_size(comm_, &size_);
+  if ((int)bCount_.size() != size_ || (int)cCount_.size() != size_) {
+    printf("PencilTranspose: chunks do not match the communicator size.\n");
+    fflush(0); MPI_Abort(comm_, 1);
+  }
+  for (int q = 0; q < size_; ++q) {
+    bStart_.push_back(bTotal_);
+    cStart_.push_back(cTotal_);
+    bTotal_ += bCount_[q];
+    cTotal_ += cCount_[q];
+  }
+  if (bPadded_ < bTotal_) {
+    printf("PencilTranspose: padded size %d smaller than %d.\n",
+           bPadded_, bTotal_);
+    fflush(0); MPI_Abort(comm_, 1);
+  }
+
+  abcDispls_.push_back(0);
+  cabDispls_.push_back(0);
+  for (int q = 0; q < size_; ++q) {
+    // Elements of rank q with the local B chunk, resp. the local C chunk.
+    const long long abc = (long long)A_ * bCount_[rank_] * cCount_[q] * tuple_;
+    const long long cab = (long long)A_ * bCount_[q] * cCount_[rank_] * tuple_;
+    if (abcDispls_.back() + abc > INT_MAX || cabDispls_.back() + cab > INT_MAX) {
+      printf("PencilTranspose: local pencil too large for MPI counts, "
+             "use more ranks.\n");
+      fflush(0); MPI_Abort(comm_, 1);
+    }
+    abcCounts_.push_back((int)abc);
+    cabCounts_.push_back((int)cab);
+    abcDispls_.push_back(abcDispls_.back() + (int)abc);
+    cabDispls_.push_back(cabDispls_.back() + (int)cab);
+  }
+  sendBuf_.resize(std::max(abcDispls_.back(), cabDispls_.back()));
+  recvBuf_.resize(sendBuf_.size());
+}
+
+size_t PencilTranspose::sizeABC() const
+{
+  return (size_t)A_ * bCount_[rank_] * cTotal_ * tuple_;
+}
+
+size_t PencilTranspose::sizeCAB() const
+{
+  return (size_t)cCount_[rank_] * A_ * bPadded_ * tuple_;
+}
+
+void PencilTranspose::exchange(const std::vector<int> &sendCounts,
+                               const std::vector<int> &sendDispls,
+                               const std::vector<int> &recvCounts,
+                               const std::vector<int> &recvDispls)
+{
+  MPI_Alltoallv(sendBuf_.data(), sendCounts.data(), sendDispls.data(), MPIREAL,
+                recvBuf_.data(), recvCounts.data(), recvDispls.data(), MPIREAL,
+                comm_);
+}
+
+void PencilTranspose::forward(const Real * const in, Real * const out)
+{
+  const int t = tuple_, bl = bCount_[rank_], cl = cCount_[rank_];
+
+  // Messages are [A][B_local][C chunk of the destination].
+  for (int q = 0; q < size_; ++q) {
+    Real * const buf = sendBuf_.data() + abcDispls_[q];
+    const size_t len = (size_t)cCount_[q] * t;
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int a = 0; a < A_; ++a)
+    for (int b = 0; b < bl; ++b) {
+      const size_t ab = (size_t)a * bl + b;
+      std::copy_n(in + (ab * cTotal_ + cStart_[q]) * t, len, buf + ab * len);
+    }
+  }
+
+  exchange(abcCounts_, abcDispls_, cabCounts_, cabDispls_);
+
+  for (int q = 0; q < size_; ++q) {
+    const Real * const buf = recvBuf_.data() + cabDispls_[q];
+    const int bq = bCount_[q];
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int c = 0; c < cl; ++c)
+    for (int a = 0; a < A_; ++a) {
+      Real * const dst = out + (((size_t)c * A_ + a) * bPadded_ + bStart_[q]) * t;
+      for (int b = 0; b < bq; ++b)
+      for (int j = 0; j < t; ++j)
+        dst[b * t + j] = buf[(((size_t)a * bq + b) * cl + c) * t + j];
+    }
+  }
+
+  if (bPadded_ > bTotal_) {
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int c = 0; c < cl; ++c)
+    for (int a = 0; a < A_; ++a) {
+      Real * const dst = out + ((size_t)c * A_ + a) * bPadded_ * t;
+      std::fill(dst + bTotal_ * t, dst + bPadded_ * t, (Real)0);
+    }
+  }
+}
+
+void PencilTranspose::backward(const Real * const in, Real * const out)
+{
+  const int t = tuple_, bl = bCount_[rank_], cl = cCount_[rank_];
+
+  // Messages are [A][B chunk of the destination][C_local].
+  for (int q = 0; q < size_; ++q) {
+    Real * const buf = sendBuf_.data() + cabDispls_[q];
+    const int bq = bCount_[q];
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int c = 0; c < cl; ++c)
+    for (int a = 0; a < A_; ++a) {
+      const Real * const src =
+          in + (((size_t)c * A_ + a) * bPadded_ + bStart_[q]) * t;
+      for (int b = 0; b < bq; ++b)
+      for (int j = 0; j < t; ++j)
+        buf[(((size_t)a * bq + b) * cl + c) * t + j] = src[b * t + j];
+    }
+  }
+
+  exchange(cabCounts_, cabDispls_, abcCounts_, abcDispls_);
+
+  for (int q = 0; q < size_; ++q) {
+    const Real * const buf = recvBuf_.data() + abcDispls_[q];
+    const size_t len = (size_t)cCount_[q] * t;
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int a = 0; a < A_; ++a)
+    for (int b = 0; b < bl; ++b) {
+      const size_t ab = (size_t)a * bl + b;
+      std::copy_n(buf + ab * len, len, out + (ab * cTotal_ + cStart_[q]) * t);
+    }
+  }
+}
+
+CubismUP_3D_NAMESPACE_END
+#undef MPIREAL
@@ -0,0 +1,65 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_PencilTranspose_h
+#define CubismUP_3D_PencilTranspose_h
+
+#include "../Base.h"
+
+#include <mpi.h>
+
+#include <vector>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+/*
+ * Global transpose between two pencil layouts of a 3D array, as done by the
+ * transposes of the pencil FFTs (same scheme as accfft's transpose.cpp):
+ *
+ *   forward:  [A][B_local][C]       ->  [C_local][A][B]
+ *   backward: [C_local][A][B]       ->  [A][B_local][C]
+ *
+ * B is split over the ranks of `comm` before the transpose, C after it, in
+ * rank order. A must be the same on all ranks of `comm`. Each element is a
+ * tuple of `tuple` Reals (2 for complex numbers). In the [C][A][B] layout B
+ * can be padded to `bPadded` elements: the forward transpose zeroes the
+ * padding and the backward one ignores it.
+ */
+class PencilTranspose
+{
+public:
+  PencilTranspose(MPI_Comm comm, int A, const std::vector<int> &bCounts,
+                  int bPadded, const std::vector<int> &cCounts, int tuple = 1);
+
+  void forward(const Real *in, Real *out);
+  void backward(const Real *in, Real *out);
+
+  // Number of Reals of the two layouts on this rank.
+  size_t sizeABC() const;
+  size_t sizeCAB() const;
+
+  // Balanced split of n elements into `parts` chunks.
+  static std::vector<int> split(int n, int parts);
+
+private:
+  void exchange(const std::vector<int> &sendCounts,
+                const std::vector<int> &sendDispls,
+                const std::vector<int> &recvCounts,
+                const std::vector<int> &recvDispls);
+
+  MPI_Comm comm_;
+  int rank_, size_;
+  const int A_, bPadded_, tuple_;
+  int bTotal_ = 0, cTotal_ = 0;
+  std::vector<int> bCount_, bStart_, cCount_, cStart_;
+  // Counts and displacements in Reals of the [A][B_local][C] side (abc) and
+  // of the [C_local][A][B] side (cab) of the exchange, per rank.
+  std::vector<int> abcCounts_, abcDispls_, cabCounts_, cabDispls_;
+  std::vector<Real> sendBuf_, recvBuf_;
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_PencilTranspose_h
@@ -129,6 +129,67 @@ void PoissonSolver::_fftw2cub() const
   }
 }
 
+void PoissonSolver::exchangeGhosts()
+{
+  if (not bGhostsNeighbours) {
+    const bool bPeriodic[3] = {
+      sim.BCx_flag == periodic, sim.BCy_flag == periodic, sim.BCz_flag == periodic
+    };
+    int dims[3], periods[3], coords[3];
+    MPI_Cart_get(m_comm, 3, dims, periods, coords);
+    for (int d = 0; d < 3; ++d)
+    for (int side = 0; side < 2; ++side) {
+      int c[3] = {coords[0], coords[1], coords[2]};
+      c[d] += side ? 1 : -1;
+      if (c[d] < 0 || c[d] >= dims[d]) {
+        if (not bPeriodic[d]) {
+          ghostsNeighbours[2 * d + side] = MPI_PROC_NULL;
+          continue;
+        }
+        c[d] = (c[d] + dims[d]) % dims[d];
+      }
+      MPI_Cart_rank(m_comm, c, &ghostsNeighbours[2 * d + side]);
+    }
+    for (int f = 0; f < 6; ++f) {
+      const int d = f / 2;
+      ghosts[f].resize(myN[(d + 1) % 3] * myN[(d + 2) % 3]);
+      ghostsSend[f].resize(ghosts[f].size());
+    }
+    bGhostsNeighbours = true;
+  }
+
+  // boundary layers of the box
+  const size_t strides[3] = {stridex, stridey, stridez};
+  for (int f = 0; f < 6; ++f) {
+    const int d = f / 2;
+    const int t0 = d == 0 ? 1 : 0, t1 = d == 2 ? 1 : 2;
+    const size_t layer = (f % 2 ? myN[d] - 1 : 0) * strides[d];
+    Real * const out = ghostsSend[f].data();
+    #pragma omp parallel for schedule(static)
+    for (size_t j = 0; j < myN[t1]; ++j)
+    for (size_t i = 0; i < myN[t0]; ++i)
+      out[i + myN[t0] * j] = data[layer + strides[t0] * i + strides[t1] * j];
+  }
+
+  // a message sent towards face f carries tag f
+  MPI_Request reqs[12];
+  int nreqs = 0;
+  for (int f = 0; f < 6; ++f) {
+    if (ghostsNeighbours[f] == MPI_PROC_NULL) {
+      ghosts[f] = ghostsSend[f];
+      continue;
+    }
+    MPI_Irecv(ghosts[f].data(), (int)ghosts[f].size(), MPIREAL,
+              ghostsNeighbours[f], f ^ 1, m_comm, &reqs[nreqs++]);
+  }
+  for (int f = 0; f < 6; ++f) {
+    if (ghostsNeighbours[f] == MPI_PROC_NULL) continue;
+    MPI_Isend(ghostsSend[f].data(), (int)ghostsSend[f].size(), MPIREAL,
+              ghostsNeighbours[f], f, m_comm, &reqs[nreqs++]);
+  }
+  MPI_Waitall(nreqs, reqs, MPI_STATUSES_IGNORE);
+}
+
 void PoissonSolver::reset() const
 {
   memset(data, 0, data_size * sizeof(Real));
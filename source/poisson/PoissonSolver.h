@@ -19,6 +19,20 @@
 
 CubismUP_3D_NAMESPACE_BEGIN
 
+// Precision of the transforms of PoissonSolverMixed and PoissonSolverPeriodic.
+// With CUP_POISSON_MIXED_PRECISION they transform in single precision from and
+// to the double precision `data`. With -poissonDefectCorrection they refine
+// the solution with one defect correction whose residual is computed in
+// double precision.
+#ifdef CUP_POISSON_MIXED_PRECISION
+#ifdef CUP_SINGLE_PRECISION
+#error "CUP_POISSON_MIXED_PRECISION requires a double precision build."
+#endif
+typedef float TransformReal;
+#else
+typedef Real TransformReal;
+#endif
+
 class PoissonSolver
 {
  protected:
@@ -44,6 +58,13 @@ class PoissonSolver
   };
   const size_t myN[3]={ mybpd[0]*bs[0], mybpd[1]*bs[1], mybpd[2]*bs[2] };
 
+  // One layer of cells of `data` beyond each face (-x,+x,-y,+y,-z,+z) of the
+  // rank box, filled by exchangeGhosts(). Face d holds the box cells in the
+  // two other directions, the lower of them running fastest.
+  std::vector<Real> ghosts[6], ghostsSend[6];
+  int ghostsNeighbours[6] = {0, 0, 0, 0, 0, 0};
+  bool bGhostsNeighbours = false;
+
   Real computeAverage() const;
   Real computeAverage_nonUniform() const;
   Real computeRelativeCorrection(bool coldrun = false) const;
@@ -115,6 +136,26 @@ class PoissonSolver
     return data[dest_index];
   }
 
+  // Block with the local indices of the resident block `info`.
+  const cubism::BlockInfo& _localInfo(const cubism::BlockInfo &info) const
+  {
+    assert(local_infos[info.blockID].blockID == info.blockID);
+    return local_infos[info.blockID];
+  }
+
+  size_t _localN(const int d) const { return myN[d]; }
+
+  // Ghost of face `f` at the box cell (i, j) along the two other directions.
+  Real _ghost(const int f, const int i, const int j) const
+  {
+    assert(ghosts[f].size() > 0);
+    return ghosts[f][i + myN[f < 2 ? 1 : 0] * j];
+  }
+
+  // Fills the ghosts of `data` from the neighbouring ranks. On non-periodic
+  // domain faces they repeat the boundary cells, as the pressure BC of labs.
+  void exchangeGhosts();
+
   void _cub2fftw() const;
 
   void _fftw2cub() const;
@@ -39,14 +39,29 @@ void PoissonSolverMixed_HYPRE::solve()
   HYPRE_StructVectorSetBoxValues(hypre_rhs, ilower, iupper, data);
   sim.stopProfiler();
 
+  // The setup of the constructor is kept, the matrix never changes, and the
+  // solution of the previous step is the initial guess.
   sim.startProfiler("HYPRE solve");
-  if (solver == "gmres")
+  HYPRE_Int iterations = 0;
+  HYPRE_Real residual = 0;
+  if (solver == "gmres") {
     HYPRE_StructGMRESSolve(hypre_solver, hypre_mat, hypre_rhs, hypre_sol);
-  else if (solver == "smg")
+    HYPRE_StructGMRESGetNumIterations(hypre_solver, &iterations);
+    HYPRE_StructGMRESGetFinalRelativeResidualNorm(hypre_solver, &residual);
+  } else if (solver == "smg") {
     HYPRE_StructSMGSolve(hypre_solver, hypre_mat, hypre_rhs, hypre_sol);
-  else
+    HYPRE_StructSMGGetNumIterations(hypre_solver, &iterations);
+    HYPRE_StructSMGGetFinalRelativeResidualNorm(hypre_solver, &residual);
+  } else {
     HYPRE_StructPCGSolve(hypre_solver, hypre_mat, hypre_rhs, hypre_sol);
+    HYPRE_StructPCGGetNumIterations(hypre_solver, &iterations);
+    HYPRE_StructPCGGetFinalRelativeResidualNorm(hypre_solver, &residual);
+  }
   sim.stopProfiler();
+  sim.addPoissonSolve(iterations, residual);
+  if(sim.verbose)
+    printf("HYPRE %s: %d iterations, relative residual %e\n", solver.c_str(),
+           (int) iterations, (double) residual);
 
   sim.startProfiler("HYPRE getBoxV");
   HYPRE_StructVectorGetBoxValues(hypre_sol, ilower, iupper, data);
@@ -59,7 +74,6 @@ void PoissonSolverMixed_HYPRE::solve()
     // Subtract average pressure from all gridpoints
     #pragma omp parallel for schedule(static)
     for (size_t i = 0; i < data_size; i++) data[i] -= avgP;
-    // Set this new mean-0 pressure as next guess
     HYPRE_StructVectorSetBoxValues(hypre_sol, ilower, iupper, data);
     // Save pressure of a corner of the grid so that it can be imposed next time
     pLast = data[fixed_idx];
@@ -69,7 +83,7 @@ void PoissonSolverMixed_HYPRE::solve()
 }
 
 PoissonSolverMixed_HYPRE::PoissonSolverMixed_HYPRE(SimulationData&s) :
-  PoissonSolver(s), solver("pcg")
+  PoissonSolver(s), solver(s.hypreSolver)
 {
   printf("Employing HYPRE-based Poisson solver with Dirichlet BCs. Rank %d pos {%d %d %d}\n", m_rank, peidx[0], peidx[1], peidx[2]);
   if(bRankHoldsFixedDOF)
@@ -213,20 +227,28 @@ PoissonSolverMixed_HYPRE::PoissonSolverMixed_HYPRE(SimulationData&s) :
   HYPRE_StructVectorAssemble(hypre_rhs);
   HYPRE_StructVectorAssemble(hypre_sol);
 
+  // -poissonTol and -poissonMaxIter override the defaults of each solver
+  const auto tol = [&](const double def) {
+    return sim.bPoissonTolSet ? sim.poissonTol : def;
+  };
+  const auto maxIter = [&](const int def) {
+    return sim.bPoissonMaxIterSet ? sim.poissonMaxIter : def;
+  };
+
   if (solver == "gmres") {
     printf("Using GMRES solver\n"); fflush(0);
     HYPRE_StructGMRESCreate(m_comm, &hypre_solver);
-    HYPRE_StructGMRESSetTol(hypre_solver, 1e-2);
+    HYPRE_StructGMRESSetTol(hypre_solver, tol(1e-2));
     HYPRE_StructGMRESSetPrintLevel(hypre_solver, 2);
-    HYPRE_StructGMRESSetMaxIter(hypre_solver, 1000);
+    HYPRE_StructGMRESSetMaxIter(hypre_solver, maxIter(1000));
     HYPRE_StructGMRESSetup(hypre_solver, hypre_mat, hypre_rhs, hypre_sol);
   }
   else if (solver == "smg") {
     printf("Using SMG solver\n"); fflush(0);
     HYPRE_StructSMGCreate(m_comm, &hypre_solver);
     //HYPRE_StructSMGSetMemoryUse(hypre_solver, 0);
-    HYPRE_StructSMGSetMaxIter(hypre_solver, 100);
-    HYPRE_StructSMGSetTol(hypre_solver, 1e-3);
+    HYPRE_StructSMGSetMaxIter(hypre_solver, maxIter(100));
+    HYPRE_StructSMGSetTol(hypre_solver, tol(1e-3));
     //HYPRE_StructSMGSetRelChange(hypre_solver, 0);
     HYPRE_StructSMGSetPrintLevel(hypre_solver, 3);
     HYPRE_StructSMGSetNumPreRelax(hypre_solver, 1);
@@ -234,24 +256,31 @@ PoissonSolverMixed_HYPRE::PoissonSolverMixed_HYPRE(SimulationData&s) :
 
     HYPRE_StructSMGSetup(hypre_solver, hypre_mat, hypre_rhs, hypre_sol);
   }
-  else {
-    printf("Using PCG solver\n"); fflush(0);
+  else if (solver == "pcg") {
+    printf("Using PFMG preconditioned PCG solver\n"); fflush(0);
     HYPRE_StructPCGCreate(m_comm, &hypre_solver);
-    HYPRE_StructPCGSetMaxIter(hypre_solver, 1000);
-    HYPRE_StructPCGSetTol(hypre_solver, 1e-3);
+    HYPRE_StructPCGSetMaxIter(hypre_solver, maxIter(1000));
+    HYPRE_StructPCGSetTol(hypre_solver, tol(1e-3));
+    HYPRE_StructPCGSetTwoNorm(hypre_solver, 1);
     HYPRE_StructPCGSetPrintLevel(hypre_solver, 0);
-    if(0)
-    { // Use SMG preconditioner
-      HYPRE_StructSMGCreate(m_comm, &hypre_precond);
-      HYPRE_StructSMGSetMaxIter(hypre_precond, 1000);
-      HYPRE_StructSMGSetTol(hypre_precond, 0);
-      HYPRE_StructSMGSetNumPreRelax(hypre_precond, 1);
-      HYPRE_StructSMGSetNumPostRelax(hypre_precond, 1);
-      HYPRE_StructPCGSetPrecond(hypre_solver, HYPRE_StructSMGSolve,
-                                HYPRE_StructSMGSetup, hypre_precond);
+    { // One PFMG V-cycle with symmetric smoothing per iteration
+      HYPRE_StructPFMGCreate(m_comm, &hypre_precond);
+      HYPRE_StructPFMGSetMaxIter(hypre_precond, 1);
+      HYPRE_StructPFMGSetTol(hypre_precond, 0);
+      HYPRE_StructPFMGSetZeroGuess(hypre_precond);
+      HYPRE_StructPFMGSetRelaxType(hypre_precond, 2);
+      HYPRE_StructPFMGSetNumPreRelax(hypre_precond, 1);
+      HYPRE_StructPFMGSetNumPostRelax(hypre_precond, 1);
+      HYPRE_StructPCGSetPrecond(hypre_solver, HYPRE_StructPFMGSolve,
+                                HYPRE_StructPFMGSetup, hypre_precond);
     }
     HYPRE_StructPCGSetup(hypre_solver, hypre_mat, hypre_rhs, hypre_sol);
   }
+  else {
+    fprintf(stderr, "PoissonSolverMixed_HYPRE: ERROR: unknown solver %s.\n",
+            solver.c_str());
+    fflush(0); exit(1);
+  }
 }
 
 PoissonSolverMixed_HYPRE::~PoissonSolverMixed_HYPRE()
@@ -260,8 +289,10 @@ PoissonSolverMixed_HYPRE::~PoissonSolverMixed_HYPRE()
     HYPRE_StructGMRESDestroy(hypre_solver);
   else if (solver == "smg")
     HYPRE_StructSMGDestroy(hypre_solver);
-  else
+  else {
     HYPRE_StructPCGDestroy(hypre_solver);
+    HYPRE_StructPFMGDestroy(hypre_precond);
+  }
   HYPRE_StructGridDestroy(hypre_grid);
   HYPRE_StructStencilDestroy(hypre_stencil);
   HYPRE_StructMatrixDestroy(hypre_mat);
@@ -0,0 +1,139 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "PoissonSolverKrylov.h"
+#include "PoissonSolverMixed.h"
+#ifndef _ACCFFT_
+#include "PoissonSolverMixedPencil.h"
+#endif
+
+#include <algorithm>
+
+CubismUP_3D_NAMESPACE_BEGIN
+using namespace cubism;
+
+PoissonSolverKrylov::PoissonSolverKrylov(SimulationData& s)
+  : PoissonSolverMultigrid(s)
+{
+  if (sim.bUseUnboundedBC) {
+    fprintf(stderr, "PoissonSolverKrylov: ERROR: unbounded BCs are not supported.\n");
+    fflush(0); exit(1);
+  }
+  // dv (cm, cp) is not symmetric on stretched grids, which CG requires
+  bool bCG = sim.useSolver == "pcg";
+  if (bCG && sim.bUseStretchedGrid) {
+    if (sim.rank == 0)
+      fprintf(stderr, "PoissonSolverKrylov: WARNING: CG needs a symmetric "
+              "operator, using BiCGStab on the stretched grid.\n");
+    bCG = false;
+  }
+  const Krylov::Method method = bCG ? Krylov::CG : Krylov::BiCGStab;
+  krylov = std::make_unique<Krylov>(m_comm, data_size, method);
+  x.assign(data_size, 0);
+
+  if (sim.poissonPreconditioner == "fft")
+  {
+    #ifndef _ACCFFT_
+    // FFTW slab solvers need the ranks to be split along x only, the pencil
+    // solvers along x and y
+    if (sim.nprocsy > 1)
+      fft.reset(new PoissonSolverMixedPencil(sim));
+    else
+    #endif
+      fft.reset(new PoissonSolverMixed(sim));
+
+    if (sim.bUseStretchedGrid) {
+      const Real vHat = std::pow(sim.hmean, 3);
+      scale.resize(data_size);
+      for (const BlockInfo &info : local_infos) {
+        const size_t offset = _offset(info);
+        for(int iz=0; iz<BlockType::sizeZ; iz++)
+        for(int iy=0; iy<BlockType::sizeY; iy++)
+        for(int ix=0; ix<BlockType::sizeX; ix++) {
+          Real h[3]; info.spacing(h, ix, iy, iz);
+          scale[_dest(offset, iz, iy, ix)] = std::sqrt(vHat / (h[0]*h[1]*h[2]));
+        }
+      }
+    }
+  }
+  else if (sim.poissonPreconditioner != "multigrid")
+  {
+    fprintf(stderr, "PoissonSolverKrylov: ERROR: unknown preconditioner %s.\n",
+            sim.poissonPreconditioner.c_str());
+    fflush(0); exit(1);
+  }
+}
+
+void PoissonSolverKrylov::precondition(const Real * const r, Real * const z)
+{
+  if (fft == nullptr) {
+    multigrid().precondition(r, z);
+    return;
+  }
+
+  Real * const in_out = fft->data;
+  const size_t SX = fft->stridex, SY = fft->stridey, SZ = fft->stridez;
+  const bool bScale = scale.size() > 0;
+  #pragma omp parallel for schedule(static)
+  for (size_t iz = 0; iz < myN[2]; ++iz)
+  for (size_t iy = 0; iy < myN[1]; ++iy)
+  for (size_t ix = 0; ix < myN[0]; ++ix) {
+    const size_t i = ix + myN[0] * (iy + myN[1] * iz);
+    in_out[SX*ix + SY*iy + SZ*iz] = bScale ? scale[i] * r[i] : r[i];
+  }
+
+  fft->solve();
+
+  #pragma omp parallel for schedule(static)
+  for (size_t iz = 0; iz < myN[2]; ++iz)
+  for (size_t iy = 0; iy < myN[1]; ++iy)
+  for (size_t ix = 0; ix < myN[0]; ++ix) {
+    const size_t i = ix + myN[0] * (iy + myN[1] * iz);
+    const Real sol = in_out[SX*ix + SY*iy + SZ*iz];
+    z[i] = bScale ? scale[i] * sol : sol;
+  }
+}
+
+void PoissonSolverKrylov::solve()
+{
+  sim.startProfiler("Krylov cub2rhs");
+  _cub2fftw();
+  {
+    // singular problem: the rhs must have zero mean
+    const Real avgRHS = computeAverage();
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < data_size; ++i) data[i] -= avgRHS;
+  }
+  sim.stopProfiler();
+
+  sim.startProfiler("Krylov solve");
+  Multigrid & mg = multigrid();
+  const int iter = krylov->solve(
+      [&mg](const Real *a, Real *b) { mg.apply(a, b); },
+      [this](const Real *r, Real *z) { precondition(r, z); },
+      data, x.data(), sim.poissonTol, 0, sim.poissonMaxIter);
+  sim.stopProfiler();
+  const double rhsNorm = std::max(krylov->lastRHSNorm(), 1e-300);
+  sim.addPoissonSolve(iter, krylov->lastResidual() / rhsNorm);
+
+  // zero-mean solution, also kept as the initial guess of the next solve
+  std::copy(x.begin(), x.end(), data);
+  const Real avgP = computeAverage();
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < data_size; ++i) {
+    data[i] -= avgP;
+    x[i] = data[i];
+  }
+
+  if (sim.verbose)
+    printf("Krylov (%s): %d iterations, residual %e (rhs %e)\n",
+           sim.useSolver.c_str(), iter, krylov->lastResidual(),
+           krylov->lastRHSNorm());
+}
+
+PoissonSolverKrylov::~PoissonSolverKrylov() = default;
+
+CubismUP_3D_NAMESPACE_END
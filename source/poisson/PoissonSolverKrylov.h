@@ -0,0 +1,45 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_PoissonSolverKrylov_h
+#define CubismUP_3D_PoissonSolverKrylov_h
+
+#include "PoissonSolverMultigrid.h"
+#include "Krylov.h"
+
+#include <memory>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+// Preconditioned CG or BiCGStab on the matrix of PoissonSolverMultigrid, for
+// stretched grids without PETSc. Selected with -useSolver pcg or bicgstab;
+// pcg falls back to BiCGStab on stretched grids, where A is not symmetric.
+// The preconditioner (-poissonPrec) is either the cosine/Fourier solve of
+// PoissonSolverMixed on the mean spacing (fft, default) or one V-cycle
+// (multigrid). Each solve starts from the previous pressure.
+class PoissonSolverKrylov : public PoissonSolverMultigrid
+{
+  std::unique_ptr<Krylov> krylov;
+  std::unique_ptr<PoissonSolver> fft;
+  // previous solution, and symmetric scaling sqrt(hmean^3 / dv) of the
+  // residual around the uniform FFT solve
+  std::vector<Real> x, scale;
+
+  void precondition(const Real *r, Real *z);
+
+ public:
+  PoissonSolverKrylov(SimulationData& s);
+  ~PoissonSolverKrylov();
+
+  void solve() override;
+
+  std::string getName() {
+    return sim.useSolver;
+  }
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_PoissonSolverKrylov_h
@@ -10,6 +10,9 @@
 #define CubismUP_3D_PoissonSolverMixed_h
 
 #include "PoissonSolver.h"
+#include "WideLaplacian.h"
+
+#include <memory>
 
 CubismUP_3D_NAMESPACE_BEGIN
 
@@ -18,13 +21,26 @@ class PoissonSolverMixed : public PoissonSolver
   void * fwd, * bwd;
   ptrdiff_t alloc_local=0,local_n0=0,local_0_start=0,local_n1=0,local_1_start=0;
   const double h = sim.uniformH();
+  // BALANCE TWO PROBLEMS:
+  // - if only grid consistent odd DOF and even DOF do not 'talk' to each others
+  // - if only spectral then nont really div free
+  // COMPROMISE: define a tolerance that balances two effects
+  static constexpr double tol = 0.01;
+  // transform buffer, `data` itself unless CUP_POISSON_MIXED_PRECISION
+  TransformReal * buf = nullptr;
+  // mixed precision only: spectral part of the operator applied to the
+  // solution, and the grid consistent part for the defect correction
+  TransformReal * specBuf = nullptr;
+  std::unique_ptr<WideLaplacian> wideLaplacian;
   inline bool DFT_X() const { return sim.BCx_flag == periodic; }
   inline bool DFT_Y() const { return sim.BCy_flag == periodic; }
   inline bool DFT_Z() const { return sim.BCz_flag == periodic; }
 
  protected:
 
-  template<bool DFTX, bool DFTY, bool DFTZ> void _solve()
+  // If `spec` is given, it receives the spectral part of the operator
+  // applied to the solution, in units of the right-hand side.
+  template<bool DFTX, bool DFTY, bool DFTZ> void _solve(TransformReal* spec)
   {
     // if BC flag == 1 fourier, else cosine transform
     const Real normX = (DFTX ? 1.0 : 0.5) / gsize[0];
@@ -36,18 +52,12 @@ class PoissonSolverMixed : public PoissonSolver
     // factor 1/h here is becz input to this solver is h^3 * RHS:
     // (other h^2 goes away from FD coef or wavenumeber coef)
     const Real norm_factor = (normX / h) * normY * normZ;
-    Real *const in_out = data;
+    TransformReal *const in_out = buf;
     const long nKx = static_cast<long>(gsize[0]);
     const long nKy = static_cast<long>(gsize[1]);
     const long nKz = static_cast<long>(gsize[2]);
     const long shifty = static_cast<long>(local_1_start);
 
-    // BALANCE TWO PROBLEMS:
-    // - if only grid consistent odd DOF and even DOF do not 'talk' to each others
-    // - if only spectral then nont really div free
-    // COMPROMISE: define a tolerance that balances two effects
-    static const Real tol = 0.01;
-
     #pragma omp parallel for schedule(static)
     for(long lj = 0; lj<static_cast<long>(local_n1); ++lj)
     {
@@ -69,7 +79,10 @@ class PoissonSolverMixed : public PoissonSolver
           const Real rkz2 = std::pow( (kz + (DFTZ? 0 : (Real)0.5)) * waveFacZ, 2);
           const Real denZ = (1-tol) * (std::cos(2*waveFacZ*k)-1)/2 - tol*rkz2;
 
-          in_out[linidx] *= norm_factor/(denX + denY + denZ);
+          const Real factor = norm_factor/(denX + denY + denZ);
+          if (spec != nullptr)
+            spec[linidx] = in_out[linidx] * factor * h * (-tol) * (rkx2 + rky2 + rkz2);
+          in_out[linidx] *= factor;
         }
       }
 
@@ -77,8 +90,12 @@ class PoissonSolverMixed : public PoissonSolver
 
     //if (shifty==0 && DFTX && DFTY && DFTZ) in_out[0] = 0;
     if (shifty==0) in_out[0] = 0;
+    if (shifty==0 && spec != nullptr) spec[0] = 0;
   }
 
+  void _solve(TransformReal* spec);
+  void _defectCorrection();
+
  public:
 
   PoissonSolverMixed(SimulationData & s);
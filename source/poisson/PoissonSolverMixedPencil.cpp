@@ -0,0 +1,171 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "PoissonSolverMixedPencil.h"
+#include "PoissonSolver_common.h"
+#include "FFTWWisdom.h"
+
+CubismUP_3D_NAMESPACE_BEGIN
+using namespace cubism;
+
+namespace {
+
+// Same denominators as PoissonSolverMixed::_solve, for the modes
+// [start, start+count) of a direction with N cells.
+std::vector<Real> denominators(const size_t N, const bool DFT,
+                               const int start, const int count)
+{
+  // see PoissonSolverMixed::_solve for the choice of tol
+  static const Real tol = 0.01;
+  const Real waveFac = (DFT ? 2 : 1) * M_PI / N;
+  std::vector<Real> den(count);
+  for (int j = 0; j < count; ++j) {
+    const long i = start + j;
+    const long k = DFT ? ((i <= (long)N/2) ? i : (long)N-i) : i;
+    const Real rk2 = std::pow( (k + (DFT? 0 : (Real)0.5)) * waveFac, 2);
+    den[j] = (1-tol) * (std::cos(2*waveFac*i)-1)/2 - tol*rk2;
+  }
+  return den;
+}
+
+}
+
+PoissonSolverMixedPencil::PoissonSolverMixedPencil(SimulationData & s)
+  : PoissonSolver(s)
+{
+  int dims[3], periods[3], coords[3];
+  MPI_Cart_get(m_comm, 3, dims, periods, coords);
+  if (dims[2] != 1) {
+    printf("PoissonSolverMixedPencil: ranks may only be split along x and y "
+           "(-nprocsz 1).\n");
+    fflush(0); MPI_Abort(m_comm, 1);
+  }
+  if (gsize[2] < (size_t)dims[1] || gsize[1] < (size_t)dims[0]) {
+    printf("PoissonSolverMixedPencil: need at least %d cells along z and %d "
+           "along y.\n", dims[1], dims[0]);
+    fflush(0); MPI_Abort(m_comm, 1);
+  }
+  const int keepY[3] = {0, 1, 0}, keepX[3] = {1, 0, 0};
+  MPI_Cart_sub(m_comm, keepY, &rowComm);
+  MPI_Cart_sub(m_comm, keepX, &colComm);
+
+  const int retval = _FFTW_(init_threads)();
+  if(retval==0) {
+    fprintf(stderr, "PoissonSolverMixedPencil ERROR: Call to fftw_init_threads() returned zero.\n");
+    fflush(0); exit(1);
+  }
+  _FFTW_(plan_with_nthreads)(omp_get_max_threads());
+  _FFTW_(mpi_init)();
+
+  // Z-pencils are the blocks of this rank, y-pencils split z among the ranks
+  // of the row, x-pencils split y among the ranks of the column.
+  const int Nx = gsize[0], Ny = gsize[1], Nz = gsize[2];
+  const int nx = myN[0], ny = myN[1];
+  const std::vector<int> zCounts = PencilTranspose::split(Nz, dims[1]);
+  const std::vector<int> yCounts = PencilTranspose::split(Ny, dims[0]);
+  const int nz = zCounts[coords[1]], nyX = yCounts[coords[0]];
+  int zStart = 0, yStart = 0;
+  for (int i = 0; i < coords[1]; ++i) zStart += zCounts[i];
+  for (int i = 0; i < coords[0]; ++i) yStart += yCounts[i];
+  ZY = std::make_unique<PencilTranspose>(rowComm, nx,
+      std::vector<int>(dims[1], ny), Ny, zCounts);
+  YX = std::make_unique<PencilTranspose>(colComm, nz,
+      std::vector<int>(dims[0], nx), Nx, yCounts);
+
+  data = _FFTW_(alloc_real)(ZY->sizeABC());
+  bufY = _FFTW_(alloc_real)(ZY->sizeCAB());
+  bufX = _FFTW_(alloc_real)(YX->sizeCAB());
+  data_size = (size_t) myN[0] * (size_t) myN[1] * (size_t) myN[2];
+  stridez = 1; // fast
+  stridey = myN[2];
+  stridex = myN[1] * myN[2]; // slow
+
+  // 1D transforms of contiguous lines, in place
+  const auto plan = [](Real * const buf, const int n, const int howmany,
+                       const _FFTW_(r2r_kind) kind) {
+    return (void*) _FFTW_(plan_many_r2r)(1, &n, howmany, buf, NULL, 1, n,
+                                         buf, NULL, 1, n, &kind, FFTW_MEASURE);
+  };
+  importFFTWWisdom(sim, m_comm, "mixedPencil");
+  fwdZ = plan(data, Nz, nx * ny, DFT_Z() ? FFTW_R2HC : FFTW_REDFT10);
+  bwdZ = plan(data, Nz, nx * ny, DFT_Z() ? FFTW_HC2R : FFTW_REDFT01);
+  fwdY = plan(bufY, Ny, nz * nx, DFT_Y() ? FFTW_R2HC : FFTW_REDFT10);
+  bwdY = plan(bufY, Ny, nz * nx, DFT_Y() ? FFTW_HC2R : FFTW_REDFT01);
+  fwdX = plan(bufX, Nx, nyX * nz, DFT_X() ? FFTW_R2HC : FFTW_REDFT10);
+  bwdX = plan(bufX, Nx, nyX * nz, DFT_X() ? FFTW_HC2R : FFTW_REDFT01);
+  exportFFTWWisdom(sim, m_comm, "mixedPencil");
+
+  denX = denominators(Nx, DFT_X(), 0, Nx);
+  denY = denominators(Ny, DFT_Y(), yStart, nyX);
+  denZ = denominators(Nz, DFT_Z(), zStart, nz);
+  bHoldsZeroMode = yStart == 0 && zStart == 0;
+
+  if (sim.verbose)
+    printf("PoissonSolverMixedPencil: %d x %d ranks, x-pencils of %d x %d.\n",
+           dims[0], dims[1], nyX, nz);
+}
+
+void PoissonSolverMixedPencil::solve()
+{
+  sim.startProfiler("PFFTW cub2rhs");
+  _cub2fftw();
+  sim.stopProfiler();
+
+  sim.startProfiler("PFFTW r2c");
+  _FFTW_(execute)((fft_plan) fwdZ);
+  ZY->forward(data, bufY);
+  _FFTW_(execute)((fft_plan) fwdY);
+  YX->forward(bufY, bufX);
+  _FFTW_(execute)((fft_plan) fwdX);
+  sim.stopProfiler();
+
+  sim.startProfiler("PFFTW solve");
+  {
+    const Real normX = (DFT_X() ? 1.0 : 0.5) / gsize[0];
+    const Real normY = (DFT_Y() ? 1.0 : 0.5) / gsize[1];
+    const Real normZ = (DFT_Z() ? 1.0 : 0.5) / gsize[2];
+    // factor 1/h here is becz input to this solver is h^3 * RHS:
+    const Real norm_factor = (normX / h) * normY * normZ;
+    const int Nx = gsize[0], nyX = denY.size(), nz = denZ.size();
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (int iy = 0; iy < nyX; ++iy)
+    for (int iz = 0; iz < nz; ++iz) {
+      Real * const line = bufX + ((size_t)iy * nz + iz) * Nx;
+      const Real denYZ = denY[iy] + denZ[iz];
+      for (int ix = 0; ix < Nx; ++ix)
+        line[ix] *= norm_factor / (denX[ix] + denYZ);
+    }
+    if (bHoldsZeroMode) bufX[0] = 0;
+  }
+  sim.stopProfiler();
+
+  sim.startProfiler("PFFTW c2r");
+  _FFTW_(execute)((fft_plan) bwdX);
+  YX->backward(bufX, bufY);
+  _FFTW_(execute)((fft_plan) bwdY);
+  ZY->backward(bufY, data);
+  _FFTW_(execute)((fft_plan) bwdZ);
+  sim.stopProfiler();
+}
+
+PoissonSolverMixedPencil::~PoissonSolverMixedPencil()
+{
+  _FFTW_(destroy_plan)((fft_plan) fwdZ);
+  _FFTW_(destroy_plan)((fft_plan) bwdZ);
+  _FFTW_(destroy_plan)((fft_plan) fwdY);
+  _FFTW_(destroy_plan)((fft_plan) bwdY);
+  _FFTW_(destroy_plan)((fft_plan) fwdX);
+  _FFTW_(destroy_plan)((fft_plan) bwdX);
+  _FFTW_(free)(data);
+  _FFTW_(free)(bufY);
+  _FFTW_(free)(bufX);
+  MPI_Comm_free(&rowComm);
+  MPI_Comm_free(&colComm);
+  _FFTW_(mpi_cleanup)();
+}
+
+CubismUP_3D_NAMESPACE_END
+#undef MPIREAL
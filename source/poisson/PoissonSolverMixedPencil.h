@@ -0,0 +1,45 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_PoissonSolverMixedPencil_h
+#define CubismUP_3D_PoissonSolverMixedPencil_h
+
+#include "PoissonSolver.h"
+#include "PencilTranspose.h"
+
+#include <memory>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+// Same discretization as PoissonSolverMixed, with a pencil decomposition:
+// ranks may be split along x and y (not z), so the rank count is not capped
+// by the resolution along x. 1D transforms along z, y and x, with global
+// transposes between them:
+//   Z-pencils [x][y][z] -> Y-pencils [z][x][y] -> X-pencils [y][z][x].
+class PoissonSolverMixedPencil : public PoissonSolver
+{
+  MPI_Comm rowComm, colComm; // ranks with the same x, resp. y, coordinate
+  std::unique_ptr<PencilTranspose> ZY, YX;
+  Real * bufY, * bufX;
+  void * fwdZ, * fwdY, * fwdX, * bwdZ, * bwdY, * bwdX;
+  // Denominators of the spectral solve along each direction (local modes).
+  std::vector<Real> denX, denY, denZ;
+  bool bHoldsZeroMode = false;
+  const double h = sim.uniformH();
+  inline bool DFT_X() const { return sim.BCx_flag == periodic; }
+  inline bool DFT_Y() const { return sim.BCy_flag == periodic; }
+  inline bool DFT_Z() const { return sim.BCz_flag == periodic; }
+
+ public:
+  PoissonSolverMixedPencil(SimulationData & s);
+
+  void solve() override;
+
+  ~PoissonSolverMixedPencil();
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_PoissonSolverMixedPencil_h
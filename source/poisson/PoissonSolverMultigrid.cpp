@@ -0,0 +1,86 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "PoissonSolverMultigrid.h"
+
+CubismUP_3D_NAMESPACE_BEGIN
+using namespace cubism;
+
+PoissonSolverMultigrid::PoissonSolverMultigrid(SimulationData& s)
+  : PoissonSolver(s)
+{
+  data = new Real[myN[0] * myN[1] * myN[2]];
+  data_size = (size_t) myN[0] * (size_t) myN[1] * (size_t) myN[2];
+  stridez = myN[1] * myN[0]; // slow
+  stridey = myN[0];
+  stridex = 1; // fast
+
+  // The grid is a tensor product, so spacing and coefficients along a
+  // direction only depend on the index along it.
+  Multigrid::Coefficients coeffs[3];
+  for (int d = 0; d < 3; ++d) {
+    coeffs[d].h.resize(myN[d]);
+    coeffs[d].cm.resize(myN[d]);
+    coeffs[d].cp.resize(myN[d]);
+  }
+  if (sim.bUseStretchedGrid) {
+    for (const BlockInfo &info : local_infos) {
+      const FluidBlock& b = *(FluidBlock*) info.ptrBlock;
+      const BlkCoeffX *const c[3] = {&b.fd_cx.second, &b.fd_cy.second,
+                                     &b.fd_cz.second};
+      for (int d = 0; d < 3; ++d)
+      for (int i = 0; i < bs[d]; ++i) {
+        const size_t I = info.index[d] * bs[d] + i;
+        int idx[3] = {0, 0, 0};
+        idx[d] = i;
+        Real h[3]; info.spacing(h, idx[0], idx[1], idx[2]);
+        coeffs[d].h[I] = h[d];
+        coeffs[d].cm[I] = c[d]->cm1[i];
+        coeffs[d].cp[I] = c[d]->cp1[i];
+      }
+    }
+  } else {
+    const Real h = sim.uniformH();
+    for (int d = 0; d < 3; ++d) {
+      std::fill(coeffs[d].h.begin(), coeffs[d].h.end(), h);
+      std::fill(coeffs[d].cm.begin(), coeffs[d].cm.end(), 1 / (h * h));
+      std::fill(coeffs[d].cp.begin(), coeffs[d].cp.end(), 1 / (h * h));
+    }
+  }
+
+  const int cells[3] = {(int)myN[0], (int)myN[1], (int)myN[2]};
+  const bool periodicBC[3] = {
+    sim.BCx_flag == periodic, sim.BCy_flag == periodic, sim.BCz_flag == periodic
+  };
+  mg = std::make_unique<Multigrid>(m_comm, cells, periodicBC, coeffs);
+  if (sim.verbose)
+    printf("Employing multigrid Poisson solver with %d levels.\n",
+           mg->numLevels());
+}
+
+void PoissonSolverMultigrid::solve()
+{
+  sim.startProfiler("MG cub2rhs");
+  _cub2fftw();
+  sim.stopProfiler();
+
+  sim.startProfiler("MG solve");
+  const int cycles = mg->solve(data, sim.poissonTol, 0, sim.poissonMaxIter);
+  sim.stopProfiler();
+  const double rhsNorm = std::max(mg->lastRHSNorm(), 1e-300);
+  sim.addPoissonSolve(cycles, mg->lastResidual() / rhsNorm);
+
+  if (sim.verbose)
+    printf("Multigrid: %d cycles, residual %e (rhs %e)\n", cycles,
+           mg->lastResidual(), mg->lastRHSNorm());
+}
+
+PoissonSolverMultigrid::~PoissonSolverMultigrid()
+{
+  delete [] data;
+}
+
+CubismUP_3D_NAMESPACE_END
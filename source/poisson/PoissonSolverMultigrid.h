@@ -0,0 +1,39 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_PoissonSolverMultigrid_h
+#define CubismUP_3D_PoissonSolverMultigrid_h
+
+#include "PoissonSolver.h"
+#include "Multigrid.h"
+
+#include <memory>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+// Geometric multigrid on the rank-local box of cells, with the matrix of
+// PoissonSolverMixed_HYPRE: uniform or stretched grids, periodic or
+// zero-gradient boundaries. Selected with -useSolver multigrid.
+class PoissonSolverMultigrid : public PoissonSolver
+{
+  std::unique_ptr<Multigrid> mg;
+
+ public:
+  PoissonSolverMultigrid(SimulationData& s);
+  ~PoissonSolverMultigrid();
+
+  void solve() override;
+
+  // The underlying solver, e.g. to be used as a preconditioner.
+  Multigrid & multigrid() { return *mg; }
+
+  std::string getName() {
+    return "multigrid";
+  }
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_PoissonSolverMultigrid_h
@@ -14,7 +14,7 @@ using namespace cubism;
 
 void PoissonSolverPeriodic::_solve()
 {
-  fft_c *const in_out = (fft_c *) data;
+  fftt_c *const in_out = (fftt_c *) buf;
   // RHS comes into this function premultiplied by h^3 (as in FMM)
   #if 1 // grid-consistent
     // Solution has to be normalized (1/N^3) and multiplied by Laplace op finite
@@ -96,16 +96,16 @@ PoissonSolverPeriodic::PoissonSolverPeriodic(SimulationData & s) : PoissonSolver
     fflush(0); exit(1);
   }
 
-  const int retval = _FFTW_(init_threads)();
+  const int retval = _FFTWT_(init_threads)();
   if(retval==0) {
     fprintf(stderr, "PoissonSolverPeriodic: ERROR: Call to fftw_init_threads() returned zero.\n");
     fflush(0); exit(1);
   }
   const int desired_threads = omp_get_max_threads();
-  _FFTW_(plan_with_nthreads)(desired_threads);
-  _FFTW_(mpi_init)();
+  _FFTWT_(plan_with_nthreads)(desired_threads);
+  _FFTWT_(mpi_init)();
 
-  alloc_local = _FFTW_(mpi_local_size_3d_transposed) (
+  alloc_local = _FFTWT_(mpi_local_size_3d_transposed) (
     gsize[0], gsize[1], gsize[2]/2+1, m_comm,
     &local_n0, &local_0_start, &local_n1, &local_1_start);
 
@@ -115,10 +115,21 @@ PoissonSolverPeriodic::PoissonSolverPeriodic(SimulationData & s) : PoissonSolver
   stridey = 2*nz_hat;
   stridex = myN[1] * 2*nz_hat; // slow
 
-  fwd = (void*) _FFTW_(mpi_plan_dft_r2c_3d)(gsize[0], gsize[1], gsize[2],
-    data, (fft_c *)data, m_comm, FFTW_MPI_TRANSPOSED_OUT | FFTW_MEASURE);
-  bwd = (void*) _FFTW_(mpi_plan_dft_c2r_3d)(gsize[0], gsize[1], gsize[2],
-    (fft_c *)data, data, m_comm, FFTW_MPI_TRANSPOSED_IN  | FFTW_MEASURE);
+  #ifdef CUP_POISSON_MIXED_PRECISION
+    buf = _FFTWT_(alloc_real)(2*alloc_local);
+    const bool bPeriodic[3] = {true, true, true};
+    wideLaplacian.reset(new WideLaplacian(m_comm, gsize, local_0_start,
+                                          local_n0, 2*nz_hat, bPeriodic));
+  #else
+    buf = data;
+  #endif
+
+  importFFTWWisdom(sim, m_comm, "periodic");
+  fwd = (void*) _FFTWT_(mpi_plan_dft_r2c_3d)(gsize[0], gsize[1], gsize[2],
+    buf, (fftt_c *)buf, m_comm, FFTW_MPI_TRANSPOSED_OUT | FFTW_MEASURE);
+  bwd = (void*) _FFTWT_(mpi_plan_dft_c2r_3d)(gsize[0], gsize[1], gsize[2],
+    (fftt_c *)buf, buf, m_comm, FFTW_MPI_TRANSPOSED_IN  | FFTW_MEASURE);
+  exportFFTWWisdom(sim, m_comm, "periodic");
 
   //std::cout <<    bs[0] << " " <<    bs[1] << " " <<    bs[2] << " ";
   //std::cout <<   myN[0] << " " <<   myN[1] << " " <<   myN[2] << " ";
@@ -130,10 +141,14 @@ void PoissonSolverPeriodic::solve()
 {
   sim.startProfiler("FFTW cub2rhs");
   _cub2fftw();
+  #ifdef CUP_POISSON_MIXED_PRECISION
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < data_size; ++i) buf[i] = data[i];
+  #endif
   sim.stopProfiler();
 
   sim.startProfiler("FFTW r2c");
-  _FFTW_(execute)((fft_plan) fwd);
+  _FFTWT_(execute)((fftt_plan) fwd);
   sim.stopProfiler();
 
   sim.startProfiler("FFTW solve");
@@ -141,20 +156,67 @@ void PoissonSolverPeriodic::solve()
   sim.stopProfiler();
 
   sim.startProfiler("FFTW c2r");
-  _FFTW_(execute)((fft_plan) bwd);
+  _FFTWT_(execute)((fftt_plan) bwd);
+  sim.stopProfiler();
+
+  #ifdef CUP_POISSON_MIXED_PRECISION
+    if (sim.bPoissonDefectCorrection) _defectCorrection();
+    else {
+      #pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < data_size; ++i) data[i] = buf[i];
+    }
+  #endif
+}
+
+// One defect correction of the single precision solution in `buf`, `data`
+// still holding the right-hand side, with the residual of the grid
+// consistent operator computed in double precision. Two more transforms:
+// 4 per solve instead of 2.
+void PoissonSolverPeriodic::_defectCorrection()
+{
+  sim.startProfiler("FFTW defect");
+  wideLaplacian->subtract(h / 4, buf, data);
+  // solution to `data`, residual to `buf`
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < data_size; ++i) {
+    const Real residual = data[i];
+    data[i] = buf[i];
+    buf[i] = residual;
+  }
+  sim.stopProfiler();
+
+  sim.startProfiler("FFTW r2c");
+  _FFTWT_(execute)((fftt_plan) fwd);
+  sim.stopProfiler();
+
+  sim.startProfiler("FFTW solve");
+  _solve();
+  sim.stopProfiler();
+
+  sim.startProfiler("FFTW c2r");
+  _FFTWT_(execute)((fftt_plan) bwd);
+  sim.stopProfiler();
+
+  sim.startProfiler("FFTW defect");
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < data_size; ++i) data[i] += buf[i];
   sim.stopProfiler();
 }
 
 PoissonSolverPeriodic::~PoissonSolverPeriodic()
 {
-  _FFTW_(destroy_plan)((fft_plan) fwd);
-  _FFTW_(destroy_plan)((fft_plan) bwd);
+  _FFTWT_(destroy_plan)((fftt_plan) fwd);
+  _FFTWT_(destroy_plan)((fftt_plan) bwd);
+  #ifdef CUP_POISSON_MIXED_PRECISION
+    _FFTWT_(free)(buf);
+  #endif
   _FFTW_(free)(data);
-  _FFTW_(mpi_cleanup)();
+  _FFTWT_(mpi_cleanup)();
 }
 
 CubismUP_3D_NAMESPACE_END
 #undef MPIREAL
+#undef MPITREAL
 
 #if 0
 Real * dump = _FFTW_(alloc_real)(2*alloc_local);
@@ -10,6 +10,9 @@
 #define CubismUP_3D_PoissonSolverPeriodic_h
 
 #include "PoissonSolver.h"
+#include "WideLaplacian.h"
+
+#include <memory>
 
 CubismUP_3D_NAMESPACE_BEGIN
 
@@ -19,10 +22,15 @@ class PoissonSolverPeriodic : public PoissonSolver
   const size_t nz_hat = gsize[2]/2+1;
   const double h = sim.uniformH();
   ptrdiff_t alloc_local=0, local_n0=0, local_0_start=0, local_n1=0, local_1_start=0;
+  // transform buffer, `data` itself unless CUP_POISSON_MIXED_PRECISION
+  TransformReal * buf = nullptr;
+  // mixed precision only: the operator for the defect correction
+  std::unique_ptr<WideLaplacian> wideLaplacian;
 
  protected:
 
   void _solve();
+  void _defectCorrection();
 
  public:
 
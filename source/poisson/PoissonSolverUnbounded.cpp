@@ -12,10 +12,42 @@
 
 #include "PoissonSolverUnbounded.h"
 #include "PoissonSolver_common.h"
+#include "FFTWWisdom.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sstream>
 
 CubismUP_3D_NAMESPACE_BEGIN
 using namespace cubism;
 
+namespace {
+
+// Header of the Green's function cache file, followed by the kernel.
+struct GreenCacheHeader
+{
+  char magic[8];
+  int64_t realSize, N0, N1, N2;
+  double h;
+};
+
+GreenCacheHeader makeGreenCacheHeader(size_t N0, size_t N1, size_t N2, double h)
+{
+  GreenCacheHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, "CUPGRN01", 8);
+  header.realSize = sizeof(Real);
+  header.N0 = N0;
+  header.N1 = N1;
+  header.N2 = N2;
+  header.h = h;
+  return header;
+}
+
+}
+
 PoissonSolverUnbounded::PoissonSolverUnbounded(SimulationData&s) : PoissonSolver(s)
 {
   if (m_N0 % m_size != 0 || m_NN1 % m_size != 0) {
@@ -39,7 +71,11 @@ PoissonSolverUnbounded::PoissonSolverUnbounded(SimulationData&s) : PoissonSolver
   _FFTW_(plan_with_nthreads)(desired_threads);
   _FFTW_(mpi_init)();
 
-  _initialize_green();
+  importFFTWWisdom(sim, m_comm, "unbounded");
+  if (!_load_green()) {
+    _initialize_green();
+    _save_green();
+  }
 
   // FFTW plans
   // input, output, transpose and 2D FFTs (m_local_N0 x m_NN1 x 2m_Nzhat):
@@ -95,13 +131,15 @@ PoissonSolverUnbounded::PoissonSolverUnbounded(SimulationData&s) : PoissonSolver
   m_bwd_tp = (void*) _FFTW_(mpi_plan_many_transpose)(m_NN1, m_N0, 2*m_Nzhat,
           m_local_NN1, m_local_N0, data, data, m_comm,
           FFTW_MEASURE | FFTW_MPI_TRANSPOSED_IN);
+  exportFFTWWisdom(sim, m_comm, "unbounded");
 }
 
 PoissonSolverUnbounded::~PoissonSolverUnbounded()
 {
   _FFTW_(free)(data);
   _FFTW_(free)(m_buf_full);
-  _FFTW_(free)(m_kernel);
+  if (m_kernel_map != nullptr) munmap(m_kernel_map, m_kernel_map_size);
+  else _FFTW_(free)(m_kernel);
   _FFTW_(destroy_plan)((fft_plan) m_fwd_1D);
   _FFTW_(destroy_plan)((fft_plan) m_bwd_1D);
   _FFTW_(destroy_plan)((fft_plan) m_fwd_2D);
@@ -134,8 +172,9 @@ void PoissonSolverUnbounded::solve()
     for (size_t k = 0; k < m_Nzhat; ++k)
     {
       const size_t idx = k + m_Nzhat*(j + m_local_NN1*i);
-      rho_hat[idx][0] *= G_hat[idx]; //normalization is carried on in G_hat
-      rho_hat[idx][1] *= G_hat[idx]; //normalization is carried on in G_hat
+      const size_t kidx = k + m_Nzhat*(i + m_NN0t*j);
+      rho_hat[idx][0] *= G_hat[kidx]; //normalization is carried on in G_hat
+      rho_hat[idx][1] *= G_hat[kidx]; //normalization is carried on in G_hat
     }
   }
   sim.stopProfiler();
@@ -226,7 +265,8 @@ void PoissonSolverUnbounded::_initialize_green()
   for (size_t k = 0; k < m_Nzhat; ++k)
   {
     const size_t linidx = k + m_Nzhat*(j + m_local_NN1*i);
-    m_kernel[linidx] = G_hat[linidx][0] * m_norm_factor;// need real part only
+    const size_t kidx = k + m_Nzhat*(i + m_NN0t*j);
+    m_kernel[kidx] = G_hat[linidx][0] * m_norm_factor;// need real part only
   }
 
   _FFTW_(free)(tf_buf);
@@ -235,6 +275,114 @@ void PoissonSolverUnbounded::_initialize_green()
   _FFTW_(destroy_plan)(greenTP);
 }
 
+std::string PoissonSolverUnbounded::_green_filename() const
+{
+  std::ostringstream name;
+  name << sim.greenCache << ".green_" << m_N0 << "x" << m_N1 << "x" << m_N2
+       << "_" << (sizeof(Real) == sizeof(double) ? "d" : "f") << ".bin";
+  return name.str();
+}
+
+bool PoissonSolverUnbounded::_load_green()
+{
+  if (sim.greenCache.empty()) return false;
+  const std::string filename = _green_filename();
+  const GreenCacheHeader expected = makeGreenCacheHeader(m_N0, m_N1, m_N2, h);
+
+  // rank 0 checks that the file matches this grid and spacing
+  int ok = 0;
+  if (m_rank == 0) {
+    FILE * f = fopen(filename.c_str(), "rb");
+    if (f != nullptr) {
+      GreenCacheHeader header;
+      ok = fread(&header, sizeof(header), 1, f) == 1
+        && std::memcmp(&header, &expected, sizeof(header)) == 0;
+      fclose(f);
+    }
+    if (sim.verbose)
+      printf("Green's function cache %s %s\n", filename.c_str(),
+             ok ? "found." : "not found or not matching, computing kernel.");
+  }
+  MPI_Bcast(&ok, 1, MPI_INT, 0, m_comm);
+  if (!ok) return false;
+
+  // each rank maps its contiguous range of y-indices, or reads it if the
+  // mapping fails
+  const size_t bytes = m_local_NN1 * m_NN0t * m_Nzhat * sizeof(Real);
+  const size_t offset = sizeof(GreenCacheHeader) + m_rank * bytes;
+  const int fd = open(filename.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size >= offset + bytes) {
+    const size_t page = sysconf(_SC_PAGESIZE);
+    const size_t start = offset / page * page;
+    void * const map = mmap(nullptr, offset - start + bytes, PROT_READ,
+                            MAP_PRIVATE, fd, start);
+    if (map != MAP_FAILED) {
+      m_kernel_map = map;
+      m_kernel_map_size = offset - start + bytes;
+      m_kernel = (Real *)((char *)map + (offset - start));
+    } else {
+      m_kernel = _FFTW_(alloc_real)(bytes / sizeof(Real));
+      size_t done = 0;
+      while (done < bytes) {
+        const ssize_t n = pread(fd, (char *)m_kernel + done, bytes - done,
+                                offset + done);
+        if (n <= 0) break;
+        done += n;
+      }
+      if (done < bytes) {
+        _FFTW_(free)(m_kernel);
+        m_kernel = nullptr;
+      }
+    }
+  }
+  if (fd >= 0) close(fd);
+
+  // recompute on all ranks if any rank failed
+  int loaded = m_kernel != nullptr;
+  MPI_Allreduce(MPI_IN_PLACE, &loaded, 1, MPI_INT, MPI_MIN, m_comm);
+  if (!loaded && m_kernel != nullptr) {
+    if (m_kernel_map != nullptr) munmap(m_kernel_map, m_kernel_map_size);
+    else _FFTW_(free)(m_kernel);
+    m_kernel = nullptr;
+    m_kernel_map = nullptr;
+    m_kernel_map_size = 0;
+  }
+  return loaded;
+}
+
+void PoissonSolverUnbounded::_save_green() const
+{
+  if (sim.greenCache.empty()) return;
+  const std::string filename = _green_filename();
+  MPI_File fh;
+  if (MPI_File_open(m_comm, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                    MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+    if (m_rank == 0) {
+      printf("Green's function cache %s could not be written.\n", filename.c_str());
+      fflush(0);
+    }
+    return;
+  }
+  // truncate, so the header of an older file is gone, then kernel first and
+  // header last, so an interrupted write is never loaded
+  MPI_File_set_size(fh, 0);
+  const size_t bytes = m_local_NN1 * m_NN0t * m_Nzhat * sizeof(Real);
+  MPI_Datatype row;
+  MPI_Type_contiguous(m_NN0t * m_Nzhat, MPIREAL, &row);
+  MPI_Type_commit(&row);
+  MPI_File_write_at_all(fh, sizeof(GreenCacheHeader) + m_rank * bytes,
+                        m_kernel, m_local_NN1, row, MPI_STATUS_IGNORE);
+  MPI_Type_free(&row);
+  MPI_File_sync(fh);
+  MPI_Barrier(m_comm);
+  if (m_rank == 0) {
+    const GreenCacheHeader header = makeGreenCacheHeader(m_N0, m_N1, m_N2, h);
+    MPI_File_write_at(fh, 0, &header, sizeof(header), MPI_BYTE, MPI_STATUS_IGNORE);
+  }
+  MPI_File_close(&fh);
+}
+
 void PoissonSolverUnbounded::reset() const
 {
   std::memset(data, 0, 2*m_tp_size*sizeof(Real));
@@ -8,12 +8,14 @@
 //  This algorithm uses the cyclic convolution method described in Eastwood and
 //  Brownrigg (1979) for unbounded domains.
 //  WARNING: This implementation only works with a 1D domain decomposition
-//  along the x-coordinate.
+//  along the x-coordinate, see PoissonSolverUnboundedPencil otherwise.
 #ifndef CubismUP_3D_PoissonSolverUnbounded_h
 #define CubismUP_3D_PoissonSolverUnbounded_h
 
 #include "PoissonSolver.h"
 
+#include <string>
+
 CubismUP_3D_NAMESPACE_BEGIN
 
 class PoissonSolverUnbounded : public PoissonSolver
@@ -43,7 +45,11 @@ class PoissonSolverUnbounded : public PoissonSolver
   // FFT normalization factor
   const Real m_norm_factor = 1.0 / (m_NN0t*h * m_NN1t*h * m_NN2t*h);
   Real* m_buf_full; // full block of m_NN0t x m_local_NN1 x 2m_Nzhat for 1D FFTs
-  Real* m_kernel;   // FFT of Green's function (real part, m_NN0t x m_local_NN1 x m_Nzhat)
+  // FFT of Green's function (real part, m_local_NN1 x m_NN0t x m_Nzhat), either
+  // allocated or a read-only mapping of the cache file
+  Real* m_kernel = nullptr;
+  void* m_kernel_map = nullptr;
+  size_t m_kernel_map_size = 0;
 
   // FFTW plans
   void * m_fwd_1D;
@@ -65,6 +71,12 @@ class PoissonSolverUnbounded : public PoissonSolver
 
   void _initialize_green();
 
+  // Kernel cache enabled with -greenCache <prefix>. The file stores the
+  // kernel for all y-indices in order, independently of the rank layout.
+  std::string _green_filename() const;
+  bool _load_green();
+  void _save_green() const;
+
   void reset() const override;
 
   void _copy_fwd_local();
@@ -0,0 +1,218 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "PoissonSolverUnboundedPencil.h"
+#include "PoissonSolver_common.h"
+#include "FFTWWisdom.h"
+
+CubismUP_3D_NAMESPACE_BEGIN
+using namespace cubism;
+
+namespace {
+
+// In-place 1D transforms of contiguous lines of n elements.
+fft_plan planR2C(Real * const buf, const int & n, const int howmany,
+                 const unsigned flags)
+{
+  return _FFTW_(plan_many_dft_r2c)(1, &n, howmany, buf, NULL, 1, 2*(n/2+1),
+                                   (fft_c*)buf, NULL, 1, n/2+1, flags);
+}
+fft_plan planC2R(Real * const buf, const int & n, const int howmany,
+                 const unsigned flags)
+{
+  return _FFTW_(plan_many_dft_c2r)(1, &n, howmany, (fft_c*)buf, NULL, 1,
+                                   n/2+1, buf, NULL, 1, 2*(n/2+1), flags);
+}
+fft_plan planC2C(Real * const buf, const int & n, const int howmany,
+                 const int sign, const unsigned flags)
+{
+  return _FFTW_(plan_many_dft)(1, &n, howmany, (fft_c*)buf, NULL, 1, n,
+                               (fft_c*)buf, NULL, 1, n, sign, flags);
+}
+
+}
+
+PoissonSolverUnboundedPencil::PoissonSolverUnboundedPencil(SimulationData & s)
+  : PoissonSolver(s)
+{
+  int periods[3];
+  MPI_Cart_get(m_comm, 3, dims, periods, coords);
+  if (dims[2] != 1) {
+    printf("PoissonSolverUnboundedPencil: ranks may only be split along x and "
+           "y (-nprocsz 1).\n");
+    fflush(0); MPI_Abort(m_comm, 1);
+  }
+  if (m_Nzhat < dims[1] || m_NNt[1] < dims[0]) {
+    printf("PoissonSolverUnboundedPencil: too many ranks for the grid.\n");
+    fflush(0); MPI_Abort(m_comm, 1);
+  }
+  const int keepY[3] = {0, 1, 0}, keepX[3] = {1, 0, 0};
+  MPI_Cart_sub(m_comm, keepY, &rowComm);
+  MPI_Cart_sub(m_comm, keepX, &colComm);
+
+  const int retval = _FFTW_(init_threads)();
+  if (retval == 0) {
+    fprintf(stderr, "PoissonSolverUnboundedPencil: ERROR: Call to fftw_init_threads() returned zero.\n");
+    fflush(0); exit(1);
+  }
+  _FFTW_(plan_with_nthreads)(omp_get_max_threads());
+  _FFTW_(mpi_init)();
+
+  // Z-pencils are the blocks of this rank, y-pencils split the z modes among
+  // the ranks of the row, x-pencils split the y modes among the ranks of the
+  // column. Padding along y and x is added by the transposes.
+  zhCounts = PencilTranspose::split(m_Nzhat, dims[1]);
+  yyCounts = PencilTranspose::split(m_NNt[1], dims[0]);
+  const int nx = myN[0], ny = myN[1];
+  const int nzh = zhCounts[coords[1]], nyy = yyCounts[coords[0]];
+  ZY = std::make_unique<PencilTranspose>(rowComm, nx,
+      std::vector<int>(dims[1], ny), m_NNt[1], zhCounts, 2);
+  YX = std::make_unique<PencilTranspose>(colComm, nzh,
+      std::vector<int>(dims[0], nx), m_NNt[0], yyCounts, 2);
+
+  data = _FFTW_(alloc_real)(ZY->sizeABC());
+  bufY = _FFTW_(alloc_real)(ZY->sizeCAB());
+  bufX = _FFTW_(alloc_real)(YX->sizeCAB());
+  data_size = (size_t) myN[0] * (size_t) myN[1] * (size_t) 2*m_Nzhat;
+  stridez = 1; // fast
+  stridey = 2*m_Nzhat;
+  stridex = myN[1] * 2*m_Nzhat; // slow
+
+  importFFTWWisdom(sim, m_comm, "unboundedPencil");
+  fwdZ = (void*) planR2C(data, m_NNt[2], nx * ny, FFTW_MEASURE);
+  bwdZ = (void*) planC2R(data, m_NNt[2], nx * ny, FFTW_MEASURE);
+  fwdY = (void*) planC2C(bufY, m_NNt[1], nzh * nx, FFTW_FORWARD, FFTW_MEASURE);
+  bwdY = (void*) planC2C(bufY, m_NNt[1], nzh * nx, FFTW_BACKWARD, FFTW_MEASURE);
+  fwdX = (void*) planC2C(bufX, m_NNt[0], nyy * nzh, FFTW_FORWARD, FFTW_MEASURE);
+  bwdX = (void*) planC2C(bufX, m_NNt[0], nyy * nzh, FFTW_BACKWARD, FFTW_MEASURE);
+  exportFFTWWisdom(sim, m_comm, "unboundedPencil");
+
+  _initialize_green();
+}
+
+void PoissonSolverUnboundedPencil::_initialize_green()
+{
+  // The Green's function fills the padded domain: its z-pencils are split
+  // among the ranks independently of the blocks, the modes end up in the same
+  // x-pencils as the ones of the solution.
+  const std::vector<int> gxCounts = PencilTranspose::split(m_NNt[0], dims[0]);
+  const std::vector<int> gyCounts = PencilTranspose::split(m_NNt[1], dims[1]);
+  const int gnx = gxCounts[coords[0]], gny = gyCounts[coords[1]];
+  const int nzh = zhCounts[coords[1]], nyy = yyCounts[coords[0]];
+  int gxStart = 0, gyStart = 0;
+  for (int i = 0; i < coords[0]; ++i) gxStart += gxCounts[i];
+  for (int i = 0; i < coords[1]; ++i) gyStart += gyCounts[i];
+  PencilTranspose gZY(rowComm, gnx, gyCounts, m_NNt[1], zhCounts, 2);
+  PencilTranspose gYX(colComm, nzh, gxCounts, m_NNt[0], yyCounts, 2);
+  Real * const gZ = _FFTW_(alloc_real)(gZY.sizeABC());
+  Real * const gY = _FFTW_(alloc_real)(gZY.sizeCAB());
+  Real * const gX = _FFTW_(alloc_real)(gYX.sizeCAB());
+  fft_plan greenZ = planR2C(gZ, m_NNt[2], gnx * gny, FFTW_ESTIMATE);
+  fft_plan greenY = planC2C(gY, m_NNt[1], nzh * gnx, FFTW_FORWARD, FFTW_ESTIMATE);
+  fft_plan greenX = planC2C(gX, m_NNt[0], nyy * nzh, FFTW_FORWARD, FFTW_ESTIMATE);
+
+  // This factor is due to the discretization of the convolution
+  // integtal.  It is composed of (h*h*h) * (-1/[4*pi*h]), where h is the
+  // uniform grid spacing.  The first factor is the discrete volume
+  // element of the convolution integral; the second factor belongs to
+  // Green's function on a uniform mesh.
+  #pragma omp parallel for collapse(2) schedule(static)
+  for (int i = 0; i < gnx; ++i)
+  for (int j = 0; j < gny; ++j)
+  for (int k = 0; k < m_NNt[2]; ++k)
+  {
+      const int I = gxStart + i, J = gyStart + j;
+      const Real xi = I>=m_N[0]? 2*m_N[0]-1 - I : I;
+      const Real yi = J>=m_N[1]? 2*m_N[1]-1 - J : J;
+      const Real zi = k>=m_N[2]? 2*m_N[2]-1 - k : k;
+      const double r = std::sqrt(xi*xi + yi*yi + zi*zi);
+      const size_t idx = k + 2*m_Nzhat*(j + (size_t)gny*i);
+      if (r > 0) gZ[idx] = - h * h / (4*M_PI*r);
+      else gZ[idx] = - Real(0.1924173658) * h * h;
+  }
+
+  _FFTW_(execute)(greenZ);
+  gZY.forward(gZ, gY);
+  _FFTW_(execute)(greenY);
+  gYX.forward(gY, gX);
+  _FFTW_(execute)(greenX);
+
+  const size_t kern_size = YX->sizeCAB() / 2;
+  m_kernel = _FFTW_(alloc_real)(kern_size); // FFT for this kernel is real
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < kern_size; ++i)
+    m_kernel[i] = gX[2*i] * m_norm_factor; // need real part only
+
+  _FFTW_(destroy_plan)(greenZ);
+  _FFTW_(destroy_plan)(greenY);
+  _FFTW_(destroy_plan)(greenX);
+  _FFTW_(free)(gZ);
+  _FFTW_(free)(gY);
+  _FFTW_(free)(gX);
+}
+
+void PoissonSolverUnboundedPencil::solve()
+{
+  sim.startProfiler("UPFFTW cub2rhs");
+  _cub2fftw();
+  {
+    // zero padding along z, overwritten by the previous inverse transform
+    const size_t lines = myN[0] * myN[1], lineSize = 2*m_Nzhat;
+    #pragma omp parallel for schedule(static)
+    for (size_t l = 0; l < lines; ++l)
+      std::fill(data + l*lineSize + m_N[2], data + (l+1)*lineSize, (Real)0);
+  }
+  sim.stopProfiler();
+
+  sim.startProfiler("UPFFTW r2c");
+  _FFTW_(execute)((fft_plan) fwdZ);
+  ZY->forward(data, bufY);
+  _FFTW_(execute)((fft_plan) fwdY);
+  YX->forward(bufY, bufX);
+  _FFTW_(execute)((fft_plan) fwdX);
+  sim.stopProfiler();
+
+  sim.startProfiler("UPFFTW solve");
+  {
+    fft_c* const rho_hat = (fft_c*)bufX;
+    const Real* const G_hat = m_kernel;
+    const size_t kern_size = YX->sizeCAB() / 2;
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < kern_size; ++i) {
+      rho_hat[i][0] *= G_hat[i]; //normalization is carried on in G_hat
+      rho_hat[i][1] *= G_hat[i]; //normalization is carried on in G_hat
+    }
+  }
+  sim.stopProfiler();
+
+  sim.startProfiler("UPFFTW c2r");
+  _FFTW_(execute)((fft_plan) bwdX);
+  YX->backward(bufX, bufY);
+  _FFTW_(execute)((fft_plan) bwdY);
+  ZY->backward(bufY, data);
+  _FFTW_(execute)((fft_plan) bwdZ);
+  sim.stopProfiler();
+}
+
+PoissonSolverUnboundedPencil::~PoissonSolverUnboundedPencil()
+{
+  _FFTW_(destroy_plan)((fft_plan) fwdZ);
+  _FFTW_(destroy_plan)((fft_plan) bwdZ);
+  _FFTW_(destroy_plan)((fft_plan) fwdY);
+  _FFTW_(destroy_plan)((fft_plan) bwdY);
+  _FFTW_(destroy_plan)((fft_plan) fwdX);
+  _FFTW_(destroy_plan)((fft_plan) bwdX);
+  _FFTW_(free)(data);
+  _FFTW_(free)(bufY);
+  _FFTW_(free)(bufX);
+  _FFTW_(free)(m_kernel);
+  MPI_Comm_free(&rowComm);
+  MPI_Comm_free(&colComm);
+  _FFTW_(mpi_cleanup)();
+}
+
+CubismUP_3D_NAMESPACE_END
+#undef MPIREAL
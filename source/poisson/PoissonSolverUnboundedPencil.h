@@ -0,0 +1,52 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+//  Cyclic convolution method of Eastwood and Brownrigg (1979) for unbounded
+//  domains, as PoissonSolverUnbounded, with a pencil decomposition: ranks may
+//  be split along x and y (not z). The domain is zero-padded to 2N-1 cells
+//  per direction; r2c transforms along z and c2c along y and x, with global
+//  transposes between them:
+//    Z-pencils [x][y][z] -> Y-pencils [z][x][y] -> X-pencils [y][z][x].
+
+#ifndef CubismUP_3D_PoissonSolverUnboundedPencil_h
+#define CubismUP_3D_PoissonSolverUnboundedPencil_h
+
+#include "PoissonSolver.h"
+#include "PencilTranspose.h"
+
+#include <memory>
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+class PoissonSolverUnboundedPencil : public PoissonSolver
+{
+  // original and padded (actual transform) sizes
+  const int m_N[3] = {(int)gsize[0], (int)gsize[1], (int)gsize[2]};
+  const int m_NNt[3] = {2*m_N[0]-1, 2*m_N[1]-1, 2*m_N[2]-1};
+  const int m_Nzhat = m_NNt[2]/2 + 1; // for symmetry in r2c transform
+  const double h = sim.uniformH();
+  // FFT normalization factor
+  const Real m_norm_factor = 1.0 / (m_NNt[0]*h * m_NNt[1]*h * m_NNt[2]*h);
+
+  MPI_Comm rowComm, colComm; // ranks with the same x, resp. y, coordinate
+  int dims[3], coords[3];
+  std::vector<int> zhCounts, yyCounts; // split of the modes along z and y
+  std::unique_ptr<PencilTranspose> ZY, YX;
+  Real * bufY, * bufX; // complex y- and x-pencils
+  Real * m_kernel;     // FFT of Green's function in x-pencils (real part)
+  void * fwdZ, * fwdY, * fwdX, * bwdZ, * bwdY, * bwdX;
+
+  void _initialize_green();
+
+ public:
+  PoissonSolverUnboundedPencil(SimulationData & s);
+
+  void solve() override;
+
+  ~PoissonSolverUnboundedPencil();
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_PoissonSolverUnboundedPencil_h
@@ -22,4 +22,17 @@ typedef fftwf_complex fft_c;
 typedef fftwf_plan fft_plan;
 #endif /* CUP_SINGLE_PRECISION */
 
+// Transforms of PoissonSolverMixed and PoissonSolverPeriodic, see TransformReal.
+#ifdef CUP_POISSON_MIXED_PRECISION
+#define MPITREAL MPI_FLOAT
+#define _FFTWT_(s) fftwf_##s
+typedef fftwf_complex fftt_c;
+typedef fftwf_plan fftt_plan;
+#else
+#define MPITREAL MPIREAL
+#define _FFTWT_(s) _FFTW_(s)
+typedef fft_c fftt_c;
+typedef fft_plan fftt_plan;
+#endif /* CUP_POISSON_MIXED_PRECISION */
+
 #endif // CubismUP_3D_PoissonSolver_common_h
@@ -0,0 +1,100 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "WideLaplacian.h"
+#include "PoissonSolver_common.h"
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+namespace {
+
+// Index of the global cell i in [-2, N + 2) inside [0, N).
+inline long wrap(long i, const long N, const bool periodic)
+{
+  if (periodic) return (i + N) % N;
+  if (i < 0) return -1 - i;
+  if (i >= N) return 2 * N - 1 - i;
+  return i;
+}
+
+}
+
+WideLaplacian::WideLaplacian(const MPI_Comm comm, const size_t gsize[3],
+                             const size_t start, const size_t n,
+                             const size_t rowSize, const bool periodic[3])
+    : comm_(comm), start_(start), n_(n), rowSize_(rowSize),
+      planeSize_(gsize[1] * rowSize)
+{
+  for (int d = 0; d < 3; ++d) {
+    N_[d] = gsize[d];
+    periodic_[d] = periodic[d];
+  }
+  if (n_ < 2) {
+    fprintf(stderr, "WideLaplacian: ERROR: slabs of at least 2 planes are required.\n");
+    fflush(0); exit(1);
+  }
+  int rank, size;
+  MPI_Comm_rank(comm_, &rank);
+  MPI_Comm_size(comm_, &size);
+  left_  = rank > 0 ? rank - 1 : (periodic_[0] ? size - 1 : MPI_PROC_NULL);
+  right_ = rank < size - 1 ? rank + 1 : (periodic_[0] ? 0 : MPI_PROC_NULL);
+  halo_[0].resize(2 * planeSize_);
+  halo_[1].resize(2 * planeSize_);
+}
+
+const TransformReal *WideLaplacian::plane(const TransformReal *x, const long gi) const
+{
+  const long N = N_[0];
+  const long i = wrap(gi, N, periodic_[0]);
+  const long rel = (i - (long)start_ + N) % N;  // Position after the slab start.
+  if (rel < (long)n_) return x + rel * planeSize_;
+  if (rel >= N - 2) return halo_[0].data() + (rel - (N - 2)) * planeSize_;
+  return halo_[1].data() + (rel - (long)n_) * planeSize_;
+}
+
+void WideLaplacian::subtract(const double coef, const TransformReal *x, Real *b)
+{
+  // The first two planes go left and become its right halo, the last two go
+  // right and become its left halo.
+  const int count = (int)(2 * planeSize_);
+  MPI_Sendrecv(x, count, MPITREAL, left_, 0,
+               halo_[1].data(), count, MPITREAL, right_, 0, comm_, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(x + (n_ - 2) * planeSize_, count, MPITREAL, right_, 1,
+               halo_[0].data(), count, MPITREAL, left_, 1, comm_, MPI_STATUS_IGNORE);
+
+  const long N1 = N_[1], N2 = N_[2];
+  std::vector<long> ym(N1), yp(N1), zm(N2), zp(N2);
+  for (long j = 0; j < N1; ++j) {
+    ym[j] = wrap(j - 2, N1, periodic_[1]) * rowSize_;
+    yp[j] = wrap(j + 2, N1, periodic_[1]) * rowSize_;
+  }
+  for (long k = 0; k < N2; ++k) {
+    zm[k] = wrap(k - 2, N2, periodic_[2]);
+    zp[k] = wrap(k + 2, N2, periodic_[2]);
+  }
+
+  #pragma omp parallel for schedule(static)
+  for (long i = 0; i < (long)n_; ++i) {
+    const TransformReal *const xc = x + i * planeSize_;
+    const TransformReal *const xm = plane(x, (long)start_ + i - 2);
+    const TransformReal *const xp = plane(x, (long)start_ + i + 2);
+    Real *const bc = b + i * planeSize_;
+    for (long j = 0; j < N1; ++j) {
+      const size_t row = j * rowSize_;
+      for (long k = 0; k < N2; ++k) {
+        const double lap = (double)xm[row + k] + xp[row + k]
+                         + xc[ym[j] + k] + xc[yp[j] + k]
+                         + xc[row + zm[k]] + xc[row + zp[k]]
+                         - 6 * (double)xc[row + k];
+        bc[row + k] -= coef * lap;
+      }
+    }
+  }
+}
+
+CubismUP_3D_NAMESPACE_END
+#undef MPIREAL
+#undef MPITREAL
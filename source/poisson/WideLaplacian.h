@@ -0,0 +1,45 @@
+//
+//  CubismUP_3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_WideLaplacian_h
+#define CubismUP_3D_WideLaplacian_h
+
+#include "PoissonSolver.h"
+
+CubismUP_3D_NAMESPACE_BEGIN
+
+/*
+ * Wide (2h) 7-point Laplacian on the x-slabs of the FFTW solvers, the grid
+ * consistent operator they invert, used for the double precision residual of
+ * their mixed precision mode.
+ *
+ * Each rank holds the planes [start, start + n) of the global grid, stored
+ * x-slowest with rows along z padded to `rowSize` entries. Directions are
+ * periodic or even-symmetric about the domain faces, as in the cosine
+ * transforms. Ranks are ordered along x as in FFTW's slab decomposition.
+ */
+class WideLaplacian
+{
+public:
+  WideLaplacian(MPI_Comm comm, const size_t gsize[3], size_t start, size_t n,
+                size_t rowSize, const bool periodic[3]);
+
+  /* b -= coef * sum_d (x_{i+2e_d} - 2 x_i + x_{i-2e_d}). */
+  void subtract(double coef, const TransformReal *x, Real *b);
+
+private:
+  const TransformReal *plane(const TransformReal *x, long gi) const;
+
+  MPI_Comm comm_;
+  size_t N_[3], start_, n_, rowSize_, planeSize_;
+  bool periodic_[3];
+  int left_, right_;
+  // Planes start-2, start-1 and start+n, start+n+1 of x.
+  std::vector<TransformReal> halo_[2];
+};
+
+CubismUP_3D_NAMESPACE_END
+#endif // CubismUP_3D_WideLaplacian_h
@@ -8,6 +8,7 @@
 
 #include "SpectralManipFFTW.h"
 #include "../poisson/PoissonSolver_common.h"
+#include "../poisson/FFTWWisdom.h"
 
 #ifndef CUP_SINGLE_PRECISION
 #define MPIREAL MPI_DOUBLE
@@ -317,6 +318,7 @@ void SpectralManipFFTW::prepareFwd()
 {
   if (bAllocFwd) return;
 
+  importFFTWWisdom(sim, m_comm, "spectral");
   fwd_u = (void*) _FFTW_(mpi_plan_dft_r2c_3d)(gsize[0], gsize[1], gsize[2],
     data_u, (fft_c*)data_u, m_comm, FFTW_MPI_TRANSPOSED_OUT  | FFTW_MEASURE);
   fwd_v = (void*) _FFTW_(mpi_plan_dft_r2c_3d)(gsize[0], gsize[1], gsize[2],
@@ -326,6 +328,7 @@ void SpectralManipFFTW::prepareFwd()
 
   //fwd_cs2 = (void*) _FFTW_(mpi_plan_dft_r2c_3d)(gsize[0], gsize[1], gsize[2],
   //data_cs2, (fft_c*)data_cs2, m_comm, FFTW_MPI_TRANSPOSED_OUT | FFTW_MEASURE);
+  exportFFTWWisdom(sim, m_comm, "spectral");
   bAllocFwd = true;
 }
 
@@ -333,13 +336,14 @@ void SpectralManipFFTW::prepareBwd()
 {
   if (bAllocBwd) return;
 
+  importFFTWWisdom(sim, m_comm, "spectral");
   bwd_u = (void*) _FFTW_(mpi_plan_dft_c2r_3d)(gsize[0], gsize[1], gsize[2],
     (fft_c*)data_u, data_u, m_comm, FFTW_MPI_TRANSPOSED_IN  | FFTW_MEASURE);
   bwd_v = (void*) _FFTW_(mpi_plan_dft_c2r_3d)(gsize[0], gsize[1], gsize[2],
     (fft_c*)data_v, data_v, m_comm, FFTW_MPI_TRANSPOSED_IN  | FFTW_MEASURE);
   bwd_w = (void*) _FFTW_(mpi_plan_dft_c2r_3d)(gsize[0], gsize[1], gsize[2],
     (fft_c*)data_w, data_w, m_comm, FFTW_MPI_TRANSPOSED_IN  | FFTW_MEASURE);
-
+  exportFFTWWisdom(sim, m_comm, "spectral");
   bAllocBwd = true;
 }
 
@@ -0,0 +1,120 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_utils_AndersonMixer_h
+#define CubismUP_3D_utils_AndersonMixer_h
+
+#include <cmath>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace cubismup3d {
+
+/*
+ * Anderson acceleration of a fixed-point iteration x = G(x) on a small vector.
+ *
+ * `mix(x, g)` takes the input x_k of the current iteration and g_k = G(x_k),
+ * and returns the next input: g_k corrected with the secant information of the
+ * last `depth` iterations, i.e. x_{k+1} = g_k - sum_j gamma_j (g_{j+1} - g_j)
+ * where gamma minimizes the norm of the residual f = g - x extrapolated the
+ * same way. Depth 0 is the plain fixed-point update, depth 1 the vector
+ * version of Aitken's delta-squared. Components with a constant residual
+ * (e.g. imposed values with g = x) are left untouched.
+ *
+ * Deterministic, so ranks which pass the same values get the same result.
+ * `reset` must be called when the fixed-point map changes.
+ */
+class AndersonMixer
+{
+ public:
+  explicit AndersonMixer(const int depth = 0) : depth_(depth) {}
+
+  void reset() { gs_.clear(); fs_.clear(); }
+  int depth() const { return depth_; }
+
+  std::vector<double> mix(const std::vector<double> &x,
+                          const std::vector<double> &g)
+  {
+    const size_t n = x.size();
+    if (depth_ <= 0) return g;
+    if (not gs_.empty() && gs_.back().size() != n) reset();
+
+    std::vector<double> f(n);
+    for (size_t i = 0; i < n; ++i) f[i] = g[i] - x[i];
+    gs_.push_back(g);
+    fs_.push_back(f);
+    if ((int)gs_.size() > depth_ + 1) {
+      gs_.pop_front();
+      fs_.pop_front();
+    }
+    const int m = (int)gs_.size() - 1;
+    if (m == 0) return g;
+
+    // Normal equations of min |f - dF gamma|, dF_j = f_{j+1} - f_j.
+    std::vector<std::vector<double>> dF(m, std::vector<double>(n));
+    for (int j = 0; j < m; ++j)
+      for (size_t i = 0; i < n; ++i) dF[j][i] = fs_[j + 1][i] - fs_[j][i];
+    std::vector<double> A(m * m), b(m), gamma(m, 0);
+    double trace = 0;
+    for (int j = 0; j < m; ++j) {
+      for (int k = 0; k < m; ++k) A[j*m + k] = dot(dF[j], dF[k]);
+      b[j] = dot(dF[j], f);
+      trace += A[j*m + j];
+    }
+    if (trace <= 0) return g;  // no change of the residual, nothing to learn
+    for (int j = 0; j < m; ++j) A[j*m + j] += 1e-12 * trace;
+    if (not solve(m, A, b, gamma)) return g;
+
+    std::vector<double> out = g;
+    for (int j = 0; j < m; ++j)
+      for (size_t i = 0; i < n; ++i)
+        out[i] -= gamma[j] * (gs_[j + 1][i] - gs_[j][i]);
+    return out;
+  }
+
+ private:
+  int depth_;
+  std::deque<std::vector<double>> gs_, fs_;
+
+  static double dot(const std::vector<double> &u, const std::vector<double> &v)
+  {
+    double sum = 0;
+    for (size_t i = 0; i < u.size(); ++i) sum += u[i] * v[i];
+    return sum;
+  }
+
+  // Gaussian elimination with partial pivoting of the m x m system A x = b.
+  static bool solve(const int m, std::vector<double> &A, std::vector<double> &b,
+                    std::vector<double> &x)
+  {
+    for (int c = 0; c < m; ++c) {
+      int p = c;
+      for (int r = c + 1; r < m; ++r)
+        if (std::fabs(A[r*m + c]) > std::fabs(A[p*m + c])) p = r;
+      if (A[p*m + c] == 0) return false;
+      if (p != c) {
+        for (int k = 0; k < m; ++k) std::swap(A[c*m + k], A[p*m + k]);
+        std::swap(b[c], b[p]);
+      }
+      for (int r = c + 1; r < m; ++r) {
+        const double l = A[r*m + c] / A[c*m + c];
+        for (int k = c; k < m; ++k) A[r*m + k] -= l * A[c*m + k];
+        b[r] -= l * b[c];
+      }
+    }
+    for (int r = m - 1; r >= 0; --r) {
+      double sum = b[r];
+      for (int k = r + 1; k < m; ++k) sum -= A[r*m + k] * x[k];
+      x[r] = sum / A[r*m + r];
+    }
+    return std::isfinite(x[0]);
+  }
+};
+
+}  // namespace cubismup3d
+
+#endif  // CubismUP_3D_utils_AndersonMixer_h
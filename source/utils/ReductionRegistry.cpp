@@ -0,0 +1,72 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "ReductionRegistry.h"
+
+#include <cassert>
+
+namespace cubismup3d {
+
+void ReductionRegistry::enqueue(const double *values, const int count,
+                                const MPI_Op op, callback_type onComplete)
+{
+  queued_.push_back(Entry{std::vector<double>(values, values + count), op,
+                          std::move(onComplete)});
+}
+
+void ReductionRegistry::flush()
+{
+  if (queued_.empty()) return;
+  assert(comm_ != MPI_COMM_NULL);
+
+  // One batch per operation, entries keep their relative order. Ranks
+  // enqueue the same sequence, so batches are posted in the same order.
+  std::vector<Batch*> batches;
+  for (Entry &entry : queued_) {
+    Batch *batch = nullptr;
+    for (Batch *b : batches) if (b->op == entry.op) batch = b;
+    if (batch == nullptr) {
+      posted_.emplace_back();
+      batch = &posted_.back();
+      batch->op = entry.op;
+      batches.push_back(batch);
+    }
+    batch->packed.insert(batch->packed.end(), entry.values.begin(),
+                         entry.values.end());
+    batch->entries.push_back(std::move(entry));
+  }
+  queued_.clear();
+
+  for (Batch *batch : batches)
+    MPI_Iallreduce(MPI_IN_PLACE, batch->packed.data(), (int)batch->packed.size(),
+                   MPI_DOUBLE, batch->op, comm_, &batch->request);
+}
+
+void ReductionRegistry::wait()
+{
+  flush();
+  while (!posted_.empty()) {
+    Batch &batch = posted_.front();
+    MPI_Wait(&batch.request, MPI_STATUS_IGNORE);
+    size_t offset = 0;
+    for (Entry &entry : batch.entries) {
+      if (entry.onComplete) entry.onComplete(batch.packed.data() + offset);
+      offset += entry.values.size();
+    }
+    posted_.pop_front();
+  }
+}
+
+void ReductionRegistry::reduce(double * const buffer, const int count,
+                               const MPI_Op op)
+{
+  enqueue(buffer, count, op, [buffer, count](const double *result) {
+    for (int i = 0; i < count; ++i) buffer[i] = result[i];
+  });
+  wait();
+}
+
+}  // namespace cubismup3d
@@ -0,0 +1,74 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_utils_ReductionRegistry_h
+#define CubismUP_3D_utils_ReductionRegistry_h
+
+#include <mpi.h>
+
+#include <functional>
+#include <list>
+#include <vector>
+
+namespace cubismup3d {
+
+/*
+ * Batched non-blocking reductions of small arrays of doubles.
+ *
+ * Operators enqueue their partial values together with the reduction
+ * operation and an optional callback. `flush` packs everything enqueued so
+ * far into one MPI_Iallreduce per operation. `wait` completes all posted
+ * reductions and passes the reduced values to the callbacks, in the order in
+ * which they were enqueued. Values are copied on enqueue, so the caller's
+ * buffer does not have to outlive the call.
+ *
+ * All ranks must enqueue the same sequence of (count, op) pairs.
+ */
+class ReductionRegistry
+{
+public:
+  using callback_type = std::function<void(const double *result)>;
+
+  explicit ReductionRegistry(MPI_Comm comm = MPI_COMM_NULL) : comm_(comm) { }
+
+  void setComm(MPI_Comm comm) { comm_ = comm; }
+
+  /* Enqueue `count` values for reduction with `op` (MPI_SUM, MPI_MAX, ...). */
+  void enqueue(const double *values, int count, MPI_Op op,
+               callback_type onComplete = nullptr);
+
+  /* Post the reductions of all enqueued values. */
+  void flush();
+
+  /* Flush, then complete all posted reductions and run their callbacks. */
+  void wait();
+
+  /* Reduce `buffer` in place now, together with everything pending. */
+  void reduce(double *buffer, int count, MPI_Op op);
+
+  bool empty() const { return queued_.empty() && posted_.empty(); }
+
+private:
+  struct Entry {
+    std::vector<double> values;
+    MPI_Op op;
+    callback_type onComplete;
+  };
+  struct Batch {
+    MPI_Op op;
+    std::vector<double> packed;
+    std::vector<Entry> entries;
+    MPI_Request request = MPI_REQUEST_NULL;
+  };
+
+  MPI_Comm comm_;
+  std::vector<Entry> queued_;
+  std::list<Batch> posted_;  // List, `packed` must not move while in flight.
+};
+
+}  // namespace cubismup3d
+
+#endif // CubismUP_3D_utils_ReductionRegistry_h
@@ -0,0 +1,127 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#include "TraceRecorder.h"
+
+#include <omp.h>
+
+#include <cstdio>
+#include <sstream>
+
+namespace cubismup3d {
+
+static std::string escapeJSON(const std::string &s)
+{
+  std::string out;
+  for (const char c : s) {
+    if (c == '"' || c == '\\') out += '\\';
+    if ((unsigned char)c >= 0x20) out += c;
+  }
+  return out;
+}
+
+TraceRecorder::TraceRecorder(MPI_Comm comm, const size_t capacity)
+    : comm_(comm), capacity_(capacity > 0 ? capacity : 1),
+      lanes_(omp_get_max_threads())
+{
+  for (Lane &lane : lanes_) lane.ring.resize(capacity_);
+  MPI_Barrier(comm_);
+  t0_ = MPI_Wtime();
+}
+
+int TraceRecorder::intern(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(namesMutex_);
+  const auto it = ids_.find(name);
+  if (it != ids_.end()) return it->second;
+  names_.push_back(name);
+  return ids_[name] = (int)names_.size() - 1;
+}
+
+void TraceRecorder::begin(const int nameId)
+{
+  const int tid = omp_get_thread_num();
+  if (tid >= (int)lanes_.size()) return;
+  lanes_[tid].open.push_back(Open{nameId, MPI_Wtime() - t0_});
+}
+
+void TraceRecorder::end()
+{
+  const int tid = omp_get_thread_num();
+  if (tid >= (int)lanes_.size()) return;
+  Lane &lane = lanes_[tid];
+  if (lane.open.empty()) return;
+  const Open o = lane.open.back();
+  lane.open.pop_back();
+  lane.ring[lane.count++ % capacity_] =
+      Event{o.name, o.start, MPI_Wtime() - t0_ - o.start};
+}
+
+std::string TraceRecorder::serializeLocal(const int rank) const
+{
+  std::ostringstream ss;
+  ss.precision(15);
+  ss << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank
+     << ",\"args\":{\"name\":\"rank " << rank << "\"}}";
+  for (int tid = 0; tid < (int)lanes_.size(); ++tid) {
+    const Lane &lane = lanes_[tid];
+    const size_t n = lane.count < capacity_ ? lane.count : capacity_;
+    for (size_t i = lane.count - n; i < lane.count; ++i) {
+      const Event &e = lane.ring[i % capacity_];
+      ss << ",\n{\"name\":\"" << escapeJSON(names_[e.name])
+         << "\",\"ph\":\"X\",\"pid\":" << rank << ",\"tid\":" << tid
+         << ",\"ts\":" << 1e6 * e.start << ",\"dur\":" << 1e6 * e.duration
+         << '}';
+    }
+  }
+  return ss.str();
+}
+
+void TraceRecorder::write(const std::string &filename)
+{
+  int rank, size;
+  MPI_Comm_rank(comm_, &rank);
+  MPI_Comm_size(comm_, &size);
+
+  unsigned long long dropped = 0;
+  for (const Lane &lane : lanes_)
+    if (lane.count > capacity_) dropped += lane.count - capacity_;
+  MPI_Allreduce(MPI_IN_PLACE, &dropped, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+                comm_);
+
+  // Each rank writes its own part of the JSON at an offset given by the sizes
+  // of the parts before it, so nothing is gathered on one rank.
+  std::string local = serializeLocal(rank);
+  if (rank == 0)
+    local = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" + local;
+  else
+    local = ",\n" + local;
+  if (rank == size - 1) local += "\n]}\n";
+  const MPI_Offset length = (MPI_Offset)local.size();
+  MPI_Offset offset = 0;
+  MPI_Exscan(&length, &offset, 1, MPI_OFFSET, MPI_SUM, comm_);
+  if (rank == 0) offset = 0;  // Undefined on rank 0.
+
+  MPI_File fh;
+  if (MPI_File_open(comm_, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                    MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+    if (rank == 0)
+      fprintf(stderr, "Cannot open trace file %s.\n", filename.c_str());
+    return;
+  }
+  MPI_File_set_size(fh, 0);  // An older, longer trace would leave a tail.
+  MPI_File_write_at_all(fh, offset, local.data(), (int)local.size(), MPI_CHAR,
+                        MPI_STATUS_IGNORE);
+  MPI_File_close(&fh);
+  if (rank != 0) return;
+
+  printf("Trace written to %s", filename.c_str());
+  if (dropped > 0)
+    printf(" (%llu oldest sections dropped, increase -traceCapacity)", dropped);
+  printf(".\n");
+}
+
+}  // namespace cubismup3d
@@ -0,0 +1,75 @@
+//
+//  Cubism3D
+//  Copyright (c) 2018 CSE-Lab, ETH Zurich, Switzerland.
+//  Distributed under the terms of the MIT license.
+//
+
+#ifndef CubismUP_3D_utils_TraceRecorder_h
+#define CubismUP_3D_utils_TraceRecorder_h
+
+#include <mpi.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace cubismup3d {
+
+/*
+ * Timeline of named sections, per rank and per OpenMP thread.
+ *
+ * Each thread records its completed sections into its own ring buffer of
+ * fixed capacity, the oldest sections are overwritten when it is full.
+ * `write` writes the sections of all ranks as one Chrome trace JSON
+ * (chrome://tracing, ui.perfetto.dev) with MPI-IO, one process per rank.
+ * Timestamps are taken relative to a barrier in the constructor.
+ */
+class TraceRecorder
+{
+public:
+  TraceRecorder(MPI_Comm comm, size_t capacity);
+  TraceRecorder(const TraceRecorder &) = delete;
+  TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+  /* Id of a section name, to be used by `begin`. Thread-safe. */
+  int intern(const std::string &name);
+
+  /* Open and close a section on the calling thread. Sections nest. */
+  void begin(int nameId);
+  void begin(const std::string &name) { begin(intern(name)); }
+  void end();
+
+  /* Collective. Write the trace of all ranks to `filename`. */
+  void write(const std::string &filename);
+
+private:
+  struct Event {
+    int name;
+    double start;
+    double duration;
+  };
+  struct Open {
+    int name;
+    double start;
+  };
+  struct alignas(64) Lane {  // Cache line aligned, written by one thread.
+    std::vector<Event> ring;
+    size_t count = 0;
+    std::vector<Open> open;
+  };
+
+  std::string serializeLocal(int rank) const;
+
+  MPI_Comm comm_;
+  double t0_;
+  size_t capacity_;
+  std::vector<Lane> lanes_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, int> ids_;
+  std::mutex namesMutex_;
+};
+
+}  // namespace cubismup3d
+
+#endif // CubismUP_3D_utils_TraceRecorder_h
@@ -0,0 +1,109 @@
+#ifndef CUBISMUP3D_TESTS_POISSON_TEST_UTILS_H
+#define CUBISMUP3D_TESTS_POISSON_TEST_UTILS_H
+
+#include "Utils.h"
+#include "../../source/poisson/Multigrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace cubismup3d {
+namespace tests {
+
+/*
+ * Box of 16^3 cells per rank on a Cartesian communicator of all ranks, with
+ * the Multigrid coefficients of the spacing 1 + amplitude cos(waves pi s)
+ * along `stretchDir` (s in [0, 1]) and of uniform spacing along the others.
+ * Coordinates are scaled to the unit cube.
+ */
+struct PoissonBox
+{
+  MPI_Comm comm;
+  int size, dims[3] = {0, 0, 0}, coords[3];
+  const int n[3] = {16, 16, 16};
+  bool periodic[3];
+  Multigrid::Coefficients coeffs[3];
+  std::vector<double> xc[3];  // Cell centres.
+  size_t N = (size_t)n[0] * n[1] * n[2];
+
+  PoissonBox(const bool bPeriodic, const int stretchDir = -1,
+             const double amplitude = 0, const double waves = 0)
+  {
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Dims_create(size, 3, dims);
+    int periods[3] = {bPeriodic, bPeriodic, bPeriodic};
+    MPI_Cart_create(MPI_COMM_WORLD, 3, dims, periods, true, &comm);
+    MPI_Cart_get(comm, 3, dims, periods, coords);
+
+    for (int d = 0; d < 3; ++d) {
+      periodic[d] = bPeriodic;
+      const int NN = n[d] * dims[d];
+      // Global spacing with one ghost on each side, mirrored or periodic.
+      std::vector<double> h(NN + 2);
+      for (int i = 0; i < NN; ++i)
+        h[i + 1] = d == stretchDir
+                 ? 1 + amplitude * std::cos(waves * M_PI * (i + 0.5) / NN)
+                 : 1.0;
+      h[0] = bPeriodic ? h[NN] : h[1];
+      h[NN + 1] = bPeriodic ? h[1] : h[NN];
+      double L = 0;
+      for (int i = 1; i <= NN; ++i) L += h[i];
+      for (int i = 0; i < n[d]; ++i) {
+        const int g = coords[d] * n[d] + i + 1;
+        double x = 0;
+        for (int j = 1; j < g; ++j) x += h[j];
+        xc[d].push_back((x + h[g] / 2) / L);
+        const double dm = (h[g - 1] + h[g]) / 2, dp = (h[g] + h[g + 1]) / 2;
+        coeffs[d].h.push_back(h[g] / L);
+        coeffs[d].cm.push_back(2 * L * L / (dm * (dm + dp)));
+        coeffs[d].cp.push_back(2 * L * L / (dp * (dm + dp)));
+      }
+    }
+  }
+  ~PoissonBox() { MPI_Comm_free(&comm); }
+
+  // f(x, y, z) at the cell centres, in the layout of Multigrid.
+  template <typename F>
+  std::vector<Real> sample(const F &f) const
+  {
+    std::vector<Real> out(N);
+    for (int iz = 0; iz < n[2]; ++iz)
+    for (int iy = 0; iy < n[1]; ++iy)
+    for (int ix = 0; ix < n[0]; ++ix)
+      out[ix + n[0] * (iy + n[1] * iz)] = f(xc[0][ix], xc[1][iy], xc[2][iz]);
+    return out;
+  }
+
+  /*
+   * Solve A x = A exact with `solve(b, x, tol)`, which returns the number of
+   * iterations, and compare x with `exact` up to a constant. Then solve
+   * again from the solution, which must not do any iteration.
+   */
+  template <typename Solve>
+  int checkSolve(Multigrid &mg, const std::vector<Real> &exact,
+                 const Solve &solve) const
+  {
+    std::vector<Real> b(N), x(N, 0);
+    mg.apply(exact.data(), b.data());
+    const int iter = solve(b.data(), x.data(), 1e-8);
+
+    double mean[2] = {0, 0};
+    for (size_t i = 0; i < N; ++i) mean[0] += exact[i] - x[i];
+    MPI_Allreduce(MPI_IN_PLACE, mean, 1, MPI_DOUBLE, MPI_SUM, comm);
+    mean[0] /= (double)N * size;
+    for (size_t i = 0; i < N; ++i)
+      mean[1] = std::max(mean[1], std::fabs(exact[i] - x[i] - mean[0]));
+    MPI_Allreduce(MPI_IN_PLACE, mean + 1, 1, MPI_DOUBLE, MPI_MAX, comm);
+    CUP_CHECK(mean[1] < 1e-5, "Error %e after %d iterations.\n", mean[1], iter);
+
+    const int again = solve(b.data(), x.data(), 1e-6);
+    CUP_CHECK(again == 0, "Warm start did %d iterations.\n", again);
+    return iter;
+  }
+};
+
+}  // tests
+}  // cubismup3d
+
+#endif
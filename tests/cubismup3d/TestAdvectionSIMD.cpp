@@ -0,0 +1,82 @@
+#include "Utils.h"
+#include "../../source/Simulation.h"
+#include "../../source/operators/AdvectionDiffusion.h"
+#include "../../source/operators/CellwiseOperator.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace cubism;
+using namespace cubismup3d;
+
+static constexpr int CELLS_X = 64;
+static constexpr int CELLS_Y = 32;
+static constexpr int CELLS_Z = 32;
+static constexpr Real TOLERANCE = 100 * std::numeric_limits<Real>::epsilon();
+
+static int cellIndex(const CellInfo &info)
+{
+  return info.get_abs_ix() + CELLS_X * (info.get_abs_iy() + CELLS_Y * info.get_abs_iz());
+}
+
+/* Set a smooth periodic velocity field. */
+static void initVelocity(Simulation &S)
+{
+  const double k = 2 * M_PI / S.sim.extent[0];
+  applyKernel(S.sim, [k](CellInfo info, FluidElement &e) {
+    const std::array<Real, 3> p = info.get_pos();
+    e.u = std::sin(k * p[0]) * std::cos(2 * k * p[1]) + 0.3;
+    e.v = std::cos(k * p[1]) * std::sin(k * p[2]) - 0.1;
+    e.w = std::sin(3 * k * p[2]) * std::cos(k * p[0]);
+  });
+}
+
+/* Compare the SIMD and the scalar uniform-grid advection-diffusion. */
+static bool testAdvectionSIMD()
+{
+  auto prepareSimulationData = []() {
+    SimulationData SD{MPI_COMM_WORLD};
+    SD.CFL = 0.1;
+    SD.nu = 0.01;
+    SD.BCx_flag = periodic;
+    SD.BCy_flag = periodic;
+    SD.BCz_flag = periodic;
+    SD.setCells(CELLS_X, CELLS_Y, CELLS_Z);
+    return SD;
+  };
+  Simulation S{prepareSimulationData()};
+  AdvectionDiffusion advection(S.sim);
+  const double dt = 0.1 * S.sim.hmin;
+  std::vector<std::array<Real, 3>> reference(CELLS_X * CELLS_Y * CELLS_Z);
+
+  initVelocity(S);
+  S.sim.bScalarAdvection = true;
+  advection(dt);
+  applyKernel(S.sim, [&reference](CellInfo info, FluidElement &e) {
+    reference[cellIndex(info)] = {e.u, e.v, e.w};
+  });
+
+  initVelocity(S);
+  S.sim.bScalarAdvection = false;
+  advection(dt);
+  applyKernel(S.sim, [&reference](CellInfo info, FluidElement &e) {
+    const std::array<Real, 3> &ref = reference[cellIndex(info)];
+    CUP_CHECK(std::fabs(e.u - ref[0]) < TOLERANCE
+           && std::fabs(e.v - ref[1]) < TOLERANCE
+           && std::fabs(e.w - ref[2]) < TOLERANCE,
+              "Cell (%d %d %d) is (%e %e %e) instead of (%e %e %e)\n",
+              info.get_abs_ix(), info.get_abs_iy(), info.get_abs_iz(),
+              e.u, e.v, e.w, ref[0], ref[1], ref[2]);
+  });
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testAdvectionSIMD);
+
+  tests::finalize_mpi();
+}
@@ -0,0 +1,66 @@
+#include "Utils.h"
+#include "../../source/utils/AndersonMixer.h"
+
+#include <cmath>
+
+using namespace cubismup3d;
+
+// Iterate x = G(x) = M x + c, with M a contraction, starting from 0. Returns
+// the number of iterations until |G(x) - x| < 1e-10, or -1.
+static int iterate(AndersonMixer &mixer, const std::vector<double> &diag,
+                   std::vector<double> &x)
+{
+  const size_t n = diag.size();
+  x.assign(n, 0);
+  mixer.reset();
+  for (int iter = 0; iter < 1000; ++iter) {
+    std::vector<double> g(n);
+    double res = 0;
+    for (size_t i = 0; i < n; ++i) {
+      // Weakly coupled, mostly diagonal linear map.
+      const double coupling = i > 0 ? 0.05 * x[i - 1] : 0;
+      g[i] = diag[i] * x[i] + coupling + 1.0;
+      res = std::max(res, std::fabs(g[i] - x[i]));
+    }
+    if (res < 1e-10) return iter;
+    x = mixer.mix(x, g);
+  }
+  return -1;
+}
+
+static bool testAndersonMixer()
+{
+  // 1D linear map: the secant step (depth 1) is exact after two iterations.
+  {
+    AndersonMixer aitken(1);
+    std::vector<double> x;
+    const int iter = iterate(aitken, {0.95}, x);
+    CUP_CHECK(iter >= 0 && iter <= 3, "Aitken did %d iterations.\n", iter);
+    CUP_CHECK(std::fabs(x[0] - 20) < 1e-8, "Wrong fixed point %f.\n", x[0]);
+  }
+
+  // 6 unknowns with slow modes, like the velocities of one obstacle. The last
+  // one is (almost) given by G, like an imposed velocity.
+  const std::vector<double> d = {0.95, 0.9, 0.8, 0.5, -0.7, 0.0};
+  std::vector<double> plain, accel;
+  AndersonMixer none(0), anderson(4);
+  const int itPlain = iterate(none, d, plain);
+  const int itAccel = iterate(anderson, d, accel);
+  CUP_CHECK(itPlain > 0 && itAccel > 0, "No convergence: %d %d.\n",
+            itPlain, itAccel);
+  CUP_CHECK(itAccel * 4 < itPlain, "Anderson did %d iterations, plain %d.\n",
+            itAccel, itPlain);
+  for (size_t i = 0; i < d.size(); ++i)
+    CUP_CHECK(std::fabs(plain[i] - accel[i]) < 1e-8,
+              "Different fixed points at %zu: %f vs %f.\n", i, plain[i], accel[i]);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testAndersonMixer);
+
+  tests::finalize_mpi();
+}
@@ -0,0 +1,82 @@
+#include "Utils.h"
+#include "../../source/obstacles/extra/BodySDFCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace cubismup3d;
+
+// Sphere whose centre is off the origin of the body frame, so that the cache
+// must follow the rotation. Positive inside.
+struct OffsetSphere
+{
+  Real centre[3], radius;
+  Real signedDistance(const Real x, const Real y, const Real z) const
+  {
+    const Real dx = x - centre[0], dy = y - centre[1], dz = z - centre[2];
+    return radius - std::sqrt(dx*dx + dy*dy + dz*dz);
+  }
+};
+
+// Tabulate at one pose, move the body and compare the cached distance with
+// the exact one on points close to the surface, elsewhere in the lattice and
+// outside of it.
+static bool testBodySDFCache()
+{
+  const Real h = 1.0 / 64, dx = h / 2, band = 5 * h + dx;
+  const Real r = 0.15, a = 0.05;  // Radius and offset along x of the body.
+
+  OffsetSphere sphere{{0.5 + a, 0.5, 0.5}, r};
+  const double pos0[3] = {0.5, 0.5, 0.5}, q0[4] = {1, 0, 0, 0};
+  BodySDFCache cache;
+  cache.build(sphere, pos0, q0, r + a, dx, band);
+  CUP_CHECK(cache.isBuilt(), "Cache not built.\n");
+
+  // Rotation by 90 degrees around z: x of the body is y of the world.
+  const double pos1[3] = {0.4, 0.6, 0.5};
+  const double q1[4] = {std::sqrt(0.5), 0, 0, std::sqrt(0.5)};
+  sphere.centre[0] = pos1[0];
+  sphere.centre[1] = pos1[1] + a;
+  sphere.centre[2] = pos1[2];
+  cache.setPose(pos1, q1);
+
+  int counts[3] = {0, 0, 0};  // Near the surface, in the lattice, outside.
+  const int n = 50;
+  for (int iz = 0; iz < n; ++iz)
+  for (int iy = 0; iy < n; ++iy)
+  for (int ix = 0; ix < n; ++ix) {
+    const Real p[3] = {(ix + 0.5) / n, (iy + 0.5) / n, (iz + 0.5) / n};
+    const Real exact = sphere.signedDistance(p[0], p[1], p[2]);
+    const Real cached = cache.signedDistance(sphere, p[0], p[1], p[2]);
+    Real dist = 0;  // Max-norm distance to the origin of the body.
+    for (int d = 0; d < 3; ++d) dist = std::max(dist, std::fabs(p[d] - pos1[d]));
+
+    if (std::fabs(exact) < band / 2) {
+      ++counts[0];
+      CUP_CHECK(cached == exact, "Not exact at %f from the surface: %e.\n",
+                exact, cached - exact);
+    } else if (dist < r + a + band) {
+      ++counts[1];
+      CUP_CHECK(std::fabs(cached - exact) < dx,
+                "Interpolated %f instead of %f.\n", cached, exact);
+    } else if (dist > r + a + band + 3 * dx) {
+      // Outside of the lattice the distance is a bound from below.
+      ++counts[2];
+      CUP_CHECK(cached < 0 && cached <= exact + 1e-12,
+                "Extrapolated %f, exact %f.\n", cached, exact);
+    }
+  }
+  CUP_CHECK(counts[0] > 0 && counts[1] > 0 && counts[2] > 0,
+            "Missing points: %d %d %d.\n", counts[0], counts[1], counts[2]);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testBodySDFCache);
+
+  tests::finalize_mpi();
+}
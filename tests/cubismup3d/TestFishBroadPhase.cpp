@@ -0,0 +1,100 @@
+#include "Utils.h"
+#include "../../source/Simulation.h"
+#include "../../source/obstacles/FishLibrary.h"
+
+#include <Cubism/ArgumentParser.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cubism;
+using namespace cubismup3d;
+
+/*
+ * Compare the lists of findSegmentsPerBlock with the search of all segments
+ * against all blocks of the rank, for midlines of random shape and pose, on
+ * a uniform grid or on one stretched along y.
+ */
+static bool testBroadPhase(const bool stretched)
+{
+  int size;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  std::vector<std::string> args = {"test", "-bpdx", "8", "-bpdy", "8",
+      "-bpdz", "8", "-nu", "0.001", "-nprocsx", std::to_string(size),
+      "-nprocsy", "1", "-nprocsz", "1"};
+  if (stretched)
+    for (const char *a : {"-extentx", "1", "-extenty", "1", "-extentz", "1",
+                          "-mesh_density_y", "SinusoidalDensity",
+                          "-eta_y", "0.8"})
+      args.push_back(a);
+  std::vector<char *> argv;
+  for (std::string &a : args) argv.push_back(&a[0]);
+  argv.push_back(nullptr);
+  ArgumentParser parser((int)args.size(), argv.data());
+  Simulation S(MPI_COMM_WORLD, parser);
+  SimulationData &sim = S.sim;
+  const std::vector<BlockInfo> &vInfo = sim.vInfo();
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<Real> U(0, 1);
+  for (int pose = 0; pose < 20; ++pose) {
+    // Midline of length L along x in the body frame, bent along y.
+    const int nSegments = 64;
+    const Real L = 0.2 + 0.4 * U(gen), amplitude = 0.1 * U(gen);
+    std::vector<VolumeSegment_OBB> vSegments(nSegments);
+    for (int s = 0; s < nSegments; ++s) {
+      const Real x0 = L * s / nSegments - L / 2, x1 = x0 + L / nSegments;
+      const Real y0 = amplitude * std::sin(2 * M_PI * x0 / L);
+      const Real y1 = amplitude * std::sin(2 * M_PI * x1 / L);
+      const Real width = 0.05 * U(gen) + 1e-3, height = 0.03 * U(gen) + 1e-3;
+      const Real bbox[3][2] = {{x0, x1},
+                               {std::min(y0, y1) - width,
+                                std::max(y0, y1) + width},
+                               {-height, height}};
+      vSegments[s].prepare(std::make_pair(s, s + 1), bbox, sim.maxH());
+    }
+    // Random rotation, centre anywhere in and slightly out of the domain.
+    double q[4] = {U(gen) - 0.5, U(gen) - 0.5, U(gen) - 0.5, U(gen) - 0.5};
+    const double norm =
+        std::sqrt(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
+    for (double &qi : q) qi /= norm;
+    double position[3];
+    for (int a = 0; a < 3; ++a)
+      position[a] = sim.extent[a] * (1.4 * U(gen) - 0.2);
+    for (VolumeSegment_OBB &segm : vSegments)
+      segm.changeToComputationalFrame(position, q);
+
+    const std::vector<std::vector<VolumeSegment_OBB*>> fast =
+        findSegmentsPerBlock(vInfo, vSegments);
+    CUP_CHECK(fast.size() == vInfo.size(), "%zu lists for %zu blocks.\n",
+              fast.size(), vInfo.size());
+    for (const BlockInfo &info : vInfo) {
+      const FluidBlock &b = *(FluidBlock*)info.ptrBlock;
+      std::vector<VolumeSegment_OBB*> all;
+      for (VolumeSegment_OBB &segm : vSegments)
+        if (segm.isIntersectingWithAABB(b.min_pos.data(), b.max_pos.data()))
+          all.push_back(&segm);
+      CUP_CHECK(fast[info.blockID] == all,
+                "Pose %d, block %d: %zu segments instead of %zu.\n",
+                pose, info.blockID, fast[info.blockID].size(), all.size());
+    }
+  }
+  return true;
+}
+
+static bool testUniform() { return testBroadPhase(false); }
+static bool testStretched() { return testBroadPhase(true); }
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testUniform);
+  CUP_RUN_TEST(testStretched);
+
+  tests::finalize_mpi();
+}
@@ -0,0 +1,156 @@
+#include "PoissonTestUtils.h"
+#include "../../source/Simulation.h"
+#include "../../source/poisson/Krylov.h"
+#include "../../source/poisson/Multigrid.h"
+#include "../../source/poisson/PoissonSolverKrylov.h"
+
+#include <Cubism/ArgumentParser.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+using namespace cubism;
+using namespace cubismup3d;
+
+// Solve A x = A x_exact with the operator of Multigrid on a box of 16^3 cells
+// per rank and zero-gradient boundaries, preconditioned with one V-cycle.
+static bool testKrylov(const Krylov::Method method, const bool stretched)
+{
+  const tests::PoissonBox box(false, stretched ? 1 : -1, 0.8, 1);
+  const std::vector<Real> exact = box.sample(
+      [](double x, double y, double z) {
+        return std::cos(M_PI * x) * std::cos(2 * M_PI * y) + std::cos(M_PI * z);
+      });
+
+  Multigrid mg(box.comm, box.n, box.periodic, box.coeffs);
+  const Krylov::Operator A = [&mg](const Real *u, Real *v) { mg.apply(u, v); };
+  const Krylov::Operator M = [&mg](const Real *r, Real *z) {
+    mg.precondition(r, z);
+  };
+
+  Krylov krylov(box.comm, box.N, method);
+  const int iter = box.checkSolve(mg, exact,
+      [&](const Real *b, Real *x, double tol) {
+    const int it = krylov.solve(A, M, b, x, tol, 0, 100);
+    CUP_CHECK(krylov.lastResidual() <= tol * krylov.lastRHSNorm(),
+              "No convergence in %d iterations: residual %e, rhs %e.\n",
+              it, krylov.lastResidual(), krylov.lastRHSNorm());
+    return it;
+  });
+  CUP_CHECK(iter < 30, "Too many iterations: %d.\n", iter);
+  return true;
+}
+
+/*
+ * Solve with `Solver` on a 32^3 grid with zero-gradient boundaries, split
+ * along x only (slabs) or along x and y (pencils), stretched along y or not,
+ * and return the zero-mean local solution. The rest are the default options
+ * of -useSolver pcg: fft preconditioner, CG on uniform grids.
+ */
+template <typename Solver>
+static std::vector<Real> solveSimulation(const bool pencils,
+                                         const bool stretched)
+{
+  int size, dims[2] = {0, 0};
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  if (pencils) MPI_Dims_create(size, 2, dims);
+  else { dims[0] = size; dims[1] = 1; }
+
+  std::vector<std::string> args = {"test", "-bpdx", "4", "-bpdy", "4",
+      "-bpdz", "4", "-nu", "0.001", "-useSolver", "pcg",
+      "-nprocsx", std::to_string(dims[0]), "-nprocsy", std::to_string(dims[1]),
+      "-nprocsz", "1", "-BC_x", "wall", "-BC_y", "wall", "-BC_z", "wall"};
+  if (stretched)
+    for (const char *a : {"-extentx", "1", "-extenty", "1", "-extentz", "1",
+                          "-mesh_density_y", "SinusoidalDensity",
+                          "-eta_y", "0.8"})
+      args.push_back(a);
+  std::vector<char *> argv;
+  for (std::string &a : args) argv.push_back(&a[0]);
+  argv.push_back(nullptr);
+  ArgumentParser parser((int)args.size(), argv.data());
+  Simulation S(MPI_COMM_WORLD, parser);
+  SimulationData &sim = S.sim;
+  sim.verbose = false;
+  sim.poissonTol = sizeof(Real) == 4 ? 1e-5 : 1e-10;
+  sim.poissonStats = SimulationData::PoissonStats();
+  Solver solver(sim);
+
+  for (const BlockInfo &info : sim.vInfo()) {
+    const size_t offset = solver._offset_ext(info);
+    for (int iz = 0; iz < FluidBlock::sizeZ; ++iz)
+    for (int iy = 0; iy < FluidBlock::sizeY; ++iy)
+    for (int ix = 0; ix < FluidBlock::sizeX; ++ix) {
+      Real x[3], h[3];
+      info.pos(x, ix, iy, iz);
+      info.spacing(h, ix, iy, iz);
+      solver.data[solver._dest(offset, iz, iy, ix)] = h[0] * h[1] * h[2]
+          * (std::cos(M_PI * x[0]) * std::cos(2 * M_PI * x[1])
+             + std::cos(M_PI * x[2]));
+    }
+  }
+  // zero mean, which PoissonSolverMultigrid does not enforce itself
+  double mean = 0;
+  for (size_t i = 0; i < solver.data_size; ++i) mean += solver.data[i];
+  MPI_Allreduce(MPI_IN_PLACE, &mean, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  mean /= (double)size * solver.data_size;
+  for (size_t i = 0; i < solver.data_size; ++i) solver.data[i] -= mean;
+
+  solver.solve();
+  CUP_CHECK(sim.poissonStats.solves == 1
+            && sim.poissonStats.lastResidual <= sim.poissonTol,
+            "No convergence in %d iterations: relative residual %e.\n",
+            sim.poissonStats.maxIterations, sim.poissonStats.lastResidual);
+
+  std::vector<Real> out(solver.data, solver.data + solver.data_size);
+  mean = 0;
+  for (const Real v : out) mean += v;
+  MPI_Allreduce(MPI_IN_PLACE, &mean, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  mean /= (double)size * out.size();
+  for (Real &v : out) v -= mean;
+  return out;
+}
+
+// PoissonSolverKrylov with its defaults against PoissonSolverMultigrid, which
+// solves the same system.
+static bool testPoissonSolverKrylov(const bool pencils, const bool stretched)
+{
+  const std::vector<Real> krylov =
+      solveSimulation<PoissonSolverKrylov>(pencils, stretched);
+  const std::vector<Real> mg =
+      solveSimulation<PoissonSolverMultigrid>(pencils, stretched);
+  double err[2] = {0, 0};
+  for (size_t i = 0; i < mg.size(); ++i) {
+    err[0] = std::max(err[0], (double)std::fabs(krylov[i] - mg[i]));
+    err[1] = std::max(err[1], (double)std::fabs(mg[i]));
+  }
+  MPI_Allreduce(MPI_IN_PLACE, err, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  const double tol = sizeof(Real) == 4 ? 1e-2 : 1e-6;
+  CUP_CHECK(err[0] <= tol * err[1], "PoissonSolverKrylov differs by %e.\n",
+            err[0] / err[1]);
+  return true;
+}
+
+static bool testCG() { return testKrylov(Krylov::CG, false); }
+static bool testBiCGStab() { return testKrylov(Krylov::BiCGStab, false); }
+static bool testBiCGStabStretched() { return testKrylov(Krylov::BiCGStab, true); }
+static bool testSolverSlabs() { return testPoissonSolverKrylov(false, false); }
+static bool testSolverPencils() { return testPoissonSolverKrylov(true, false); }
+// pcg falls back to BiCGStab
+static bool testSolverStretched() { return testPoissonSolverKrylov(false, true); }
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testCG);
+  CUP_RUN_TEST(testBiCGStab);
+  CUP_RUN_TEST(testBiCGStabStretched);
+  CUP_RUN_TEST(testSolverSlabs);
+  CUP_RUN_TEST(testSolverPencils);
+  CUP_RUN_TEST(testSolverStretched);
+
+  tests::finalize_mpi();
+}
@@ -0,0 +1,46 @@
+#include "PoissonTestUtils.h"
+#include "../../source/poisson/Multigrid.h"
+
+#include <cmath>
+#include <cstdlib>
+
+using namespace cubismup3d;
+
+// Solve A x = A x_exact for a smooth x_exact on a box of 16^3 cells per rank,
+// with uniform or stretched cells along x, and compare with x_exact.
+static bool testMultigrid(const bool periodic, const bool stretched)
+{
+  const tests::PoissonBox box(periodic, stretched ? 0 : -1, 0.5, 2);
+  const std::vector<Real> exact = box.sample(
+      [](double x, double y, double z) {
+        return std::cos(2 * M_PI * x) * std::cos(2 * M_PI * y)
+             + std::cos(2 * M_PI * z);
+      });
+
+  Multigrid mg(box.comm, box.n, box.periodic, box.coeffs);
+  // Multigrid solves in place and keeps the last solution as initial guess.
+  box.checkSolve(mg, exact, [&](const Real *b, Real *x, double tol) {
+    std::copy(b, b + box.N, x);
+    const int cycles = mg.solve(x, tol, 0, 50);
+    CUP_CHECK(mg.lastResidual() <= tol * mg.lastRHSNorm(),
+              "No convergence in %d cycles: residual %e, rhs %e.\n",
+              cycles, mg.lastResidual(), mg.lastRHSNorm());
+    return cycles;
+  });
+  return true;
+}
+
+static bool testPeriodic() { return testMultigrid(true, false); }
+static bool testNeumann() { return testMultigrid(false, false); }
+static bool testStretched() { return testMultigrid(false, true); }
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testPeriodic);
+  CUP_RUN_TEST(testNeumann);
+  CUP_RUN_TEST(testStretched);
+
+  tests::finalize_mpi();
+}
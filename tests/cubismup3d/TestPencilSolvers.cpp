@@ -0,0 +1,145 @@
+#include "Utils.h"
+#include "../../source/Simulation.h"
+#include "../../source/poisson/PoissonSolverMixed.h"
+#include "../../source/poisson/PoissonSolverMixedPencil.h"
+#include "../../source/poisson/PoissonSolverUnbounded.h"
+#include "../../source/poisson/PoissonSolverUnboundedPencil.h"
+
+#include <Cubism/ArgumentParser.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cubism;
+using namespace cubismup3d;
+
+static constexpr int BPD = 4;  // Blocks per direction.
+
+/*
+ * Simulation with the BCs `bc` (x, y, z) on all ranks, split along x only
+ * (slabs) or along x and y (pencils).
+ */
+static std::unique_ptr<Simulation> makeSimulation(const char *bc[3],
+                                                  const bool pencils)
+{
+  int size, dims[2] = {0, 0};
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  if (pencils) MPI_Dims_create(size, 2, dims);
+  else { dims[0] = size; dims[1] = 1; }
+
+  std::vector<std::string> args = {"test",
+      "-bpdx", std::to_string(BPD), "-bpdy", std::to_string(BPD),
+      "-bpdz", std::to_string(BPD), "-nu", "0.001",
+      "-nprocsx", std::to_string(dims[0]), "-nprocsy", std::to_string(dims[1]),
+      "-nprocsz", "1", "-BC_x", bc[0], "-BC_y", bc[1], "-BC_z", bc[2]};
+  std::vector<char *> argv;
+  for (std::string &a : args) argv.push_back(&a[0]);
+  argv.push_back(nullptr);
+  ArgumentParser parser((int)args.size(), argv.data());
+  return std::make_unique<Simulation>(MPI_COMM_WORLD, parser);
+}
+
+/*
+ * Solve with `Solver` for a smooth right-hand side and return the solution on
+ * the whole grid, x fastest, on all ranks.
+ */
+template <typename Solver>
+static std::vector<double> solve(const char *bc[3], const bool pencils)
+{
+  std::unique_ptr<Simulation> S = makeSimulation(bc, pencils);
+  SimulationData &sim = S->sim;
+  sim.verbose = false;
+  Solver solver(sim);
+
+  const std::vector<BlockInfo> &vInfo = sim.vInfo();
+  const int N = BPD * FluidBlock::sizeX;
+  solver.reset();
+  for (const BlockInfo &info : vInfo) {
+    const size_t offset = solver._offset_ext(info);
+    for (int iz = 0; iz < FluidBlock::sizeZ; ++iz)
+    for (int iy = 0; iy < FluidBlock::sizeY; ++iy)
+    for (int ix = 0; ix < FluidBlock::sizeX; ++ix) {
+      Real x[3], h[3];
+      info.pos(x, ix, iy, iz);
+      info.spacing(h, ix, iy, iz);
+      solver.data[solver._dest(offset, iz, iy, ix)] = h[0] * h[1] * h[2]
+          * (std::cos(M_PI * x[0]) * std::cos(2 * M_PI * x[1])
+             + std::cos(M_PI * x[2]));
+    }
+  }
+  solver.solve();
+
+  std::vector<double> out((size_t)N * N * N, 0.0);
+  for (const BlockInfo &info : vInfo) {
+    const size_t offset = solver._offset_ext(info);
+    for (int iz = 0; iz < FluidBlock::sizeZ; ++iz)
+    for (int iy = 0; iy < FluidBlock::sizeY; ++iy)
+    for (int ix = 0; ix < FluidBlock::sizeX; ++ix) {
+      const size_t gx = info.index[0] * FluidBlock::sizeX + ix;
+      const size_t gy = info.index[1] * FluidBlock::sizeY + iy;
+      const size_t gz = info.index[2] * FluidBlock::sizeZ + iz;
+      out[gx + N * (gy + N * gz)] = solver.data[solver._dest(offset, iz, iy, ix)];
+    }
+  }
+  MPI_Allreduce(MPI_IN_PLACE, out.data(), (int)out.size(), MPI_DOUBLE,
+                MPI_SUM, MPI_COMM_WORLD);
+  return out;
+}
+
+/* Max difference of the two solutions up to a constant, relative to `a`. */
+static double difference(const std::vector<double> &a,
+                         const std::vector<double> &b)
+{
+  double mean = 0, diff = 0, norm = 0;
+  for (size_t i = 0; i < a.size(); ++i) mean += a[i] - b[i];
+  mean /= (double)a.size();
+  for (size_t i = 0; i < a.size(); ++i) {
+    diff = std::max(diff, std::fabs(a[i] - b[i] - mean));
+    norm = std::max(norm, std::fabs(a[i]));
+  }
+  return diff / norm;
+}
+
+static const double tol = sizeof(Real) == 4 ? 1e-4 : 1e-9;
+
+/* Cosine/Fourier transforms on pencils and on slabs. */
+static bool testMixedPencil()
+{
+  const char *cases[][3] = {
+    {"wall", "wall", "wall"},
+    {"periodic", "wall", "periodic"},
+    {"periodic", "periodic", "periodic"},
+  };
+  for (const auto &bc : cases) {
+    const std::vector<double> slabs = solve<PoissonSolverMixed>(bc, false);
+    const std::vector<double> pencils = solve<PoissonSolverMixedPencil>(bc, true);
+    const double err = difference(slabs, pencils);
+    CUP_CHECK(err < tol, "MixedPencil differs by %e for BCs %s %s %s.\n",
+              err, bc[0], bc[1], bc[2]);
+  }
+  return true;
+}
+
+/* Free-space convolution on pencils and on slabs. */
+static bool testUnboundedPencil()
+{
+  const char *bc[3] = {"freespace", "freespace", "freespace"};
+  const std::vector<double> slabs = solve<PoissonSolverUnbounded>(bc, false);
+  const std::vector<double> pencils = solve<PoissonSolverUnboundedPencil>(bc, true);
+  const double err = difference(slabs, pencils);
+  CUP_CHECK(err < tol, "UnboundedPencil differs by %e.\n", err);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testMixedPencil);
+  CUP_RUN_TEST(testUnboundedPencil);
+
+  tests::finalize_mpi();
+}
@@ -0,0 +1,88 @@
+#include "Utils.h"
+#include "../../source/poisson/PencilTranspose.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace cubismup3d;
+
+// Z-pencils -> Y-pencils -> X-pencils and back on a 2D grid of ranks, with
+// uneven chunks, padding and complex (2-tuple) elements.
+bool testPencilTranspose()
+{
+  int size, dims[2] = {0, 0}, periods[2] = {0, 0}, coords[2];
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  MPI_Dims_create(size, 2, dims);
+  MPI_Comm cart, rowComm, colComm;
+  MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, false, &cart);
+  MPI_Cart_get(cart, 2, dims, periods, coords);
+  const int keepY[2] = {0, 1}, keepX[2] = {1, 0};
+  MPI_Cart_sub(cart, keepY, &rowComm);
+  MPI_Cart_sub(cart, keepX, &colComm);
+
+  const int N[3] = {5 * dims[0], 3 * dims[1] + 1, 7}, pad[2] = {3, 2};
+  const auto xCounts = PencilTranspose::split(N[0], dims[0]);
+  const auto yCounts = PencilTranspose::split(N[1], dims[1]);
+  const auto zCounts = PencilTranspose::split(N[2], dims[1]);
+  const auto yyCounts = PencilTranspose::split(N[1] + pad[1], dims[0]);
+  int start[3] = {0, 0, 0}, yyStart = 0;
+  for (int i = 0; i < coords[0]; ++i) start[0] += xCounts[i];
+  for (int i = 0; i < coords[1]; ++i) start[1] += yCounts[i];
+  for (int i = 0; i < coords[1]; ++i) start[2] += zCounts[i];
+  for (int i = 0; i < coords[0]; ++i) yyStart += yyCounts[i];
+  const int nx = xCounts[coords[0]], ny = yCounts[coords[1]];
+  const int nz = zCounts[coords[1]], nyy = yyCounts[coords[0]];
+  const auto value = [](int x, int y, int z) { return x + 100. * y + 1e4 * z; };
+
+  PencilTranspose ZY(rowComm, nx, yCounts, N[1] + pad[1], zCounts, 2);
+  PencilTranspose YX(colComm, nz, xCounts, N[0] + pad[0], yyCounts, 2);
+  std::vector<Real> Z(ZY.sizeABC()), Y(ZY.sizeCAB()), X(YX.sizeCAB());
+  CUP_CHECK(YX.sizeABC() == Y.size(), "Layout sizes do not match.\n");
+  for (int ix = 0; ix < nx; ++ix)
+  for (int iy = 0; iy < ny; ++iy)
+  for (int iz = 0; iz < N[2]; ++iz) {
+    const size_t i = 2 * (((size_t)ix * ny + iy) * N[2] + iz);
+    Z[i] = value(start[0] + ix, start[1] + iy, iz);
+    Z[i + 1] = -Z[i];
+  }
+  const std::vector<Real> Z0 = Z;
+
+  ZY.forward(Z.data(), Y.data());
+  for (int iz = 0; iz < nz; ++iz)
+  for (int ix = 0; ix < nx; ++ix)
+  for (int iy = 0; iy < N[1] + pad[1]; ++iy) {
+    const size_t i = 2 * (((size_t)iz * nx + ix) * (N[1] + pad[1]) + iy);
+    const Real v = iy < N[1] ? value(start[0] + ix, iy, start[2] + iz) : 0;
+    CUP_CHECK(Y[i] == v && Y[i + 1] == -v, "Wrong Y-pencil value %f.\n", Y[i]);
+  }
+
+  YX.forward(Y.data(), X.data());
+  for (int iy = 0; iy < nyy; ++iy)
+  for (int iz = 0; iz < nz; ++iz)
+  for (int ix = 0; ix < N[0] + pad[0]; ++ix) {
+    const size_t i = 2 * (((size_t)iy * nz + iz) * (N[0] + pad[0]) + ix);
+    const int y = yyStart + iy;
+    const Real v = ix < N[0] && y < N[1] ? value(ix, y, start[2] + iz) : 0;
+    CUP_CHECK(X[i] == v && X[i + 1] == -v, "Wrong X-pencil value %f.\n", X[i]);
+  }
+
+  std::fill(Y.begin(), Y.end(), 0);
+  std::fill(Z.begin(), Z.end(), 0);
+  YX.backward(X.data(), Y.data());
+  ZY.backward(Y.data(), Z.data());
+  CUP_CHECK(Z == Z0, "Backward transposes do not restore the input.\n");
+
+  MPI_Comm_free(&rowComm);
+  MPI_Comm_free(&colComm);
+  MPI_Comm_free(&cart);
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testPencilTranspose);
+
+  tests::finalize_mpi();
+}
@@ -0,0 +1,53 @@
+#include "Utils.h"
+#include "../../source/utils/ReductionRegistry.h"
+
+#include <cstdlib>
+
+using namespace cubismup3d;
+
+bool testReductionRegistry()
+{
+  int rank, size;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  ReductionRegistry reductions(MPI_COMM_WORLD);
+
+  // Values are copied on enqueue, overwriting them afterwards has no effect.
+  double sums[2] = {(double)rank, 1.0};
+  double maxRank = rank;
+  double result[3] = {0, 0, 0};
+  int order = 0, sumOrder = -1, maxOrder = -1;
+  reductions.enqueue(sums, 2, MPI_SUM, [&](const double *x) {
+    result[0] = x[0];
+    result[1] = x[1];
+    sumOrder = order++;
+  });
+  reductions.enqueue(&maxRank, 1, MPI_MAX, [&](const double *x) {
+    result[2] = x[0];
+    maxOrder = order++;
+  });
+  sums[0] = maxRank = -1;
+  reductions.flush();
+  CUP_CHECK(order == 0, "Callbacks must not run before wait().\n");
+
+  // Blocking reduction completes the posted ones too.
+  double count = 1;
+  reductions.reduce(&count, 1, MPI_SUM);
+  CUP_CHECK(reductions.empty(), "Reductions still pending.\n");
+  CUP_CHECK(sumOrder == 0 && maxOrder == 1, "Callbacks run out of order.\n");
+  CUP_CHECK(result[0] == 0.5 * size * (size - 1) && result[1] == size,
+            "Wrong sums %f %f\n", result[0], result[1]);
+  CUP_CHECK(result[2] == size - 1, "Wrong max %f\n", result[2]);
+  CUP_CHECK(count == size, "Wrong blocking sum %f\n", count);
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  tests::init_mpi(&argc, &argv);
+
+  CUP_RUN_TEST(testReductionRegistry);
+
+  tests::finalize_mpi();
+}